@@ -0,0 +1,120 @@
+#include "benchmark.h"
+
+#include "core/array.h"
+#include "core/small_array.h"
+#include "maths/vector.h"
+
+using namespace srph;
+
+#define ITERATIONS (1 << 14)
+
+static uint64_t allocations = 0;
+
+template<class T>
+struct counting_allocator_t : std::allocator<T> {
+    template<class S>
+    struct rebind {
+        using other = counting_allocator_t<S>;
+    };
+
+    counting_allocator_t() = default;
+
+    template<class S>
+    counting_allocator_t(const counting_allocator_t<S> &){}
+
+    T * allocate(size_t n){
+        allocations++;
+        return std::allocator<T>::allocate(n);
+    }
+};
+
+static void print_allocations(){
+    printf("%-40s %12.2f\n", "  allocations", allocations / (double) (benchmark::repeats * ITERATIONS));
+}
+
+// srph_array reallocates exactly when its capacity changes
+static void count_capacity(const srph_array * a, uint32_t * capacity){
+    if (a->capacity != *capacity){
+        allocations++;
+        *capacity = a->capacity;
+    }
+}
+
+// fills an array with n elements and empties it again, reporting the allocations of one fill
+template<size_t N>
+static void fill(const char * name, uint32_t n){
+    char label[64];
+    vec3 x = { 1.0, 2.0, 3.0 };
+
+    allocations = 0;
+    snprintf(label, sizeof(label), "srph_array fill %u", n);
+    benchmark::run(label, ITERATIONS, [&](uint32_t){
+        srph_array a;
+        srph_array_create(&a, sizeof(vec3));
+        uint32_t capacity = 0;
+        count_capacity(&a, &capacity);
+
+        for (uint32_t i = 0; i < n; i++){
+            *(vec3 *) srph_array_push_back(&a) = x;
+            count_capacity(&a, &capacity);
+        }
+
+        benchmark::keep(a);
+        srph_array_destroy(&a);
+    });
+    print_allocations();
+
+    allocations = 0;
+    snprintf(label, sizeof(label), "%s fill %u", name, n);
+    benchmark::run(label, ITERATIONS, [&](uint32_t){
+        small_array_t<vec3, N, counting_allocator_t<vec3>> a;
+        for (uint32_t i = 0; i < n; i++){
+            a.push_back(x);
+        }
+
+        benchmark::keep(a);
+    });
+    print_allocations();
+}
+
+// pushes and pops repeatedly across a power of two, as a contact list refilled every tick does
+static void oscillate(uint32_t n){
+    vec3 x = { 1.0, 2.0, 3.0 };
+
+    srph_array a;
+    srph_array_create(&a, sizeof(vec3));
+    for (uint32_t i = 0; i < n; i++){
+        *(vec3 *) srph_array_push_back(&a) = x;
+    }
+
+    allocations = 0;
+    uint32_t capacity = a.capacity;
+    benchmark::run("srph_array push pop", ITERATIONS, [&](uint32_t){
+        *(vec3 *) srph_array_push_back(&a) = x;
+        count_capacity(&a, &capacity);
+        srph_array_pop_back(&a, NULL);
+        count_capacity(&a, &capacity);
+    });
+    print_allocations();
+    srph_array_destroy(&a);
+
+    small_array_t<vec3, 0, counting_allocator_t<vec3>> b;
+    for (uint32_t i = 0; i < n; i++){
+        b.push_back(x);
+    }
+
+    allocations = 0;
+    benchmark::run("small_array push pop", ITERATIONS, [&](uint32_t){
+        b.push_back(x);
+        b.pop_back();
+    });
+    print_allocations();
+}
+
+void benchmark_array(){
+    // contact lists rarely hold more than a handful of points, and sdf samples are capped at 1024
+    fill<8>("small_array<8>", 4);
+    fill<8>("small_array<8>", 8);
+    fill<0>("small_array", 1024);
+    oscillate(8);
+}
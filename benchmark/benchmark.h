@@ -0,0 +1,63 @@
+#ifndef SERAPHIM_BENCHMARK_H
+#define SERAPHIM_BENCHMARK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <chrono>
+
+// each suite prints one line per case, so runs can be diffed before and after a change
+void benchmark_array();
+void benchmark_cone();
+void benchmark_load();
+void benchmark_matrix();
+void benchmark_patch();
+void benchmark_set();
+void benchmark_solver();
+void benchmark_sparse();
+void benchmark_stack();
+
+namespace srph { namespace benchmark {
+    // times over which each case is run
+    constexpr uint32_t repeats = 5;
+
+    // stops the optimiser from discarding a result that is never read
+    template<class T>
+    inline void keep(const T & x){
+        asm volatile("" : : "g"(&x) : "memory");
+    }
+
+    // time taken by one call of f
+    template<class F>
+    double time(F f){
+        auto begin = std::chrono::steady_clock::now();
+        f();
+        auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(end - begin).count();
+    }
+
+    inline void report(const char * name, double ns){
+        printf("%-40s %12.2f ns\n", name, ns);
+    }
+
+    // runs f over n iterations a few times and reports the mean time of one iteration
+    // in the fastest run, which is the least disturbed by the rest of the machine
+    template<class F>
+    double run(const char * name, uint32_t n, F f){
+        double ns = 0.0;
+        for (uint32_t r = 0; r < repeats; r++){
+            double t = time([n, &f](){
+                for (uint32_t i = 0; i < n; i++){
+                    f(i);
+                }
+            }) / n;
+            ns = r == 0 ? t : std::min(ns, t);
+        }
+
+        report(name, ns);
+        return ns;
+    }
+}}
+
+#endif
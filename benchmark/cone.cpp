@@ -0,0 +1,154 @@
+#include "benchmark.h"
+
+#include <math.h>
+
+#include <vector>
+
+#include "scene.h"
+
+#include "core/constant.h"
+
+using namespace srph;
+
+// the compute shader's settings
+#define IMAGE_SIZE 256
+#define WORK_GROUP_SIZE 32
+#define MAX_STEPS 128
+#define CONE_TILE_SIZE 8
+#define CONE_LEVELS 2
+
+// the eye of the default camera, looking along z
+static const vec3 eye = { 0.0, 2.0, -10.0 };
+
+static vec3 ray_direction(double x, double y){
+    vec3 d = { x / IMAGE_SIZE * 2.0 - 1.0, 1.0 - y / IMAGE_SIZE * 2.0, 1.0 };
+    srph_vec3_normalise(&d, &d);
+    return d;
+}
+
+// as conecast in comp.glsl, the largest distance along which the cone through pixels lo
+// to hi is clear of the scene. the cpu has exact distances where the shader's cones only
+// see resident patches, so these are the most that seeding can save
+static double conecast(scene_t * s, double lox, double loy, double hix, double hiy, double t){
+    vec3 d = ray_direction((lox + hix) / 2, (loy + hiy) / 2);
+
+    vec3 corners[4] = {
+        ray_direction(lox, loy), ray_direction(hix, loy),
+        ray_direction(hix, hiy), ray_direction(lox, hiy)
+    };
+
+    double k = 0.0;
+    for (auto & corner : corners){
+        double c = srph_vec3_dot(&d, &corner);
+        k = std::max(k, sqrt(std::max(1.0 - c * c, 0.0)) / c);
+    }
+
+    for (uint32_t steps = 0; steps < MAX_STEPS && t < constant::rho; steps++){
+        vec3 x;
+        srph_vec3_scale(&x, &d, t);
+        srph_vec3_add(&x, &x, &eye);
+
+        uint32_t shape;
+        double step = (scene_phi(s, &x, &shape) - t * k) / (1.0 + k);
+        if (step < constant::epsilon){
+            break;
+        }
+        t += step;
+    }
+
+    return std::min(t, constant::rho);
+}
+
+// as seed_distance in comp.glsl, the start distance of every pixel in a work group
+static void seed(scene_t * s, uint32_t gx, uint32_t gy, std::vector<double> * starts){
+    std::vector<double> cones(WORK_GROUP_SIZE * WORK_GROUP_SIZE, 0.0);
+
+    for (uint32_t level = 0; level < CONE_LEVELS; level++){
+        uint32_t tile = std::max(CONE_TILE_SIZE >> level, 1);
+        std::vector<double> parents = cones;
+
+        for (uint32_t y = 0; y < WORK_GROUP_SIZE; y += tile){
+            for (uint32_t x = 0; x < WORK_GROUP_SIZE; x += tile){
+                uint32_t px = x / (tile * 2) * (tile * 2);
+                uint32_t py = y / (tile * 2) * (tile * 2);
+                double t = level > 0 ? parents[px + py * WORK_GROUP_SIZE] : 0.0;
+
+                cones[x + y * WORK_GROUP_SIZE] = conecast(
+                    s, gx + x, gy + y, gx + x + tile - 1, gy + y + tile - 1, t
+                );
+            }
+        }
+    }
+
+    uint32_t tile = std::max(CONE_TILE_SIZE >> (CONE_LEVELS - 1), 1);
+    for (uint32_t y = 0; y < WORK_GROUP_SIZE; y++){
+        for (uint32_t x = 0; x < WORK_GROUP_SIZE; x++){
+            (*starts)[gx + x + (gy + y) * IMAGE_SIZE] = cones[x / tile * tile + y / tile * tile * WORK_GROUP_SIZE];
+        }
+    }
+}
+
+// marches every pixel of one frame from its start distance, returning the total steps
+static uint64_t render(scene_t * s, const std::vector<double> & starts, std::vector<double> * distances){
+    uint64_t total = 0;
+    for (uint32_t y = 0; y < IMAGE_SIZE; y++){
+        for (uint32_t x = 0; x < IMAGE_SIZE; x++){
+            vec3 d = ray_direction(x, y);
+            uint32_t steps, shape;
+            (*distances)[x + y * IMAGE_SIZE] = scene_raycast(s, &eye, &d, starts[x + y * IMAGE_SIZE], &steps, &shape);
+            total += steps;
+        }
+    }
+    return total;
+}
+
+void benchmark_cone(){
+    scene_t s;
+    scene_create(&s);
+
+    const double pixels = IMAGE_SIZE * IMAGE_SIZE;
+    std::vector<double> zeros(IMAGE_SIZE * IMAGE_SIZE, 0.0);
+    std::vector<double> starts(IMAGE_SIZE * IMAGE_SIZE, 0.0);
+    std::vector<double> unseeded(IMAGE_SIZE * IMAGE_SIZE);
+    std::vector<double> seeded(IMAGE_SIZE * IMAGE_SIZE);
+
+    uint64_t steps = 0;
+    s.evaluations = 0;
+    double ns = benchmark::time([&](){
+        steps = render(&s, zeros, &unseeded);
+    });
+    uint64_t evaluations = s.evaluations;
+
+    benchmark::report("unseeded frame", ns);
+    printf("%-40s %12.2f\n", "  ray steps per pixel", steps / pixels);
+    printf("%-40s %12.2f\n", "  phi per pixel", evaluations / pixels);
+
+    uint64_t cone_evaluations = 0;
+    s.evaluations = 0;
+    ns = benchmark::time([&](){
+        for (uint32_t gy = 0; gy < IMAGE_SIZE; gy += WORK_GROUP_SIZE){
+            for (uint32_t gx = 0; gx < IMAGE_SIZE; gx += WORK_GROUP_SIZE){
+                seed(&s, gx, gy, &starts);
+            }
+        }
+        cone_evaluations = s.evaluations;
+        steps = render(&s, starts, &seeded);
+    });
+    evaluations = s.evaluations;
+
+    // seeding must only move the start of each ray, not where it hits
+    double error = 0.0;
+    for (size_t i = 0; i < seeded.size(); i++){
+        if (unseeded[i] < constant::rho && seeded[i] < constant::rho){
+            error = std::max(error, std::abs(seeded[i] - unseeded[i]));
+        }
+    }
+
+    benchmark::report("seeded frame", ns);
+    printf("%-40s %12.2f\n", "  ray steps per pixel", steps / pixels);
+    printf("%-40s %12.2f\n", "  cone phi per pixel", cone_evaluations / pixels);
+    printf("%-40s %12.2f\n", "  phi per pixel", evaluations / pixels);
+    printf("%-40s %12.4f\n", "  largest hit distance change (m)", error);
+
+    scene_destroy(&s);
+}
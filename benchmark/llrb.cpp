@@ -1,4 +1,4 @@
-#include "core/set.h"
+#include "llrb.h"
 
 #include <assert.h>
 #include <stdio.h>
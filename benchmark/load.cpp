@@ -0,0 +1,112 @@
+#include "benchmark.h"
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "core/random.h"
+#include "core/scene.h"
+#include "maths/sdf/platonic.h"
+#include "maths/sdf/primitive.h"
+
+using namespace srph;
+
+#define SUBSTANCES 1000000
+
+// the loader's own budget for a scene of this size
+#define BUDGET_MS 1000.0
+
+// a scene of boxes and spheres scattered over the floor, written to a temporary file
+static void write_scene(srph_scene_writer * w, srph_random * random){
+    vec3 size = { 0.5, 0.5, 0.5 };
+    srph_sdf * sdfs[2] = { srph_sdf_sphere_create(0.5), srph_sdf_cuboid_create(&size) };
+    for (auto sdf : sdfs){
+        srph_scene_writer_add_sdf(w, sdf);
+        srph_sdf_destroy(sdf);
+    }
+
+    srph_material material = {};
+    material.density = 700.0;
+    material.restitution = 0.3;
+    material.static_friction = 0.2;
+    material.dynamic_friction = 0.1;
+    for (uint32_t i = 0; i < 4; i++){
+        material.colour = { 0.2 * i, 0.8, 0.8 - 0.2 * i };
+        srph_scene_writer_add_material(w, &material);
+    }
+
+    w->substances.resize(SUBSTANCES);
+    for (auto & s : w->substances){
+        s = {};
+        s.sdf = srph_random_u32(random) % w->sdfs.size();
+        s.material = srph_random_u32(random) % w->materials.size();
+        s.is_uniform = true;
+
+        s.position[0] = srph_random_f64_range(random, -500.0, 500.0);
+        s.position[1] = srph_random_f64_range(random, 0.5, 10.0);
+        s.position[2] = srph_random_f64_range(random, -500.0, 500.0);
+        s.rotation[3] = 1.0;
+    }
+}
+
+static bool save(const srph_scene_writer * w, char * path){
+    int fd = mkstemp(path);
+    if (fd < 0){
+        return false;
+    }
+    close(fd);
+    return srph_scene_writer_save(w, path);
+}
+
+static void release(std::vector<srph_sdf *> * sdfs, std::vector<std::shared_ptr<substance_t>> * substances){
+    substances->clear();
+    for (auto sdf : *sdfs){
+        srph_sdf_destroy(sdf);
+    }
+    sdfs->clear();
+}
+
+// the cpu side of srph_load_scene, up to handing the substances to the subsystems
+void benchmark_load(){
+    srph_random random;
+    srph_random_default_seed(&random);
+
+    srph_scene_writer w;
+    write_scene(&w, &random);
+
+    char path[] = "/tmp/seraphim_benchmark_XXXXXX";
+    if (!save(&w, path)){
+        printf("Error: Failed to write scene %s\n", path);
+        return;
+    }
+
+    std::vector<srph_sdf *> sdfs;
+    std::vector<std::shared_ptr<substance_t>> substances;
+
+    bool is_loaded = true;
+    double ns = 0.0;
+    for (uint32_t r = 0; r < benchmark::repeats; r++){
+        double t = benchmark::time([&](){
+            is_loaded &= srph_scene_read_substances(path, &sdfs, &substances);
+        });
+        ns = r == 0 ? t : std::min(ns, t);
+
+        is_loaded &= substances.size() == SUBSTANCES;
+        release(&sdfs, &substances);
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "read %u substances", SUBSTANCES);
+    benchmark::report(label, ns);
+    printf("%-40s %12s\n", "  within budget", ns / 1e6 <= BUDGET_MS ? "yes" : "no");
+    printf("%-40s %12s\n", "  loaded", is_loaded ? "yes" : "no");
+
+    // a substance pointing past the sdf table is rejected before anything is created
+    w.substances.back().sdf = w.sdfs.size();
+    srph_scene_writer_save(&w, path);
+    bool is_rejected = !srph_scene_read_substances(path, &sdfs, &substances) && sdfs.empty() && substances.empty();
+    printf("%-40s %12s\n", "  rejects missing sdf", is_rejected ? "yes" : "no");
+
+    unlink(path);
+    is_rejected = !srph_scene_read_substances(path, &sdfs, &substances) && sdfs.empty() && substances.empty();
+    printf("%-40s %12s\n", "  rejects missing file", is_rejected ? "yes" : "no");
+}
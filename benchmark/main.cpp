@@ -0,0 +1,36 @@
+#include "benchmark.h"
+
+#include <string.h>
+
+static const struct {
+    const char * name;
+    void (*run)();
+} suites[] = {
+    { "array", benchmark_array },
+    { "cone", benchmark_cone },
+    { "load", benchmark_load },
+    { "matrix", benchmark_matrix },
+    { "patch", benchmark_patch },
+    { "set", benchmark_set },
+    { "solver", benchmark_solver },
+    { "sparse", benchmark_sparse },
+    { "stack", benchmark_stack },
+};
+
+// runs every suite, or only the ones named on the command line
+int main(int argc, char ** argv){
+    for (auto & suite : suites){
+        bool is_selected = argc == 1;
+        for (int i = 1; i < argc; i++){
+            is_selected |= strcmp(argv[i], suite.name) == 0;
+        }
+
+        if (is_selected){
+            printf("%s\n", suite.name);
+            suite.run();
+            printf("\n");
+        }
+    }
+
+    return 0;
+}
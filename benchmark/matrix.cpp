@@ -0,0 +1,95 @@
+#include "benchmark.h"
+
+#include "core/random.h"
+#include "maths/matrix.h"
+
+using namespace srph;
+
+#define ITERATIONS (1 << 20)
+
+// inputs are cycled through so that nothing is folded into a constant
+#define INPUTS 1024
+
+template<class T, int M, int N>
+static void fill(srph_random * random, std::vector<matrix_t<T, M, N>> * xs){
+    xs->resize(INPUTS);
+    for (auto & x : *xs){
+        for (int i = 0; i < M * N; i++){
+            x[i] = static_cast<T>(srph_random_f64_range(random, -1.0, 1.0));
+        }
+
+        // keep square matrices well away from singular
+        if (M == N){
+            for (int i = 0; i < M; i++){
+                x[i * M + i] += static_cast<T>(4);
+            }
+        }
+    }
+}
+
+void benchmark_matrix(){
+    srph_random random;
+    srph_random_default_seed(&random);
+
+    std::vector<f32mat4_t> f32mat4s;
+    std::vector<f32vec4_t> f32vec4s;
+    std::vector<mat3_t> mat3s;
+    std::vector<mat4_t> mat4s;
+    std::vector<vec3_t> vec3s;
+    fill(&random, &f32mat4s);
+    fill(&random, &f32vec4s);
+    fill(&random, &mat3s);
+    fill(&random, &mat4s);
+    fill(&random, &vec3s);
+
+    auto a = [](uint32_t i){ return i % INPUTS; };
+    auto b = [](uint32_t i){ return (i * 7 + 1) % INPUTS; };
+
+    // the generic template is picked over the sse overloads by naming its arguments
+    benchmark::run("f32mat4 * f32mat4 (generic)", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::multiply<float, float, 4, 4, 4>(f32mat4s[a(i)], f32mat4s[b(i)]));
+    });
+    benchmark::run("f32mat4 * f32mat4", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(f32mat4s[a(i)] * f32mat4s[b(i)]);
+    });
+
+    benchmark::run("f32mat4 * f32vec4 (generic)", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::multiply<float, float, 4, 4, 1>(f32mat4s[a(i)], f32vec4s[b(i)]));
+    });
+    benchmark::run("f32mat4 * f32vec4", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(f32mat4s[a(i)] * f32vec4s[b(i)]);
+    });
+
+    benchmark::run("f32mat4 transpose (generic)", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::transpose<float, 4, 4>(f32mat4s[a(i)]));
+    });
+    benchmark::run("f32mat4 transpose", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::transpose(f32mat4s[a(i)]));
+    });
+
+    benchmark::run("f32vec4 dot (generic)", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(vec::dot<float, float, 4, 1>(f32vec4s[a(i)], f32vec4s[b(i)]));
+    });
+    benchmark::run("f32vec4 dot", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(vec::dot(f32vec4s[a(i)], f32vec4s[b(i)]));
+    });
+
+    benchmark::run("vec3 cross", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(vec::cross(vec3s[a(i)], vec3s[b(i)]));
+    });
+    benchmark::run("mat3 * mat3", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat3s[a(i)] * mat3s[b(i)]);
+    });
+    benchmark::run("mat3 * vec3", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat3s[a(i)] * vec3s[b(i)]);
+    });
+    benchmark::run("mat3 inverse", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::inverse(mat3s[a(i)]));
+    });
+    benchmark::run("mat4 * mat4", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat4s[a(i)] * mat4s[b(i)]);
+    });
+    benchmark::run("mat4 inverse", ITERATIONS, [&](uint32_t i){
+        benchmark::keep(mat::inverse(mat4s[a(i)]));
+    });
+}
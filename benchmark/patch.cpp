@@ -0,0 +1,209 @@
+#include "benchmark.h"
+
+#include <math.h>
+
+#include <set>
+#include <vector>
+
+#include "scene.h"
+
+#include "core/constant.h"
+
+using namespace srph;
+
+// the renderer's settings
+#define NUMBER_OF_CALLS 2048
+#define NUMBER_OF_PATCHES 1000000
+
+// the camera orbits the origin, looking inwards, as in seraphim_t::benchmark
+#define IMAGE_SIZE 128
+#define FRAMES 60
+#define ORBITS 2
+#define RADIUS 8.0
+#define HEIGHT 2.0
+
+// the patch pool, as find_patch in comp.glsl and handle_requests in the renderer see it
+typedef struct pool_t {
+    uint32_t ways;
+    std::vector<uint32_t> hashes;
+    std::vector<uint32_t> ages;
+    std::vector<bool> resident;
+
+    uint64_t requests;
+    uint64_t evictions;
+} pool_t;
+
+typedef struct call_t {
+    bool is_valid;
+    uint32_t index;
+    uint32_t hash;
+} call_t;
+
+static void pool_create(pool_t * p, uint32_t size, uint32_t ways){
+    p->ways = ways;
+    p->hashes.assign(size, 0);
+    p->ages.assign(size, 0);
+    p->resident.assign(size, false);
+    p->requests = 0;
+    p->evictions = 0;
+}
+
+// the slot holding hash, stamping it as used this frame, or ~0 with the least recently
+// used slot of its bucket as the victim
+static uint32_t pool_find(pool_t * p, uint32_t hash, uint32_t frame, uint32_t * victim){
+    uint32_t bucket = hash % (p->hashes.size() / p->ways) * p->ways;
+    uint32_t oldest = ~0u;
+    *victim = bucket;
+
+    for (uint32_t slot = bucket; slot < bucket + p->ways; slot++){
+        if (p->hashes[slot] == hash){
+            p->ages[slot] = frame;
+            return slot;
+        }
+
+        if (p->ages[slot] < oldest){
+            oldest = p->ages[slot];
+            *victim = slot;
+        }
+    }
+
+    return ~0u;
+}
+
+// looks up every patch one frame hits, then answers its calls
+static void pool_frame(pool_t * p, const std::vector<uint32_t> & hashes, uint32_t frame){
+    std::vector<call_t> calls(NUMBER_OF_CALLS, { false, 0, 0 });
+
+    for (auto hash : hashes){
+        uint32_t victim;
+        if (pool_find(p, hash, frame, &victim) == ~0u){
+            calls[hash % NUMBER_OF_CALLS] = { true, victim, hash };
+        }
+    }
+
+    std::set<uint32_t> filled;
+    for (auto & call : calls){
+        if (call.is_valid){
+            p->requests++;
+
+            if (filled.insert(call.index).second){
+                p->evictions += p->resident[call.index];
+                p->resident[call.index] = true;
+                p->hashes[call.index] = call.hash;
+                p->ages[call.index] = frame;
+            }
+        }
+    }
+}
+
+// as patch_hash in comp.glsl, wrapping as glsl integers do
+static uint32_t patch_hash(const vec3 * x, uint32_t shape, int32_t order){
+    const uint32_t p1[3] = { 904601, 12582917, 6291469 };
+    const uint32_t p2[3] = { 25165843, 50331653, 904573 };
+    const uint32_t p3[3] = { 100663319, 904577, 3145739 };
+
+    double size = constant::epsilon * order * 2;
+    uint32_t hash = (shape * p3[0] + p3[1]) ^ (static_cast<uint32_t>(order) * p3[1] + p3[2]);
+    for (int i = 0; i < 3; i++){
+        hash ^= static_cast<uint32_t>(static_cast<int32_t>(floor(x->raw[i] / size))) * p1[i] + p2[i];
+    }
+    return hash;
+}
+
+// the patch that each pixel's ray hits, for every frame of the orbit
+static std::vector<std::vector<uint32_t>> trace(scene_t * s){
+    std::vector<std::vector<uint32_t>> frames(FRAMES);
+
+    for (uint32_t f = 0; f < FRAMES; f++){
+        double angle = 2.0 * constant::pi * f / FRAMES;
+        vec3 eye = { RADIUS * cos(angle), HEIGHT, RADIUS * sin(angle) };
+
+        // basis looking from the eye to the origin
+        vec3_t forward = vec::view(eye) * -1.0;
+        forward *= 1.0 / vec::length(forward);
+        vec3_t right = vec::cross(vec3_t(0.0, 1.0, 0.0), forward);
+        right *= 1.0 / vec::length(right);
+        vec3_t up = vec::cross(forward, right);
+
+        for (uint32_t y = 0; y < IMAGE_SIZE; y++){
+            for (uint32_t x = 0; x < IMAGE_SIZE; x++){
+                double u = x / (double) IMAGE_SIZE * 2.0 - 1.0;
+                double v = 1.0 - y / (double) IMAGE_SIZE * 2.0;
+
+                vec3 d = vec::view(forward + right * u + up * v);
+                srph_vec3_normalise(&d, &d);
+
+                uint32_t steps, shape;
+                double t = scene_raycast(s, &eye, &d, 0.0, &steps, &shape);
+                if (t >= constant::rho){
+                    continue;
+                }
+
+                // as expected_order in comp.glsl, patches are coarser further away and out
+                // towards the edges of the image
+                int32_t order = 10 + static_cast<int32_t>(t + 2.0 * sqrt(u * u + v * v));
+
+                vec3 hit;
+                srph_vec3_scale(&hit, &d, t);
+                srph_vec3_add(&hit, &hit, &eye);
+                srph_vec3_subtract(&hit, &hit, &s->positions[shape]);
+
+                frames[f].push_back(patch_hash(&hit, s->sdfs[shape]->id, order));
+            }
+        }
+    }
+
+    return frames;
+}
+
+// replays the patch lookups of an orbit around the default scene through pools of either
+// one slot per hash, as before the pool became set associative, or buckets of four
+static void churn(const std::vector<std::vector<uint32_t>> & frames, uint32_t size){
+    for (uint32_t ways : { 1, 4 }){
+        pool_t p;
+        pool_create(&p, size, ways);
+
+        // the first orbit fills the pool, and the second is what churn remains
+        uint32_t frame = 1;
+        uint64_t first_requests = 0;
+        uint64_t first_evictions = 0;
+        for (uint32_t orbit = 0; orbit < ORBITS; orbit++){
+            for (auto & hashes : frames){
+                pool_frame(&p, hashes, frame++);
+            }
+
+            if (orbit == 0){
+                first_requests = p.requests;
+                first_evictions = p.evictions;
+            }
+        }
+
+        printf("%u slot pool, %u way\n", size, ways);
+        printf("%-40s %12llu\n", "  first orbit requests", static_cast<unsigned long long>(first_requests));
+        printf("%-40s %12llu\n", "  first orbit evictions", static_cast<unsigned long long>(first_evictions));
+        printf("%-40s %12llu\n", "  later orbit requests", static_cast<unsigned long long>(p.requests - first_requests));
+        printf("%-40s %12llu\n", "  later orbit evictions", static_cast<unsigned long long>(p.evictions - first_evictions));
+    }
+}
+
+void benchmark_patch(){
+    scene_t s;
+    scene_create(&s);
+
+    auto frames = trace(&s);
+
+    std::set<uint32_t> unique;
+    size_t lookups = 0;
+    for (auto & hashes : frames){
+        unique.insert(hashes.begin(), hashes.end());
+        lookups += hashes.size();
+    }
+    printf("%-40s %12zu\n", "  lookups per orbit", lookups);
+    printf("%-40s %12zu\n", "  patches per orbit", unique.size());
+
+    // the renderer's pool, and one small enough for the orbit to overflow it
+    churn(frames, NUMBER_OF_PATCHES);
+    churn(frames, 1 << 14);
+
+    scene_destroy(&s);
+}
@@ -0,0 +1,72 @@
+#include "scene.h"
+
+#include <algorithm>
+
+#include "core/constant.h"
+#include "maths/sdf/platonic.h"
+#include "maths/sdf/primitive.h"
+
+using namespace srph;
+
+// the compute shader's step limit
+#define MAX_STEPS 128
+
+static void scene_add(scene_t * s, srph_sdf * sdf, double x, double y, double z){
+    s->sdfs.push_back(sdf);
+    s->positions.push_back({ x, y, z });
+}
+
+void scene_create(scene_t * s){
+    vec3 floor_size;
+    srph_vec3_fill(&floor_size, 100.0);
+    vec3 box_size = { 0.5, 1.0, 0.5 };
+
+    s->evaluations = 0;
+    scene_add(s, srph_sdf_cuboid_create(&floor_size), 0.0, -100.0, 0.0);
+    scene_add(s, srph_sdf_sphere_create(1.0), -2.0, 1.0, 0.0);
+    scene_add(s, srph_sdf_torus_create(1.0, 0.25), 2.0, 0.25, 2.0);
+    scene_add(s, srph_sdf_cuboid_create(&box_size), 0.0, 1.0, 6.0);
+    scene_add(s, srph_sdf_octahedron_create(1.0), 4.0, 1.0, 12.0);
+    scene_add(s, srph_sdf_sphere_create(2.0), -6.0, 2.0, 20.0);
+}
+
+void scene_destroy(scene_t * s){
+    for (auto sdf : s->sdfs){
+        srph_sdf_destroy(sdf);
+    }
+
+    s->sdfs.clear();
+    s->positions.clear();
+}
+
+double scene_phi(scene_t * s, const vec3 * x, uint32_t * shape){
+    s->evaluations++;
+
+    double p = constant::rho;
+    for (uint32_t i = 0; i < s->sdfs.size(); i++){
+        vec3 local;
+        srph_vec3_subtract(&local, x, &s->positions[i]);
+
+        double phi = srph_sdf_phi(s->sdfs[i], &local);
+        if (phi < p){
+            p = phi;
+            *shape = i;
+        }
+    }
+    return p;
+}
+
+double scene_raycast(scene_t * s, const vec3 * x, const vec3 * d, double t, uint32_t * steps, uint32_t * shape){
+    for (*steps = 0; *steps < MAX_STEPS && t < constant::rho; (*steps)++){
+        vec3 y;
+        srph_vec3_scale(&y, d, t);
+        srph_vec3_add(&y, &y, x);
+
+        double p = scene_phi(s, &y, shape);
+        if (p < constant::epsilon){
+            return t;
+        }
+        t += p;
+    }
+    return constant::rho;
+}
@@ -0,0 +1,28 @@
+#ifndef SERAPHIM_BENCHMARK_SCENE_H
+#define SERAPHIM_BENCHMARK_SCENE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "maths/sdf/sdf.h"
+
+// a few shapes on the floor of the default scene, for replaying the compute shader on the cpu
+typedef struct scene_t {
+    std::vector<srph_sdf *> sdfs;
+    std::vector<vec3> positions;
+
+    // phi calls since creation, each of which is a step of some ray or cone
+    uint64_t evaluations;
+} scene_t;
+
+void scene_create(scene_t * s);
+void scene_destroy(scene_t * s);
+
+// smallest distance from x to any shape, and the index of that shape
+double scene_phi(scene_t * s, const vec3 * x, uint32_t * shape);
+
+// distance along d from x to the first hit, or rho if the ray misses or runs out of steps
+double scene_raycast(scene_t * s, const vec3 * x, const vec3 * d, double t, uint32_t * steps, uint32_t * shape);
+
+#endif
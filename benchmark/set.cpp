@@ -0,0 +1,139 @@
+#include "benchmark.h"
+
+#include <set>
+#include <vector>
+
+#include "core/random.h"
+#include "core/set.h"
+
+#include "llrb.h"
+
+using namespace srph;
+
+// the set set_t replaced, behind the interface the benchmark uses
+struct llrb_t {
+    srph_set s;
+
+    static int compare(const void * a, const void * b){
+        uint64_t x = *static_cast<const uint64_t *>(a);
+        uint64_t y = *static_cast<const uint64_t *>(b);
+        return x < y ? -1 : x > y;
+    }
+
+    llrb_t(){
+        srph_set_create(&s, compare, sizeof(uint64_t));
+    }
+
+    ~llrb_t(){
+        srph_set_destroy(&s);
+    }
+
+    void insert(uint64_t x){
+        srph_set_insert(&s, &x);
+    }
+
+    const void * find(uint64_t x){
+        return srph_set_find(&s, &x);
+    }
+
+    const void * end() const {
+        return nullptr;
+    }
+};
+
+template<class S, class F>
+static void for_each(S * s, F f){
+    for (auto x : *s){
+        f(x);
+    }
+}
+
+// the old set had no iterator, so its nodes are walked in order directly
+template<class F>
+static void walk(srph_set_node * n, F & f){
+    if (n != NULL){
+        walk(n->children[0], f);
+        f(*reinterpret_cast<uint64_t *>(n->data));
+        walk(n->children[1], f);
+    }
+}
+
+template<class F>
+static void for_each(llrb_t * s, F f){
+    walk(s->s.root, f);
+}
+
+template<class S>
+static void insert_find_iterate(const char * name, const std::vector<uint64_t> & xs, S * s){
+    char label[64];
+    size_t n = xs.size();
+
+    double ns = benchmark::time([&](){
+        for (auto x : xs){
+            s->insert(x);
+        }
+    });
+    snprintf(label, sizeof(label), "%s insert %zu", name, n);
+    benchmark::report(label, ns / n);
+
+    uint64_t found = 0;
+    ns = benchmark::time([&](){
+        for (auto x : xs){
+            found += s->find(x) != s->end();
+        }
+    });
+    benchmark::keep(found);
+    snprintf(label, sizeof(label), "%s find %zu", name, n);
+    benchmark::report(label, ns / n);
+
+    uint64_t sum = 0;
+    ns = benchmark::time([&](){
+        for_each(s, [&sum](uint64_t x){
+            sum += x;
+        });
+    });
+    benchmark::keep(sum);
+    snprintf(label, sizeof(label), "%s iterate %zu", name, n);
+    benchmark::report(label, ns / n);
+}
+
+void benchmark_set(){
+    srph_random random;
+    srph_random_default_seed(&random);
+
+    for (size_t n = 1000; n <= 10000000; n *= 10){
+        std::vector<uint64_t> xs(n);
+        for (auto & x : xs){
+            x = (static_cast<uint64_t>(srph_random_u32(&random)) << 32) | srph_random_u32(&random);
+        }
+
+        {
+            llrb_t s;
+            insert_find_iterate("llrb", xs, &s);
+        }
+
+        // for reference, the standard library's own red-black tree
+        {
+            std::set<uint64_t> s;
+            insert_find_iterate("std::set", xs, &s);
+        }
+
+        {
+            set_t<uint64_t> s;
+            insert_find_iterate("set_t", xs, &s);
+        }
+
+        std::vector<uint64_t> sorted(xs);
+        std::sort(sorted.begin(), sorted.end());
+
+        set_t<uint64_t> s;
+        double ns = benchmark::time([&](){
+            s.assign_sorted(sorted.data(), sorted.size());
+        });
+
+        char label[64];
+        snprintf(label, sizeof(label), "set_t assign sorted %zu", n);
+        benchmark::report(label, ns / n);
+        printf("\n");
+    }
+}
@@ -0,0 +1,95 @@
+#include "benchmark.h"
+
+#include "core/constant.h"
+#include "core/scheduler.h"
+#include "physics/lattice.h"
+#include "physics/solver.h"
+
+using namespace srph;
+
+#define STEPS 50
+
+// the physics thread's settings
+#define SUBSTEPS 32
+#define ITERATIONS 1
+
+// largest error in length of any distance constraint, as a measure of convergence
+static double stretch(srph_lattice * l, double spacing){
+    double s = 0.0;
+    for (uint32_t j = 0; j < l->height; j++){
+        for (uint32_t i = 0; i < l->width; i++){
+            vec3 * x = &srph_lattice_vertex(l, i, j)->x;
+            if (i + 1 < l->width){
+                s = std::max(s, std::abs(srph_vec3_distance(x, &srph_lattice_vertex(l, i + 1, j)->x) - spacing));
+            }
+            if (j + 1 < l->height){
+                s = std::max(s, std::abs(srph_vec3_distance(x, &srph_lattice_vertex(l, i, j + 1)->x) - spacing));
+            }
+        }
+    }
+    return s;
+}
+
+// steps a lattice hanging from its first row, which starts out horizontal and swings down
+static void swing(
+    const char * name, uint32_t width, uint32_t height, bool has_floor, 
+    uint32_t substeps = SUBSTEPS, uint32_t iterations = ITERATIONS
+){
+    const double spacing = 0.01;
+    vec3 x = { 0.0, 0.0, 0.0 };
+    vec3 u = { spacing, 0.0, 0.0 };
+    vec3 v = { 0.0, 0.0, spacing };
+
+    srph_lattice l;
+    srph_lattice_create(&l, width, height, &x, &u, &v, INFINITY);
+    for (uint32_t i = 0; i < width; i++){
+        srph_lattice_pin(&l, i, 0);
+    }
+
+    if (has_floor){
+        vec3 n = { 0.0, 1.0, 0.0 };
+        srph_lattice_add_plane(&l, &n, -0.5 * height * spacing);
+    }
+
+    srph_solver s;
+    srph_solver_create(&s, substeps, iterations);
+    srph_solver_add_array(&s, l.constraints.data(), l.constraints.size());
+
+    vec3 gravity = { 0.0, -constant::gravity, 0.0 };
+    double ns = benchmark::time([&](){
+        for (uint32_t i = 0; i < STEPS; i++){
+            srph_solver_step(&s, constant::sigma, &gravity);
+        }
+    });
+
+    uint32_t colours = 0;
+    for (uint32_t k = 0; k + 1 < s._colour_offsets.size(); k++){
+        colours += s._colour_offsets[k + 1] > s._colour_offsets[k];
+    }
+
+    char label[64];
+    snprintf(label, sizeof(label), "%s step", name);
+    benchmark::report(label, ns / STEPS);
+    printf("%-40s %12zu\n", "  constraints", s.constraints.size());
+    printf("%-40s %12u\n", "  colours", colours);
+    printf("%-40s %12.4f\n", "  largest stretch (mm)", stretch(&l, spacing) * 1000.0);
+
+    srph_solver_destroy(&s);
+    srph_lattice_destroy(&l);
+}
+
+void benchmark_solver(){
+    // the few substeps of several iterations each that the physics thread used to take
+    swing("cloth 4 x 4", 224, 224, false, 4, 4);
+
+    // 100k distance constraints each
+    swing("chain", 1, 100001, false);
+    swing("cloth", 224, 224, false);
+    swing("cloth on floor", 224, 224, true);
+
+    scheduler::initialise();
+    swing("chain parallel", 1, 100001, false);
+    swing("cloth parallel", 224, 224, false);
+    swing("cloth on floor parallel", 224, 224, true);
+    scheduler::terminate();
+}
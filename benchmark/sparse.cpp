@@ -0,0 +1,220 @@
+#include "benchmark.h"
+
+#include <math.h>
+
+#include <vector>
+
+#include "core/random.h"
+#include "maths/matrix.h"
+#include "maths/sparse.h"
+
+using namespace srph;
+
+// nodes along each side of the grid, each with three degrees of freedom
+#define SIDE 16
+#define NODES (SIDE * SIDE * SIDE)
+#define ROWS (NODES * 3)
+
+#define MULTIPLIES 64
+#define TOLERANCE 1e-8
+#define MAX_ITERATIONS 1000
+
+// the stiffness of the spring between a node and its neighbour along each axis, as
+// implicit integration of a block of springs sees it
+typedef struct grid_t {
+    mat3_t springs[NODES][3];
+    double mass;
+} grid_t;
+
+static uint32_t node(uint32_t x, uint32_t y, uint32_t z){
+    return x + (y + z * SIDE) * SIDE;
+}
+
+static uint32_t neighbour(uint32_t i, uint32_t axis){
+    uint32_t x = i % SIDE;
+    uint32_t y = i / SIDE % SIDE;
+    uint32_t z = i / (SIDE * SIDE);
+    uint32_t c[3] = { x, y, z };
+
+    if (++c[axis] >= SIDE){
+        return ~0u;
+    }
+    return node(c[0], c[1], c[2]);
+}
+
+// springs along random directions, so that every block is dense
+static void grid_create(grid_t * g, srph_random * random){
+    g->mass = 1.0;
+
+    for (uint32_t i = 0; i < NODES; i++){
+        for (uint32_t axis = 0; axis < 3; axis++){
+            vec3_t d(
+                srph_random_f64_range(random, -1.0, 1.0),
+                srph_random_f64_range(random, -1.0, 1.0),
+                srph_random_f64_range(random, -1.0, 1.0)
+            );
+            d *= 1.0 / std::max(vec::length(d), 1e-3);
+
+            double k = srph_random_f64_range(random, 10.0, 100.0);
+            for (uint32_t r = 0; r < 3; r++){
+                for (uint32_t c = 0; c < 3; c++){
+                    g->springs[i][axis].set(r, c, k * d[r] * d[c] + (r == c ? 0.1 * k : 0.0));
+                }
+            }
+        }
+    }
+}
+
+// y = Ax straight from the springs, to check the sparse formats against
+static void grid_multiply(const grid_t * g, double * y, const double * x){
+    for (uint32_t i = 0; i < ROWS; i++){
+        y[i] = g->mass * x[i];
+    }
+
+    for (uint32_t i = 0; i < NODES; i++){
+        for (uint32_t axis = 0; axis < 3; axis++){
+            uint32_t j = neighbour(i, axis);
+            if (j == ~0u){
+                continue;
+            }
+
+            vec3_t dx(x[i * 3] - x[j * 3], x[i * 3 + 1] - x[j * 3 + 1], x[i * 3 + 2] - x[j * 3 + 2]);
+            vec3_t f = g->springs[i][axis] * dx;
+            for (uint32_t r = 0; r < 3; r++){
+                y[i * 3 + r] += f[r];
+                y[j * 3 + r] -= f[r];
+            }
+        }
+    }
+}
+
+static void add(srph_matrix * m, uint32_t i, uint32_t j, const mat3_t & block, double sign){
+    for (uint32_t r = 0; r < 3; r++){
+        for (uint32_t c = 0; c < 3; c++){
+            uint32_t x = j * 3 + c;
+            uint32_t y = i * 3 + r;
+
+            // the symmetric matrix holds one of each mirrored pair
+            if (i != j || x <= y){
+                srph_matrix_set(m, x, y, srph_matrix_at(m, x, y) + sign * block.get(r, c));
+            }
+        }
+    }
+}
+
+static void grid_assemble(const grid_t * g, srph_matrix * m){
+    srph_matrix_create_symmetric(m, ROWS);
+
+    mat3_t mass = mat3_t::identity() * g->mass;
+    for (uint32_t i = 0; i < NODES; i++){
+        add(m, i, i, mass, 1.0);
+    }
+
+    for (uint32_t i = 0; i < NODES; i++){
+        for (uint32_t axis = 0; axis < 3; axis++){
+            uint32_t j = neighbour(i, axis);
+            if (j == ~0u){
+                continue;
+            }
+
+            add(m, i, i, g->springs[i][axis], 1.0);
+            add(m, j, j, g->springs[i][axis], 1.0);
+            add(m, std::max(i, j), std::min(i, j), g->springs[i][axis], -1.0);
+        }
+    }
+}
+
+static double norm(const std::vector<double> & x){
+    double s = 0.0;
+    for (double xi : x){
+        s += xi * xi;
+    }
+    return sqrt(s);
+}
+
+// largest difference between a multiply and the springs' own
+static double multiply_error(const std::vector<double> & y, const std::vector<double> & expected){
+    double e = 0.0;
+    for (uint32_t i = 0; i < ROWS; i++){
+        e = std::max(e, std::abs(y[i] - expected[i]));
+    }
+    return e / norm(expected);
+}
+
+// solves for a known x from the b the springs give it, checking the residual against the
+// springs rather than the matrix the solver saw
+template<class F>
+static void solve(const char * name, const grid_t * g, const std::vector<double> & solution, const std::vector<double> & b, F f){
+    std::vector<double> x;
+    srph_pcg_result result = { 0, 0.0 };
+
+    double ns = 0.0;
+    for (uint32_t r = 0; r < benchmark::repeats; r++){
+        x.assign(ROWS, 0.0);
+        double t = benchmark::time([&](){
+            result = f(x.data());
+        });
+        ns = r == 0 ? t : std::min(ns, t);
+    }
+
+    std::vector<double> ax(ROWS);
+    grid_multiply(g, ax.data(), x.data());
+
+    std::vector<double> residual(ROWS);
+    std::vector<double> error(ROWS);
+    for (uint32_t i = 0; i < ROWS; i++){
+        residual[i] = b[i] - ax[i];
+        error[i] = x[i] - solution[i];
+    }
+
+    benchmark::report(name, ns);
+    printf("%-40s %12u\n", "  iterations", result.iterations);
+    printf("%-40s %12.3e\n", "  relative residual", norm(residual) / norm(b));
+    printf("%-40s %12.3e\n", "  relative error", norm(error) / norm(solution));
+}
+
+void benchmark_sparse(){
+    srph_random random;
+    srph_random_default_seed(&random);
+
+    static grid_t g;
+    grid_create(&g, &random);
+
+    srph_matrix m;
+    grid_assemble(&g, &m);
+
+    srph_csr csr;
+    srph_bsr bsr;
+    srph_csr_create(&csr, &m);
+    srph_bsr_create(&bsr, &m);
+    srph_matrix_destroy(&m);
+
+    std::vector<double> solution(ROWS);
+    for (auto & xi : solution){
+        xi = srph_random_f64_range(&random, -1.0, 1.0);
+    }
+
+    std::vector<double> b(ROWS);
+    grid_multiply(&g, b.data(), solution.data());
+
+    printf("%-40s %12u\n", "  rows", ROWS);
+    printf("%-40s %12zu\n", "  non-zeros", csr.values.size());
+
+    std::vector<double> y(ROWS);
+    benchmark::run("csr multiply", MULTIPLIES, [&](uint32_t i){
+        srph_csr_multiply(&csr, y.data(), solution.data());
+    });
+    printf("%-40s %12.3e\n", "  relative error", multiply_error(y, b));
+
+    benchmark::run("bsr multiply", MULTIPLIES, [&](uint32_t i){
+        srph_bsr_multiply(&bsr, y.data(), solution.data());
+    });
+    printf("%-40s %12.3e\n", "  relative error", multiply_error(y, b));
+
+    solve("csr jacobi pcg", &g, solution, b, [&](double * x){
+        return srph_csr_solve(&csr, x, b.data(), TOLERANCE, MAX_ITERATIONS);
+    });
+    solve("bsr block jacobi pcg", &g, solution, b, [&](double * x){
+        return srph_bsr_solve(&bsr, x, b.data(), TOLERANCE, MAX_ITERATIONS);
+    });
+}
@@ -0,0 +1,110 @@
+#include "benchmark.h"
+
+#include "maths/sdf/platonic.h"
+#include "physics/physics.h"
+
+using namespace srph;
+
+#define HEIGHT 20
+#define MAX_TICKS 6000
+
+// a stack is at rest once every box has been slower than this for a hundred ticks
+#define REST_SPEED 0.01
+#define REST_TICKS 100
+
+// and has collapsed once any box has strayed this far from its place in the stack
+#define COLLAPSE_DRIFT 0.25
+
+static bool is_resting(const std::vector<srph_matter> & boxes){
+    for (auto & b : boxes){
+        if (vec::length(b.v) > REST_SPEED || vec::length(b.omega) > REST_SPEED){
+            return false;
+        }
+    }
+    return true;
+}
+
+static double drift(const std::vector<srph_matter> & boxes){
+    double d = 0.0;
+    for (uint32_t i = 0; i < boxes.size(); i++){
+        d = std::max(d, vec::length(boxes[i].get_position() - vec3_t(0.0, 0.5 + i, 0.0)));
+    }
+    return d;
+}
+
+// ticks a stack of unit boxes on the floor of the default scene, checking that it comes to rest
+// and stays there rather than falling over
+void benchmark_stack(){
+    srph_material material;
+    material.static_friction = 0.2;
+    material.dynamic_friction = 0.1;
+    material.density = 700.0;
+    material.restitution = 0.3;
+    srph_vec3_fill(&material.colour, 1.0);
+
+    vec3 floor_size;
+    srph_vec3_fill(&floor_size, 100.0);
+    srph_sdf * floor_sdf = srph_sdf_cuboid_create(&floor_size);
+
+    vec3 box_size;
+    srph_vec3_fill(&box_size, 0.5);
+    srph_sdf * box_sdf = srph_sdf_cuboid_create(&box_size);
+
+    // boxes are stored first so that their addresses are fixed before registering
+    std::vector<srph_matter> boxes(HEIGHT);
+    for (uint32_t i = 0; i < HEIGHT; i++){
+        vec3 x = { 0.0, 0.5 + i, 0.0 };
+        srph_matter_init(&boxes[i], box_sdf, &material, &x, true);
+        boxes[i].omega = vec3_t();
+    }
+
+    vec3 x = { 0.0, -100.0, 0.0 };
+    srph_matter floor;
+    srph_matter_init(&floor, floor_sdf, &material, &x, true);
+
+    physics_t physics;
+    std::vector<srph_matter *> matters = { &floor };
+    for (auto & b : boxes){
+        matters.push_back(&b);
+    }
+    physics.register_matters(matters);
+
+    uint32_t ticks = 0;
+    uint32_t resting = 0;
+    double t = 0.0;
+    double rested = -1.0;
+    double ns = benchmark::time([&](){
+        for (; ticks < MAX_TICKS && drift(boxes) < COLLAPSE_DRIFT; ticks++){
+            t += physics.tick();
+            resting = is_resting(boxes) ? resting + 1 : 0;
+
+            if (resting == REST_TICKS && rested < 0.0){
+                rested = t;
+            }
+        }
+    });
+
+    double max_speed = 0.0;
+    for (auto & b : boxes){
+        max_speed = std::max(max_speed, vec::length(b.v));
+    }
+
+    const char * outcome = resting >= REST_TICKS ? "rested" : ticks < MAX_TICKS ? "collapsed" : "moving";
+
+    benchmark::report("20 box stack tick", ns / ticks);
+    printf("%-40s %12u\n", "  ticks", ticks);
+    printf("%-40s %12.3f\n", "  simulated seconds", t);
+    printf("%-40s %12.4f\n", "  largest drift (m)", drift(boxes));
+    printf("%-40s %12.4f\n", "  largest speed (m/s)", max_speed);
+    printf("%-40s %12.3f\n", "  first at rest (s)", rested);
+    printf("%-40s %12zu\n", "  contacts", physics.contact_solver.contacts.size());
+    printf("%-40s %12s\n", "  outcome", outcome);
+
+    physics.unregister_matters(matters);
+    for (auto & b : boxes){
+        srph_matter_destroy(&b);
+    }
+    srph_matter_destroy(&floor);
+    srph_sdf_destroy(box_sdf);
+    srph_sdf_destroy(floor_sdf);
+}
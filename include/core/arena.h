@@ -0,0 +1,64 @@
+#ifndef SERAPHIM_ARENA_H
+#define SERAPHIM_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct srph_arena_chunk {
+    struct srph_arena_chunk * next;
+    size_t size;
+    size_t used;
+    alignas(16) uint8_t data[];
+} srph_arena_chunk;
+
+typedef struct srph_arena {
+    srph_arena_chunk * _head;
+    size_t _chunk_size;
+    size_t _total_used;
+
+    // the most recent allocation, which can be grown in place
+    void * _last;
+} srph_arena;
+
+void srph_arena_create(srph_arena * a, size_t chunk_size);
+void srph_arena_destroy(srph_arena * a);
+
+void * srph_arena_alloc(srph_arena * a, size_t size);
+void * srph_arena_realloc(srph_arena * a, void * data, size_t old_size, size_t new_size);
+
+void srph_arena_reset(srph_arena * a);
+
+namespace srph {
+    // allocator adaptor so that typed containers can draw from an arena,
+    // deallocation is deferred until the arena is reset
+    template<class T>
+    struct arena_allocator_t {
+        typedef T value_type;
+
+        srph_arena * arena;
+
+        arena_allocator_t(srph_arena * arena) : arena(arena){}
+
+        template<class S>
+        arena_allocator_t(const arena_allocator_t<S> & a) : arena(a.arena){}
+
+        T * allocate(size_t n){
+            static_assert(alignof(T) <= 16, "Arena allocations are only 16 byte aligned");
+            return static_cast<T *>(srph_arena_alloc(arena, n * sizeof(T)));
+        }
+
+        void deallocate(T * data, size_t n){}
+    };
+
+    template<class S, class T>
+    bool operator==(const arena_allocator_t<S> & a, const arena_allocator_t<T> & b){
+        return a.arena == b.arena;
+    }
+
+    template<class S, class T>
+    bool operator!=(const arena_allocator_t<S> & a, const arena_allocator_t<T> & b){
+        return a.arena != b.arena;
+    }
+}
+
+#endif
@@ -3,6 +3,8 @@
 
 #include <stdint.h>
 
+#include "core/arena.h"
+
 typedef int (*srph_comparator)(const void *, const void*);
 
 typedef struct srph_array {
@@ -10,9 +12,11 @@ typedef struct srph_array {
     uint32_t capacity;
     uint32_t element_size;
     void * _data;
+    srph_arena * _arena;
 } srph_array;
 
 void srph_array_create(srph_array * a, uint32_t element_size);
+void srph_array_create_in(srph_array * a, uint32_t element_size, srph_arena * arena);
 void srph_array_destroy(srph_array * a);
 
 void * srph_array_push_back(srph_array * a);
@@ -39,7 +39,7 @@ namespace srph {
                 buffer_info.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
                 memory_property = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
             } else {
-                buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+                buffer_info.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
                 memory_property = static_cast<VkMemoryPropertyFlagBits>(VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
             }
 
@@ -132,6 +132,15 @@ namespace srph {
             vkCmdFillBuffer(command_buffer, buffer, 0, size, ~0);
         }
 
+        // copies part of the buffer back to be mapped, leaving it as it is
+        void record_read(VkCommandBuffer command_buffer, uint64_t offset, uint64_t count) const {
+            VkBufferCopy region;
+            region.srcOffset = sizeof(T) * offset;
+            region.dstOffset = sizeof(T) * offset;
+            region.size = sizeof(T) * count;
+            vkCmdCopyBuffer(command_buffer, buffer, staging_buffer->get_buffer(), 1, &region);
+        }
+
         VkWriteDescriptorSet get_write_descriptor_set(VkDescriptorSet descriptor_set) const {
             VkWriteDescriptorSet write_desc_set = {};
             write_desc_set.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -7,6 +7,7 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <vector>
 
 namespace srph {
     class command_buffer_t {
@@ -53,6 +54,10 @@ namespace srph {
         ~command_buffer_t();
 
         void submit(VkSemaphore wait_sema, VkSemaphore signal_sema, VkFence fence, VkPipelineStageFlags stage);
+        void submit(
+            const std::vector<VkSemaphore> & wait_semas, const std::vector<VkPipelineStageFlags> & stages,
+            VkSemaphore signal_sema, VkFence fence
+        );
     };
 
     class command_pool_t {
@@ -15,6 +15,9 @@ namespace srph { namespace constant {
 
     // largest distance
     constexpr double rho     = 2048;             // metres    
+
+    // acceleration due to gravity, along -y (metres per second squared)
+    constexpr double gravity = 9.8;
     
     constexpr double pi      = 3.14159265358979323;             
 }}
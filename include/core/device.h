@@ -16,16 +16,33 @@ namespace srph {
         uint32_t present_family;
         uint32_t compute_family;
 
+        // without a surface there is no present queue or swapchain, and any
+        // device that can run compute shaders will do, including software ones
+        bool is_headless;
+
+        // when not allowed, compute is submitted to the graphics family even if another has it
+        bool is_async_compute_allowed;
+
+        // optional features are enabled whenever the device supports them
+        VkPhysicalDeviceFeatures features;
+
         VkPhysicalDevice select_physical_device(VkInstance instance, VkSurfaceKHR surface) const;
         bool has_adequate_queue_families(VkPhysicalDevice physical_device, VkSurfaceKHR surface) const;
         bool is_suitable_device(VkPhysicalDevice physical_device, VkSurfaceKHR surface) const;
 
         VkDevice create_device(std::vector<const char *> enabled_validation_layers) const;
+        std::vector<const char *> get_device_extensions() const;
+        static int rank_device_type(VkPhysicalDeviceType type);
         bool device_has_extension(VkPhysicalDevice phys_device, const char * extension) const;
         void select_queue_families(VkSurfaceKHR surface);
+        void select_features();
 
     public:
-        device_t(VkInstance instance, VkSurfaceKHR surface, std::vector<const char *> enabled_validation_layers);
+        // pass VK_NULL_HANDLE as the surface to create a headless device
+        device_t(
+            VkInstance instance, VkSurfaceKHR surface, std::vector<const char *> enabled_validation_layers,
+            bool is_async_compute_allowed = true
+        );
         ~device_t();
 
         VkPhysicalDevice get_physical_device() const;
@@ -33,6 +50,11 @@ namespace srph {
         uint32_t get_graphics_family() const;
         uint32_t get_present_family() const;
         uint32_t get_compute_family() const;
+        bool get_is_headless() const;
+
+        // whether compute is submitted to a different queue family than graphics
+        bool has_async_compute() const;
+        const VkPhysicalDeviceFeatures & get_features() const;
     };
 }
 
@@ -0,0 +1,101 @@
+#ifndef SERAPHIM_SCENE_H
+#define SERAPHIM_SCENE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "metaphysics/matter.h"
+#include "metaphysics/substance.h"
+
+#define SRPH_SCENE_MAGIC 0x48505253u // "SRPH"
+#define SRPH_SCENE_VERSION 1u
+#define SRPH_SCENE_MAX_PARAMETERS 4
+#define SRPH_SCENE_INVALID_INDEX (~0u)
+
+// on disk layout: a header followed by three tables of fixed size records,
+// each starting on an eight byte boundary so they can be read in place
+typedef struct srph_scene_header {
+    uint32_t magic;
+    uint32_t version;
+
+    uint32_t num_sdfs;
+    uint32_t num_materials;
+    uint32_t num_substances;
+    uint32_t _padding;
+
+    uint64_t sdf_offset;
+    uint64_t material_offset;
+    uint64_t substance_offset;
+} srph_scene_header;
+
+typedef struct srph_scene_sdf {
+    uint32_t type;
+    uint32_t _padding;
+    double parameters[SRPH_SCENE_MAX_PARAMETERS];
+} srph_scene_sdf;
+
+typedef struct srph_scene_material {
+    double colour[3];
+    double density;
+    double restitution;
+    double static_friction;
+    double dynamic_friction;
+} srph_scene_material;
+
+typedef struct srph_scene_substance {
+    uint32_t sdf;
+    uint32_t material;
+    uint32_t is_uniform;
+    uint32_t _padding;
+
+    double position[3];
+    double rotation[4];
+    double v[3];
+    double omega[3];
+} srph_scene_substance;
+
+// accumulates records in memory until saved
+typedef struct srph_scene_writer {
+    std::vector<srph_scene_sdf> sdfs;
+    std::vector<srph_scene_material> materials;
+    std::vector<srph_scene_substance> substances;
+} srph_scene_writer;
+
+// read only view over a memory mapped scene file
+typedef struct srph_scene {
+    void * _map;
+    size_t _size;
+
+    const srph_scene_header * header;
+    const srph_scene_sdf * sdfs;
+    const srph_scene_material * materials;
+    const srph_scene_substance * substances;
+} srph_scene;
+
+// returns SRPH_SCENE_INVALID_INDEX for custom sdfs, which cannot be serialised
+uint32_t srph_scene_writer_add_sdf(srph_scene_writer * w, const srph_sdf * sdf);
+uint32_t srph_scene_writer_add_material(srph_scene_writer * w, const srph_material * material);
+void srph_scene_writer_add_substance(
+    srph_scene_writer * w, uint32_t sdf, uint32_t material, const srph_matter * matter
+);
+bool srph_scene_writer_save(const srph_scene_writer * w, const char * path);
+
+bool srph_scene_open(srph_scene * scene, const char * path);
+void srph_scene_close(srph_scene * scene);
+
+srph_sdf * srph_scene_sdf_create(const srph_scene_sdf * s);
+void srph_scene_material_read(const srph_scene_material * s, srph_material * material);
+void srph_scene_matter_init(
+    const srph_scene_substance * s, srph_sdf * sdf, const srph_material * material, srph_matter * m
+);
+
+// reads every substance of a scene file, appending them and the sdfs they share. returns
+// false, appending nothing, if the file cannot be read or refers to a missing record
+bool srph_scene_read_substances(
+    const char * path, std::vector<srph_sdf *> * sdfs, std::vector<std::shared_ptr<srph::substance_t>> * substances
+);
+
+#endif
@@ -78,6 +78,10 @@ namespace srph { namespace scheduler {
         return [is_repeatable](){ *is_repeatable = false; };
     }
 
+    // calls f(begin, end) over disjoint ranges covering [0, n), sharing the work 
+    // between the calling thread and the pool. runs inline if the pool is not running
+    void parallel_for(uint32_t n, const std::function<void(uint32_t, uint32_t)> & f);
+
     template<typename D, typename F, typename... Rest>
     auto schedule_after(const D & d, F && f, Rest &&... rest) -> std::future<decltype(f(rest...))> {
         return __private::schedule_task(clock_t::now() + d, nullptr, 0s, std::forward<F>(f), std::forward<Rest>(rest)...);
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 
+#include "core/slot_map.h"
 #include "physics/physics.h"
 #include "render/renderer.h"
 #include "ui/window.h"
@@ -33,27 +34,46 @@ namespace srph {
         VkInstance instance;
         VkSurfaceKHR surface;
 
-        u32vec2_t work_group_count;
-        u32vec2_t work_group_size;
+        u32vec2_t resolution;
      
         std::shared_ptr<camera_t> test_camera;      
 
-        std::set<std::shared_ptr<substance_t>> substances;
+        slot_map_t<std::shared_ptr<substance_t>> substances;
+
+        // sdfs created by loaded scenes, destroyed on cleanup
+        std::vector<srph_sdf *> sdfs;
 
         bool fps_monitor_quit;
         void monitor_fps();
         std::thread fps_monitor_thread;
         std::condition_variable fps_cv;
 
-        seraphim_t();
+        // headless engines have no window or surface and render offscreen
+        bool is_headless;
+
+        // without async compute, compute is submitted to the graphics queue, for comparison
+        seraphim_t(bool is_headless = false, bool is_async_compute_allowed = true);
 
         void run();
 
-        void annihilate(std::shared_ptr<substance_t> substance);
+        // renders a fixed number of frames along a scripted camera path, headless or in
+        // the window, reporting cpu and gpu time per frame and how long each queue idled
+        void benchmark(uint32_t frames);
+
+        void annihilate(handle_t substance);
     };
 }
 
-srph::substance_t * srph_create_substance(srph::seraphim_t * srph, srph_form * form, srph_matter * matter);
+srph::handle_t srph_create_substance(srph::seraphim_t * srph, srph_form * form, srph_matter * matter);
+srph::substance_t * srph_get_substance(srph::seraphim_t * srph, srph::handle_t substance);
+
+// batched spawning and despawning, taking each subsystem's lock once per batch.
+// handles may be NULL if the caller does not need them
+void srph_create_substances(
+    srph::seraphim_t * srph, srph_form * form, srph_matter * matters, uint32_t n, srph::handle_t * handles
+);
+void srph_annihilate_substances(srph::seraphim_t * srph, const srph::handle_t * handles, uint32_t n);
+bool srph_load_scene(srph::seraphim_t * srph, const char * path);
 
 void srph_cleanup(srph::seraphim_t * engine);
 
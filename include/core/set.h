@@ -3,30 +3,401 @@
 
 #include <stdint.h>
 
-typedef int (*srph_set_comparator)(const void *, const void *);
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <vector>
 
-typedef struct srph_set_node {
-    srph_set_node * children[2];
-    bool colour;
+namespace srph {
+    // ordered set stored as a b+ tree with nodes pooled in one contiguous
+    // vector. leaves hold the elements and are linked for range iteration,
+    // while each internal node stores the least element of each child
+    template<class T, class Compare = std::less<T>, uint32_t B = 32>
+    class set_t {
+    private:
+        static_assert(B >= 4, "Set nodes must have a branching factor of at least four");
 
-    char data[];
-} srph_set_node;
+        static constexpr uint32_t null_node = ~0u;
+        static constexpr uint32_t min_size = B / 2;
 
-typedef struct srph_set {
-    srph_set_node * root;
-    uint32_t element_size;
-    srph_set_comparator cmp;
-} srph_set;
+        struct node_t {
+            uint32_t size;
+            bool is_leaf;
 
+            // next leaf in order, or next free node in the pool
+            uint32_t next;
 
-void srph_set_create(srph_set * s, srph_set_comparator cmp, uint32_t element_size);
-void srph_set_destroy(srph_set * s);
+            T keys[B];
+            uint32_t children[B];
+        };
 
-void * srph_set_find(srph_set * s, void * key);
-bool srph_set_contains(srph_set * s, void * data);
-void srph_set_insert(srph_set * s, void * data);
+        std::vector<node_t> nodes;
+        uint32_t free_list;
+        uint32_t root;
+        size_t count;
+        Compare cmp;
 
-void srph_set_delete(srph_set * s, void * data);
+        bool equal(const T & a, const T & b) const {
+            return !cmp(a, b) && !cmp(b, a);
+        }
 
-#endif
+        uint32_t allocate(bool is_leaf){
+            uint32_t n = free_list;
+            if (n == null_node){
+                n = nodes.size();
+                nodes.emplace_back();
+            } else {
+                free_list = nodes[n].next;
+            }
+
+            nodes[n].size = 0;
+            nodes[n].is_leaf = is_leaf;
+            nodes[n].next = null_node;
+            return n;
+        }
+
+        void deallocate(uint32_t n){
+            nodes[n].next = free_list;
+            free_list = n;
+        }
+
+        uint32_t leaf_position(const node_t & node, const T & x) const {
+            return std::lower_bound(node.keys, node.keys + node.size, x, cmp) - node.keys;
+        }
+
+        // index of the last child whose least element is not greater than x
+        uint32_t child_position(const node_t & node, const T & x) const {
+            uint32_t i = std::upper_bound(node.keys + 1, node.keys + node.size, x, cmp) - node.keys;
+            return i - 1;
+        }
+
+        void insert_at(node_t & node, uint32_t i, const T & x, uint32_t child){
+            std::copy_backward(node.keys + i, node.keys + node.size, node.keys + node.size + 1);
+            node.keys[i] = x;
+
+            if (!node.is_leaf){
+                std::copy_backward(node.children + i, node.children + node.size, node.children + node.size + 1);
+                node.children[i] = child;
+            }
+
+            node.size++;
+        }
+
+        void erase_at(node_t & node, uint32_t i){
+            std::copy(node.keys + i + 1, node.keys + node.size, node.keys + i);
+            if (!node.is_leaf){
+                std::copy(node.children + i + 1, node.children + node.size, node.children + i);
+            }
+            node.size--;
+        }
+
+        // moves the upper half of node n into a new right sibling and returns it
+        uint32_t split(uint32_t n){
+            uint32_t r = allocate(nodes[n].is_leaf);
+            node_t & node = nodes[n];
+            node_t & right = nodes[r];
+
+            right.size = node.size - min_size;
+            std::copy(node.keys + min_size, node.keys + node.size, right.keys);
+            if (!node.is_leaf){
+                std::copy(node.children + min_size, node.children + node.size, right.children);
+            } else {
+                right.next = node.next;
+                node.next = r;
+            }
+
+            node.size = min_size;
+            return r;
+        }
+
+        // returns the new right sibling of n if it had to split, otherwise null
+        uint32_t insert(uint32_t n, const T & x, bool & is_new){
+            if (nodes[n].is_leaf){
+                uint32_t i = leaf_position(nodes[n], x);
+                if (i < nodes[n].size && equal(nodes[n].keys[i], x)){
+                    nodes[n].keys[i] = x;
+                    is_new = false;
+                    return null_node;
+                }
+
+                is_new = true;
+                uint32_t r = null_node;
+                if (nodes[n].size == B){
+                    r = split(n);
+                    if (i > min_size){
+                        insert_at(nodes[r], i - min_size, x, null_node);
+                        return r;
+                    }
+                }
+
+                insert_at(nodes[n], i, x, null_node);
+                return r;
+            }
+
+            uint32_t i = child_position(nodes[n], x);
+            uint32_t c = nodes[n].children[i];
+            uint32_t s = insert(c, x, is_new);
+            nodes[n].keys[i] = nodes[c].keys[0];
+
+            if (s == null_node){
+                return null_node;
+            }
+
+            uint32_t r = null_node;
+            uint32_t m = n;
+            i++;
+
+            if (nodes[n].size == B){
+                r = split(n);
+                if (i > min_size){
+                    m = r;
+                    i -= min_size;
+                }
+            }
+
+            insert_at(nodes[m], i, nodes[s].keys[0], s);
+            return r;
+        }
+
+        // restores the minimum size of child i of internal node n
+        void rebalance(uint32_t n, uint32_t i){
+            node_t & parent = nodes[n];
+            if (i + 1 == parent.size){
+                i--;
+            }
+
+            node_t & left = nodes[parent.children[i]];
+            node_t & right = nodes[parent.children[i + 1]];
+
+            if (left.size + right.size <= B){
+                // merge right into left
+                std::copy(right.keys, right.keys + right.size, left.keys + left.size);
+                if (!left.is_leaf){
+                    std::copy(right.children, right.children + right.size, left.children + left.size);
+                } else {
+                    left.next = right.next;
+                }
+                left.size += right.size;
+
+                deallocate(parent.children[i + 1]);
+                erase_at(parent, i + 1);
+
+            } else if (left.size < right.size){
+                // borrow the first entry of right
+                insert_at(left, left.size, right.keys[0], right.children[0]);
+                erase_at(right, 0);
+                parent.keys[i + 1] = right.keys[0];
+
+            } else {
+                // borrow the last entry of left
+                insert_at(right, 0, left.keys[left.size - 1], left.children[left.size - 1]);
+                erase_at(left, left.size - 1);
+                parent.keys[i + 1] = right.keys[0];
+            }
+        }
+
+        bool erase(uint32_t n, const T & x){
+            node_t & node = nodes[n];
+            if (node.is_leaf){
+                uint32_t i = leaf_position(node, x);
+                if (i == node.size || !equal(node.keys[i], x)){
+                    return false;
+                }
+
+                erase_at(node, i);
+                return true;
+            }
+
+            uint32_t i = child_position(node, x);
+            uint32_t c = node.children[i];
+            if (!erase(c, x)){
+                return false;
+            }
+
+            if (nodes[c].size > 0){
+                node.keys[i] = nodes[c].keys[0];
+            }
+
+            if (nodes[c].size < min_size){
+                rebalance(n, i);
+            }
+
+            return true;
+        }
+
+        uint32_t leftmost_leaf() const {
+            uint32_t n = root;
+            while (!nodes[n].is_leaf){
+                n = nodes[n].children[0];
+            }
+            return n;
+        }
 
+    public:
+        class iterator_t {
+        private:
+            const set_t * set;
+            uint32_t leaf;
+            uint32_t i;
+
+        public:
+            iterator_t(const set_t * set, uint32_t leaf, uint32_t i) : set(set), leaf(leaf), i(i){
+                // skip past the end of a leaf into its successor
+                while (this->leaf != null_node && this->i >= set->nodes[this->leaf].size){
+                    this->leaf = set->nodes[this->leaf].next;
+                    this->i = 0;
+                }
+            }
+
+            const T & operator*() const {
+                return set->nodes[leaf].keys[i];
+            }
+
+            const T * operator->() const {
+                return &set->nodes[leaf].keys[i];
+            }
+
+            iterator_t & operator++(){
+                *this = iterator_t(set, leaf, i + 1);
+                return *this;
+            }
+
+            bool operator==(const iterator_t & x) const {
+                return leaf == x.leaf && i == x.i;
+            }
+
+            bool operator!=(const iterator_t & x) const {
+                return !(*this == x);
+            }
+        };
+
+        // constructors
+        set_t(const Compare & cmp = Compare()) : cmp(cmp) {
+            clear();
+        }
+
+        // modifiers
+        void clear(){
+            nodes.clear();
+            free_list = null_node;
+            count = 0;
+            root = allocate(true);
+        }
+
+        // inserts x, replacing any equivalent element. returns true if x is new
+        bool insert(const T & x){
+            bool is_new;
+            uint32_t r = insert(root, x, is_new);
+
+            if (r != null_node){
+                uint32_t l = root;
+                root = allocate(false);
+                insert_at(nodes[root], 0, nodes[l].keys[0], l);
+                insert_at(nodes[root], 1, nodes[r].keys[0], r);
+            }
+
+            count += is_new;
+            return is_new;
+        }
+
+        bool erase(const T & x){
+            if (!erase(root, x)){
+                return false;
+            }
+
+            if (!nodes[root].is_leaf && nodes[root].size == 1){
+                uint32_t r = root;
+                root = nodes[r].children[0];
+                deallocate(r);
+            }
+
+            count--;
+            return true;
+        }
+
+        // replaces the contents with n elements that are sorted and unique
+        void assign_sorted(const T * xs, size_t n){
+            clear();
+            if (n == 0){
+                return;
+            }
+
+            // fill each level evenly, which leaves every node at least half full
+            std::vector<uint32_t> level;
+            size_t k = (n + B - 1) / B;
+            nodes.reserve(k * 2 + 1);
+
+            nodes[root].size = 0;
+            for (size_t j = 0, x = 0; j < k; j++){
+                uint32_t leaf = j == 0 ? root : allocate(true);
+                uint32_t size = n / k + (j < n % k);
+
+                std::copy(xs + x, xs + x + size, nodes[leaf].keys);
+                nodes[leaf].size = size;
+                x += size;
+
+                if (!level.empty()){
+                    nodes[level.back()].next = leaf;
+                }
+                level.push_back(leaf);
+            }
+
+            while (level.size() > 1){
+                std::vector<uint32_t> parents;
+                k = (level.size() + B - 1) / B;
+
+                for (size_t j = 0, x = 0; j < k; j++){
+                    uint32_t p = allocate(false);
+                    uint32_t size = level.size() / k + (j < level.size() % k);
+
+                    for (uint32_t c = 0; c < size; c++){
+                        insert_at(nodes[p], c, nodes[level[x + c]].keys[0], level[x + c]);
+                    }
+                    x += size;
+                    parents.push_back(p);
+                }
+
+                level = parents;
+            }
+
+            root = level[0];
+            count = n;
+        }
+
+        // accessors
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        iterator_t begin() const {
+            return iterator_t(this, leftmost_leaf(), 0);
+        }
+
+        iterator_t end() const {
+            return iterator_t(this, null_node, 0);
+        }
+
+        iterator_t lower_bound(const T & x) const {
+            uint32_t n = root;
+            while (!nodes[n].is_leaf){
+                n = nodes[n].children[child_position(nodes[n], x)];
+            }
+            return iterator_t(this, n, leaf_position(nodes[n], x));
+        }
+
+        iterator_t find(const T & x) const {
+            iterator_t it = lower_bound(x);
+            return it != end() && equal(*it, x) ? it : end();
+        }
+
+        bool contains(const T & x) const {
+            return find(x) != end();
+        }
+    };
+}
+
+#endif
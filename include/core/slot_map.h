@@ -0,0 +1,158 @@
+#ifndef SERAPHIM_SLOT_MAP_H
+#define SERAPHIM_SLOT_MAP_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+namespace srph {
+    // generational index. a handle stays valid until its element is erased,
+    // after which the slot may be reused under a new generation
+    struct handle_t {
+        uint32_t index;
+        uint32_t generation;
+
+        handle_t() : index(~0u), generation(0){}
+        handle_t(uint32_t index, uint32_t generation) : index(index), generation(generation){}
+
+        bool operator==(const handle_t & h) const {
+            return index == h.index && generation == h.generation;
+        }
+
+        bool operator!=(const handle_t & h) const {
+            return !(*this == h);
+        }
+    };
+
+    // values are packed densely for iteration and removed by swap and pop.
+    // slots map handles to dense positions and owners map back again
+    template<class T>
+    class slot_map_t {
+    private:
+        static constexpr uint32_t null_slot = ~0u;
+
+        struct slot_t {
+            uint32_t generation;
+
+            // dense position while occupied, next free slot otherwise
+            uint32_t index;
+        };
+
+        std::vector<slot_t> slots;
+        std::vector<T> values;
+        std::vector<uint32_t> owners;
+        uint32_t free_list;
+
+        const slot_t * lookup(handle_t h) const {
+            if (h.index >= slots.size() || slots[h.index].generation != h.generation){
+                return nullptr;
+            }
+            return &slots[h.index];
+        }
+
+    public:
+        slot_map_t() : free_list(null_slot){}
+
+        // modifiers
+        handle_t insert(T x){
+            uint32_t s = free_list;
+            if (s == null_slot){
+                s = slots.size();
+                slots.push_back({ 0, 0 });
+            } else {
+                free_list = slots[s].index;
+            }
+
+            slots[s].index = values.size();
+            values.push_back(std::move(x));
+            owners.push_back(s);
+
+            return handle_t(s, slots[s].generation);
+        }
+
+        // returns false if the handle is stale
+        bool erase(handle_t h){
+            if (lookup(h) == nullptr){
+                return false;
+            }
+
+            uint32_t i = slots[h.index].index;
+            uint32_t last = values.size() - 1;
+
+            if (i != last){
+                values[i] = std::move(values[last]);
+                owners[i] = owners[last];
+                slots[owners[i]].index = i;
+            }
+
+            values.pop_back();
+            owners.pop_back();
+
+            slots[h.index].generation++;
+            slots[h.index].index = free_list;
+            free_list = h.index;
+            return true;
+        }
+
+        void reserve(size_t n){
+            slots.reserve(n);
+            values.reserve(n);
+            owners.reserve(n);
+        }
+
+        void clear(){
+            for (uint32_t i = 0; i < owners.size(); i++){
+                uint32_t s = owners[i];
+                slots[s].generation++;
+                slots[s].index = free_list;
+                free_list = s;
+            }
+
+            values.clear();
+            owners.clear();
+        }
+
+        // accessors
+        T * get(handle_t h){
+            const slot_t * slot = lookup(h);
+            return slot == nullptr ? nullptr : &values[slot->index];
+        }
+
+        const T * get(handle_t h) const {
+            const slot_t * slot = lookup(h);
+            return slot == nullptr ? nullptr : &values[slot->index];
+        }
+
+        bool contains(handle_t h) const {
+            return lookup(h) != nullptr;
+        }
+
+        size_t size() const {
+            return values.size();
+        }
+
+        bool empty() const {
+            return values.empty();
+        }
+
+        typename std::vector<T>::iterator begin(){
+            return values.begin();
+        }
+
+        typename std::vector<T>::iterator end(){
+            return values.end();
+        }
+
+        typename std::vector<T>::const_iterator begin() const {
+            return values.begin();
+        }
+
+        typename std::vector<T>::const_iterator end() const {
+            return values.end();
+        }
+    };
+}
+
+#endif
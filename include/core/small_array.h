@@ -0,0 +1,292 @@
+#ifndef SERAPHIM_SMALL_ARRAY_H
+#define SERAPHIM_SMALL_ARRAY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace srph {
+    // grows geometrically and only shrinks once a quarter full, so that 
+    // alternating pushes and pops around a power of two do not reallocate
+    struct growth_policy_t {
+        static size_t grow(size_t capacity, size_t required){
+            return std::max(required, std::max(capacity * 2, static_cast<size_t>(8)));
+        }
+
+        static size_t shrink(size_t size, size_t capacity){
+            return size <= capacity / 4 ? capacity / 2 : capacity;
+        }
+    };
+
+    // contiguous array that stores up to N elements inline before falling back 
+    // to the allocator
+    template<class T, size_t N = 0, class Allocator = std::allocator<T>, class Policy = growth_policy_t>
+    class small_array_t {
+    private:
+        using traits_t = std::allocator_traits<Allocator>;
+
+        Allocator allocator;
+        T * _data;
+        size_t _size;
+        size_t _capacity;
+        alignas(T) unsigned char buffer[(N > 0 ? N : 1) * sizeof(T)];
+
+        T * inline_data(){
+            return reinterpret_cast<T *>(buffer);
+        }
+
+        bool is_inline() const {
+            return _data == reinterpret_cast<const T *>(buffer);
+        }
+
+        void reallocate(size_t capacity){
+            assert(capacity >= _size);
+
+            T * data = capacity <= N ? inline_data() : traits_t::allocate(allocator, capacity);
+            if (data == _data){
+                return;
+            }
+
+            for (size_t i = 0; i < _size; i++){
+                traits_t::construct(allocator, data + i, std::move_if_noexcept(_data[i]));
+                traits_t::destroy(allocator, _data + i);
+            }
+
+            if (!is_inline()){
+                traits_t::deallocate(allocator, _data, _capacity);
+            }
+
+            _data = data;
+            _capacity = std::max(capacity, N);
+        }
+
+        void release(){
+            clear();
+            if (!is_inline()){
+                traits_t::deallocate(allocator, _data, _capacity);
+                _data = inline_data();
+                _capacity = N;
+            }
+        }
+
+        void steal(small_array_t & x){
+            if (x.is_inline()){
+                append_move(x.data(), x.size());
+                x.clear();
+            } else {
+                _data = x._data;
+                _size = x._size;
+                _capacity = x._capacity;
+
+                x._data = x.inline_data();
+                x._size = 0;
+                x._capacity = N;
+            }
+        }
+
+        void append_move(T * xs, size_t n){
+            reserve(_size + n);
+            for (size_t i = 0; i < n; i++){
+                traits_t::construct(allocator, _data + _size + i, std::move(xs[i]));
+            }
+            _size += n;
+        }
+
+    public:
+        typedef T value_type;
+        typedef T * iterator;
+        typedef const T * const_iterator;
+
+        // constructors and destructors
+        small_array_t() : small_array_t(Allocator()){}
+
+        explicit small_array_t(const Allocator & allocator) : allocator(allocator) {
+            _data = inline_data();
+            _size = 0;
+            _capacity = N;
+        }
+
+        small_array_t(const small_array_t & x) : 
+            small_array_t(traits_t::select_on_container_copy_construction(x.allocator)) 
+        {
+            append(x.data(), x.size());
+        }
+
+        small_array_t(small_array_t && x) : small_array_t(x.allocator) {
+            steal(x);
+        }
+
+        ~small_array_t(){
+            release();
+        }
+
+        small_array_t & operator=(const small_array_t & x){
+            if (this != &x){
+                clear();
+                append(x.data(), x.size());
+            }
+            return *this;
+        }
+
+        small_array_t & operator=(small_array_t && x){
+            if (this != &x){
+                if (allocator == x.allocator){
+                    release();
+                    steal(x);
+                } else {
+                    clear();
+                    append_move(x.data(), x.size());
+                    x.clear();
+                }
+            }
+            return *this;
+        }
+
+        // accessors
+        size_t size() const {
+            return _size;
+        }
+
+        size_t capacity() const {
+            return _capacity;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        T * data(){
+            return _data;
+        }
+
+        const T * data() const {
+            return _data;
+        }
+
+        T & operator[](size_t i){
+            assert(i < _size);
+            return _data[i];
+        }
+
+        const T & operator[](size_t i) const {
+            assert(i < _size);
+            return _data[i];
+        }
+
+        T & back(){
+            assert(_size > 0);
+            return _data[_size - 1];
+        }
+
+        const T & back() const {
+            assert(_size > 0);
+            return _data[_size - 1];
+        }
+
+        const Allocator & get_allocator() const {
+            return allocator;
+        }
+
+        // iterators
+        iterator begin(){
+            return _data;
+        }
+
+        iterator end(){
+            return _data + _size;
+        }
+
+        const_iterator begin() const {
+            return _data;
+        }
+
+        const_iterator end() const {
+            return _data + _size;
+        }
+
+        // modifiers
+        void reserve(size_t capacity){
+            if (capacity > _capacity){
+                reallocate(Policy::grow(_capacity, capacity));
+            }
+        }
+
+        void shrink_to_fit(){
+            reallocate(_size);
+        }
+
+        template<class... Xs>
+        T & emplace_back(Xs &&... xs){
+            if (_size == _capacity){
+                // construct first in case the arguments alias the current storage
+                T x(std::forward<Xs>(xs)...);
+                reserve(_size + 1);
+                traits_t::construct(allocator, _data + _size, std::move(x));
+            } else {
+                traits_t::construct(allocator, _data + _size, std::forward<Xs>(xs)...);
+            }
+
+            return _data[_size++];
+        }
+
+        T & push_back(const T & x){
+            return emplace_back(x);
+        }
+
+        T & push_back(T && x){
+            return emplace_back(std::move(x));
+        }
+
+        void append(const T * xs, size_t n){
+            assert(xs + n <= _data || xs >= _data + _size || n == 0);
+
+            reserve(_size + n);
+            std::uninitialized_copy(xs, xs + n, _data + _size);
+            _size += n;
+        }
+
+        void pop_back(){
+            assert(_size > 0);
+            traits_t::destroy(allocator, _data + --_size);
+
+            if (!is_inline()){
+                size_t capacity = Policy::shrink(_size, _capacity);
+                if (capacity < _capacity){
+                    reallocate(capacity);
+                }
+            }
+        }
+
+        // removes element i in constant time by moving the last element into it
+        void swap_erase(size_t i){
+            assert(i < _size);
+            if (i != _size - 1){
+                _data[i] = std::move(back());
+            }
+            pop_back();
+        }
+
+        void resize(size_t size, const T & x = T()){
+            while (_size > size){
+                traits_t::destroy(allocator, _data + --_size);
+            }
+
+            reserve(size);
+            while (_size < size){
+                traits_t::construct(allocator, _data + _size++, x);
+            }
+        }
+
+        void clear(){
+            for (size_t i = 0; i < _size; i++){
+                traits_t::destroy(allocator, _data + i);
+            }
+            _size = 0;
+        }
+    };
+}
+
+#endif
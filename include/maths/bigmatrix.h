@@ -3,10 +3,22 @@
 
 #include "core/set.h"
 
+// keyed by width * y + x, which needs 64 bits once the matrix has tens of thousands of rows
+typedef struct srph_matrix_item {
+    uint64_t i;
+    double a;
+
+    struct comparator_t {
+        bool operator()(const srph_matrix_item & a, const srph_matrix_item & b) const {
+            return a.i < b.i;
+        }
+    };
+} srph_matrix_item;
+
 typedef struct srph_matrix {
     uint32_t width;
     uint32_t height;
-    srph_set s;    
+    srph::set_t<srph_matrix_item, srph_matrix_item::comparator_t> s;    
 
     bool _is_symmetric;
 } srph_matrix;
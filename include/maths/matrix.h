@@ -5,12 +5,18 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
 #include <cmath>
 #include <functional>
 #include <iostream>
 #include <numeric>
+#include <stdexcept>
 #include <type_traits>
 
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
 namespace srph {
     template<class T, int M, int N>
     class matrix_t : protected std::array<T, M * N> {
@@ -18,11 +24,13 @@ namespace srph {
         using super_t = std::array<T, M * N>; 
 
         template<int K, int P, typename... Xs>
-        void construct(const matrix_t<T, P, 1> & x, Xs... xs){
+        constexpr void construct(const matrix_t<T, P, 1> & x, Xs... xs){
             static_assert(K + P <= M * N, "Too much data in matrix constructor");
             static_assert(K + P == M * N || sizeof...(Xs) > 0, "Not enough data in matrix constructor");
            
-            std::copy(x.begin(), x.end(), this->data() + K);
+            for (int i = 0; i < P; i++){
+                (*this)[K + i] = x[i];
+            }
      
             if constexpr (sizeof...(Xs) != 0){
                 construct<K + P>(xs...); 
@@ -30,80 +38,98 @@ namespace srph {
         }
      
         template<int K, typename... Xs>
-        void construct(const T & x, Xs... xs){
+        constexpr void construct(const T & x, Xs... xs){
             construct<K>(matrix_t<T, 1, 1>(x), xs...);
         }
         
     public:
         // constructors
-        matrix_t() : matrix_t(T(0)){}
+        constexpr matrix_t() : matrix_t(T(0)){}
 
-        matrix_t(const T & x){
-            this->fill(x); 
+        constexpr matrix_t(const T & x) : super_t{} {
+            for (int i = 0; i < M * N; i++){
+                (*this)[i] = x;
+            }
         }
         
         template<class X, class... Xs>
-        matrix_t(const X & x, Xs... xs){
+        constexpr matrix_t(const X & x, Xs... xs) : super_t{} {
             construct<0>(x, xs...);
         }
         
         // vector modifier operators
-        void operator+=(const matrix_t<T, M, N> & x){
-            std::transform(this->begin(), this->end(), x.begin(), this->begin(), std::plus<T>());
+        constexpr void operator+=(const matrix_t<T, M, N> & x){
+            for (int i = 0; i < M * N; i++){
+                (*this)[i] += x[i];
+            }
         }
 
-        void operator-=(const matrix_t<T, M, N> & x){
-            std::transform(this->begin(), this->end(), x.begin(), this->begin(), std::minus<T>());
+        constexpr void operator-=(const matrix_t<T, M, N> & x){
+            for (int i = 0; i < M * N; i++){
+                (*this)[i] -= x[i];
+            }
         }
 
-        void scale(const matrix_t<T, M, N> & x){
-            std::transform(this->begin(), this->end(), x.begin(), this->begin(), std::multiplies<T>());
+        constexpr void scale(const matrix_t<T, M, N> & x){
+            for (int i = 0; i < M * N; i++){
+                (*this)[i] *= x[i];
+            }
         }
         
         // scalar modifier operators 
-        void operator*=(const T & x){
-            scale(matrix_t<T, M, N>(x));    
+        constexpr void operator*=(const T & x){
+            for (int i = 0; i < M * N; i++){
+                (*this)[i] *= x;
+            }
         }
 
         // vector accessor operators  
         template<class S>
-        matrix_t<decltype(T() + S()), M, N> operator+(const matrix_t<S, M, N> & x) const {
+        constexpr matrix_t<decltype(T() + S()), M, N> operator+(const matrix_t<S, M, N> & x) const {
             matrix_t<decltype(T() + S()), M, N> r;
-            std::transform(this->begin(), this->end(), x.begin(), r.begin(), std::plus());
+            for (int i = 0; i < M * N; i++){
+                r[i] = (*this)[i] + x[i];
+            }
             return r;
         }
 
         template<class S>
-        matrix_t<decltype(T() - S()), M, N> operator-(const matrix_t<S, M, N> & x) const {
+        constexpr matrix_t<decltype(T() - S()), M, N> operator-(const matrix_t<S, M, N> & x) const {
             matrix_t<decltype(T() - S()), M, N> r;
-            std::transform(this->begin(), this->end(), x.begin(), r.begin(), std::minus());
+            for (int i = 0; i < M * N; i++){
+                r[i] = (*this)[i] - x[i];
+            }
             return r;
         } 
 
         template<class S>
-        matrix_t<decltype(T() * S()), M, N> scaled(const matrix_t<S, M, N> & x) const {
+        constexpr matrix_t<decltype(T() * S()), M, N> scaled(const matrix_t<S, M, N> & x) const {
             matrix_t<decltype(T() * S()), M, N> r;
-            std::transform(this->begin(), this->end(), x.begin(), r.begin(), std::multiplies());
+            for (int i = 0; i < M * N; i++){
+                r[i] = (*this)[i] * x[i];
+            }
             return r;
         }
 
-        matrix_t<T, M, N> operator/(const matrix_t<T, M, N> & x) const {
+        constexpr matrix_t<T, M, N> operator/(const matrix_t<T, M, N> & x) const {
             matrix_t<T, M, N> r;
-            std::transform(this->begin(), this->end(), x.begin(), r.begin(), std::divides<T>());
+            for (int i = 0; i < M * N; i++){
+                r[i] = (*this)[i] / x[i];
+            }
             return r;
         }
 
         // scalar accessor operators
-        matrix_t<T, M, N> operator-(const T & x) const {
+        constexpr matrix_t<T, M, N> operator-(const T & x) const {
             return *this - matrix_t<T, M, N>(x);
         }
 
-        matrix_t<T, M, N> operator+(const T & x) const {
+        constexpr matrix_t<T, M, N> operator+(const T & x) const {
             return *this + matrix_t<T, M, N>(x);    
         }
 
         template<class S>
-        matrix_t<decltype(T() * S()), M, N> operator*(const S & x) const {
+        constexpr matrix_t<decltype(T() * S()), M, N> operator*(const S & x) const {
             matrix_t<decltype(T() * S()), M, N> ms;
             for (int i = 0; i < M * N; i++){
                 ms[i] = (*this)[i] * x;
@@ -111,7 +137,7 @@ namespace srph {
             return ms;
         }
 
-        matrix_t<T, M, N> operator/(const T & x) const {
+        constexpr matrix_t<T, M, N> operator/(const T & x) const {
             return *this / matrix_t<T, M, N>(x);
         }
 
@@ -123,61 +149,67 @@ namespace srph {
         };
 
         // getters
-        T operator[](int i) const {
+        constexpr T operator[](int i) const {
             return super_t::operator[](i);
         }
 
-        T get(int row, int column) const {
-            if (row >= M || column >= N){
-                throw std::runtime_error("Error: Matrix index out of range.");
-            }
+        constexpr T get(int row, int column) const {
+            assert(row >= 0 && row < M && column >= 0 && column < N);
             return (*this)[column * M + row];
         }
 
-        matrix_t<T, M, 1> get_column(int c) const {
+        constexpr matrix_t<T, M, 1> get_column(int c) const {
             matrix_t<T, M, 1> column;
             for (int row = 0; row < M; row++){
-                column[row] = get(row, c);
+                column[row] = (*this)[c * M + row];
             }
             return column;
         }
 
-        matrix_t<T, N, 1> get_row(int r) const {
+        constexpr matrix_t<T, N, 1> get_row(int r) const {
             matrix_t<T, N, 1> row;
             for (int column = 0; column < N; column++){
-                row[column] = get(r, column);
+                row[column] = (*this)[column * M + r];
             }
             return row;
         }
 
+        const T * data() const {
+            return super_t::data();
+        }
+
         // setters
-        void set(int row, int column, const T & x){
+        constexpr void set(int row, int column, const T & x){
             (*this)[column * M + row] = x;
         }
 
-        T & operator[](int i){
+        constexpr T & operator[](int i){
             return super_t::operator[](i);
         }
 
+        T * data(){
+            return super_t::data();
+        }
+
         // iterators
-        typename std::array<T, M * N>::iterator begin(){
+        constexpr typename std::array<T, M * N>::iterator begin(){
             return super_t::begin();
         }
 
-        typename std::array<T, M * N>::iterator end(){
+        constexpr typename std::array<T, M * N>::iterator end(){
             return super_t::end();
         }
 
-        typename std::array<T, M * N>::const_iterator begin() const {
+        constexpr typename std::array<T, M * N>::const_iterator begin() const {
             return super_t::begin();
         }
 
-        typename std::array<T, M * N>::const_iterator end() const {
+        constexpr typename std::array<T, M * N>::const_iterator end() const {
             return super_t::end();
         }
 
         // factories
-        static matrix_t<T, M, N> diagonal(const T & x){
+        static constexpr matrix_t<T, M, N> diagonal(const T & x){
             matrix_t<T, M, N> a;
             constexpr int size = std::min(M, N);
             for (int i = 0; i < size; i++){
@@ -186,7 +218,7 @@ namespace srph {
             return a;
         }
         
-        static matrix_t<T, M, N> identity(){
+        static constexpr matrix_t<T, M, N> identity(){
             return diagonal(1);
         }
     };
@@ -225,8 +257,12 @@ namespace srph {
 
     namespace vec {
         template<class S, class T, int M, int N>
-        decltype(S() * T()) dot(const matrix_t<S, M, N> & x, const matrix_t<T, M, N> & y){
-            return std::transform_reduce(x.begin(), x.end(), y.begin(), decltype(S() * T())(0));
+        constexpr decltype(S() * T()) dot(const matrix_t<S, M, N> & x, const matrix_t<T, M, N> & y){
+            decltype(S() * T()) d(0);
+            for (int i = 0; i < M * N; i++){
+                d += x[i] * y[i];
+            }
+            return d;
         }
 
         template<class T, int M, int N>
@@ -235,28 +271,40 @@ namespace srph {
         }   
 
         template<class S, class T>
-        vec_t<decltype(S() * T()), 3> cross(const vec_t<S, 3> & x, const vec_t<T, 3> & y){
+        constexpr vec_t<decltype(S() * T()), 3> cross(const vec_t<S, 3> & x, const vec_t<T, 3> & y){
             return vec_t<decltype(S()* T()), 3>(
                 x[1] * y[2] - x[2] * y[1],
                 x[2] * y[0] - x[0] * y[2],
                 x[0] * y[1] - x[1] * y[0]
             );
         }
+
+    #if defined(__SSE__)
+        inline float dot(const f32vec4_t & x, const f32vec4_t & y){
+            __m128 xy = _mm_mul_ps(_mm_loadu_ps(x.data()), _mm_loadu_ps(y.data()));
+            __m128 s = _mm_add_ps(xy, _mm_movehl_ps(xy, xy));
+            s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+            return _mm_cvtss_f32(s);
+        }
+    #endif
     }
 
     namespace mat {
         template<class T>
-        T determinant(const matrix_t<T, 3, 3> & a){
-            return vec::dot(a.get_column(0), vec::cross(a.get_column(1), a.get_column(2)));
+        constexpr T determinant(const matrix_t<T, 3, 3> & a){
+            return 
+                a[0] * (a[4] * a[8] - a[7] * a[5]) -
+                a[3] * (a[1] * a[8] - a[7] * a[2]) +
+                a[6] * (a[1] * a[5] - a[4] * a[2]);
         }
 
         template<class T, int M, int N> 
-        matrix_t<T, N, M> transpose(const matrix_t<T, M, N> & a){
+        constexpr matrix_t<T, N, M> transpose(const matrix_t<T, M, N> & a){
             matrix_t<T, N, M> at;
         
             for (int row = 0; row < M; row++){
                 for (int col = 0; col < N; col++){
-                    at.set(col, row, a.get(row, col));
+                    at[row * N + col] = a[col * M + row];
                 }
             }
             
@@ -265,50 +313,149 @@ namespace srph {
 
         template<class T>
         matrix_t<T, 3, 3> inverse(const matrix_t<T, 3, 3> & a){
-            matrix_t<T, 3, 3> a1(
-                vec::cross(a.get_column(1), a.get_column(2)),
-                vec::cross(a.get_column(2), a.get_column(0)),
-                vec::cross(a.get_column(0), a.get_column(1))
-            );
-
             T det = determinant(a);
             if (std::abs(det) < constant::epsilon){
                 throw std::runtime_error("Error: tried to invert a singular matrix.");
-            } else {
-                return transpose(a1) / det;
-            }
+            } 
+
+            // transposed matrix of cofactors, ie the rows of the inverse are the 
+            // cross products of the columns of a
+            matrix_t<T, 3, 3> ai(
+                a[4] * a[8] - a[5] * a[7], a[7] * a[2] - a[8] * a[1], a[1] * a[5] - a[2] * a[4],
+                a[5] * a[6] - a[3] * a[8], a[8] * a[0] - a[6] * a[2], a[2] * a[3] - a[0] * a[5],
+                a[3] * a[7] - a[4] * a[6], a[6] * a[1] - a[7] * a[0], a[0] * a[4] - a[1] * a[3]
+            );
+
+            ai *= T(1) / det;
+            return ai;
         } 
 
+        template<class T>
+        matrix_t<T, 4, 4> inverse(const matrix_t<T, 4, 4> & m){
+            // cofactor expansion in terms of 2x2 sub-determinants
+            T s0 = m[0] * m[5]  - m[1] * m[4];
+            T s1 = m[0] * m[6]  - m[2] * m[4];
+            T s2 = m[0] * m[7]  - m[3] * m[4];
+            T s3 = m[1] * m[6]  - m[2] * m[5];
+            T s4 = m[1] * m[7]  - m[3] * m[5];
+            T s5 = m[2] * m[7]  - m[3] * m[6];
+
+            T c5 = m[10] * m[15] - m[11] * m[14];
+            T c4 = m[9]  * m[15] - m[11] * m[13];
+            T c3 = m[9]  * m[14] - m[10] * m[13];
+            T c2 = m[8]  * m[15] - m[11] * m[12];
+            T c1 = m[8]  * m[14] - m[10] * m[12];
+            T c0 = m[8]  * m[13] - m[9]  * m[12];
+
+            T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+            if (std::abs(det) < constant::epsilon){
+                throw std::runtime_error("Error: tried to invert a singular matrix.");
+            } 
+
+            matrix_t<T, 4, 4> mi(
+                 m[5]  * c5 - m[6]  * c4 + m[7]  * c3,
+                -m[1]  * c5 + m[2]  * c4 - m[3]  * c3,
+                 m[13] * s5 - m[14] * s4 + m[15] * s3,
+                -m[9]  * s5 + m[10] * s4 - m[11] * s3,
+
+                -m[4]  * c5 + m[6]  * c2 - m[7]  * c1,
+                 m[0]  * c5 - m[2]  * c2 + m[3]  * c1,
+                -m[12] * s5 + m[14] * s2 - m[15] * s1,
+                 m[8]  * s5 - m[10] * s2 + m[11] * s1,
+
+                 m[4]  * c4 - m[5]  * c2 + m[7]  * c0,
+                -m[0]  * c4 + m[1]  * c2 - m[3]  * c0,
+                 m[12] * s4 - m[13] * s2 + m[15] * s0,
+                -m[8]  * s4 + m[9]  * s2 - m[11] * s0,
+
+                -m[4]  * c3 + m[5]  * c1 - m[6]  * c0,
+                 m[0]  * c3 - m[1]  * c1 + m[2]  * c0,
+                -m[12] * s3 + m[13] * s1 - m[14] * s0,
+                 m[8]  * s3 - m[9]  * s1 + m[10] * s0
+            );
+
+            mi *= T(1) / det;
+            return mi;
+        }
+
         template<class T, class S, int X, int Y, int Z>
-        matrix_t<decltype(T() * S()), X, Z> multiply(const matrix_t<T, X, Y> & a, const matrix_t<S, Y, Z> & b){
+        constexpr matrix_t<decltype(T() * S()), X, Z> multiply(const matrix_t<T, X, Y> & a, const matrix_t<S, Y, Z> & b){
             matrix_t<decltype(T() * S()), X, Z> ab;
             
-            for (int m = 0; m < X; m++){
-                for (int n = 0; n < Z; n++){
-                    ab.set(m, n, vec::dot(a.get_row(m), b.get_column(n)));
+            for (int n = 0; n < Z; n++){
+                for (int k = 0; k < Y; k++){
+                    auto bkn = b[n * Y + k];
+                    for (int m = 0; m < X; m++){
+                        ab[n * X + m] += a[k * X + m] * bkn;
+                    }
                 }
             }
             
             return ab; 
         }
+
+    #if defined(__SSE__)
+        inline f32vec4_t multiply(const f32mat4_t & a, const f32vec4_t & x){
+            __m128 ax = _mm_mul_ps(_mm_loadu_ps(a.data()), _mm_set1_ps(x[0]));
+            for (int k = 1; k < 4; k++){
+                ax = _mm_add_ps(ax, _mm_mul_ps(_mm_loadu_ps(a.data() + 4 * k), _mm_set1_ps(x[k])));
+            }
+
+            f32vec4_t r;
+            _mm_storeu_ps(r.data(), ax);
+            return r;
+        }
+
+        inline f32mat4_t multiply(const f32mat4_t & a, const f32mat4_t & b){
+            __m128 columns[4];
+            for (int k = 0; k < 4; k++){
+                columns[k] = _mm_loadu_ps(a.data() + 4 * k);
+            }
+
+            f32mat4_t ab;
+            for (int n = 0; n < 4; n++){
+                __m128 c = _mm_mul_ps(columns[0], _mm_set1_ps(b[n * 4]));
+                for (int k = 1; k < 4; k++){
+                    c = _mm_add_ps(c, _mm_mul_ps(columns[k], _mm_set1_ps(b[n * 4 + k])));
+                }
+                _mm_storeu_ps(ab.data() + 4 * n, c);
+            }
+            return ab;
+        }
+
+        inline f32mat4_t transpose(const f32mat4_t & a){
+            __m128 c0 = _mm_loadu_ps(a.data());
+            __m128 c1 = _mm_loadu_ps(a.data() + 4);
+            __m128 c2 = _mm_loadu_ps(a.data() + 8);
+            __m128 c3 = _mm_loadu_ps(a.data() + 12);
+            _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+            f32mat4_t at;
+            _mm_storeu_ps(at.data(),      c0);
+            _mm_storeu_ps(at.data() + 4,  c1);
+            _mm_storeu_ps(at.data() + 8,  c2);
+            _mm_storeu_ps(at.data() + 12, c3);
+            return at;
+        }
+    #endif
         
         template<class S, class T, int M, int N>
-        matrix_t<S, M, N> cast(const matrix_t<T, M, N> & m){
+        constexpr matrix_t<S, M, N> cast(const matrix_t<T, M, N> & m){
             matrix_t<S, M, N> a;
-            std::transform(m.begin(), m.end(), a.begin(), [](const T & x){
-                return static_cast<S>(x);
-            });
+            for (int i = 0; i < M * N; i++){
+                a[i] = static_cast<S>(m[i]);
+            }
             return a;
         }
     }
 
     template<class S, class T, int X, int Y, int Z>
-    matrix_t<decltype(S() * T()), X, Z> operator*(const matrix_t<T, X, Y> & a, const matrix_t<S, Y, Z> & b){
+    constexpr matrix_t<decltype(S() * T()), X, Z> operator*(const matrix_t<T, X, Y> & a, const matrix_t<S, Y, Z> & b){
         return mat::multiply(a, b);
     }
 
     template<class T, int M, int N>
-    matrix_t<T, M, N> operator/(const T & t, const matrix_t<T, M, N> & a){
+    constexpr matrix_t<T, M, N> operator/(const T & t, const matrix_t<T, M, N> & a){
         return matrix_t<T, M, N>(t) / a;
     }
 
@@ -1,15 +1,37 @@
 #ifndef SERAPHIM_SDF_H
 #define SERAPHIM_SDF_H
 
-#include "core/array.h"
+#include <atomic>
+
+#include "core/small_array.h"
 
 #include "maths/vector.h"
 #include "maths/bound.h"
 #include "maths/matrix.h"
 
+#define SRPH_SDF_DEFAULT_MAX_VERTICES 1024
+
 typedef double (*srph_sdf_func)(void * data, const vec3 * x);
 
+// identifies the built in primitives, whose parameters can be serialised
+typedef enum srph_sdf_type {
+    SRPH_SDF_TYPE_CUSTOM,
+    SRPH_SDF_TYPE_SPHERE,
+    SRPH_SDF_TYPE_TORUS,
+    SRPH_SDF_TYPE_CUBOID,
+    SRPH_SDF_TYPE_OCTAHEDRON
+} srph_sdf_type;
+
+typedef struct srph_sdf_link {
+    uint32_t next;
+} srph_sdf_link;
+
+// sdfs are shared between instances and reference counted. the id is unique
+// per sdf, so that anything cached in local space can be keyed by shape
 typedef struct srph_sdf {
+    uint32_t id;
+    std::atomic<uint32_t> _references;
+
     bool _is_bound_valid;
     srph_bound3 _bound;
 
@@ -21,13 +43,21 @@ typedef struct srph_sdf {
     bool _is_inertia_tensor_valid;
     srph::mat3_t _inertia_tensor;  
 
+    srph_sdf_type type;
     void * _data;
     srph_sdf_func _phi;
     
-    srph_array vertices;
+    srph::small_array_t<vec3> vertices;
+
+    // spatial hash over vertices, chained through _links
+    uint32_t max_vertices;
+    uint32_t _cursor;
+    srph::small_array_t<uint32_t> _buckets;
+    srph::small_array_t<srph_sdf_link> _links;
 } srph_sdf;
 
 void srph_sdf_create(srph_sdf * sdf, srph_sdf_func phi, void * data);
+srph_sdf * srph_sdf_acquire(srph_sdf * sdf);
 void srph_sdf_destroy(srph_sdf * sdf);
 
 double srph_sdf_phi(srph_sdf * sdf, const vec3 * x);
@@ -42,5 +72,6 @@ vec3 * srph_sdf_com(srph_sdf * sdf);
 srph::mat3_t srph_sdf_inertia_tensor(srph_sdf * sdf);
 
 void srph_sdf_add_sample(srph_sdf * sdf, const vec3 * x);
+void srph_sdf_set_max_vertices(srph_sdf * sdf, uint32_t max_vertices);
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef SERAPHIM_SPARSE_H
+#define SERAPHIM_SPARSE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "maths/bigmatrix.h"
+
+// compressed sparse row matrix
+typedef struct srph_csr {
+    uint32_t width;
+    uint32_t height;
+
+    std::vector<uint32_t> row_offsets;
+    std::vector<uint32_t> columns;
+    std::vector<double> values;
+} srph_csr;
+
+// compressed sparse row matrix of dense 3x3 blocks, stored column major
+typedef struct srph_bsr {
+    uint32_t block_width;
+    uint32_t block_height;
+
+    std::vector<uint32_t> row_offsets;
+    std::vector<uint32_t> columns;
+    std::vector<double> values;
+} srph_bsr;
+
+typedef struct srph_pcg_result {
+    uint32_t iterations;
+    double residual;
+} srph_pcg_result;
+
+// symmetric matrices are expanded to store both triangles
+void srph_csr_create(srph_csr * a, srph_matrix * m);
+void srph_bsr_create(srph_bsr * a, srph_matrix * m);
+
+// y = Ax
+void srph_csr_multiply(const srph_csr * a, double * y, const double * x);
+void srph_bsr_multiply(const srph_bsr * a, double * y, const double * x);
+
+// solves Ax = b for symmetric positive definite A by preconditioned conjugate 
+// gradient, using x as the initial guess
+srph_pcg_result srph_csr_solve(
+    const srph_csr * a, double * x, const double * b, double tolerance, uint32_t max_iterations
+);
+srph_pcg_result srph_bsr_solve(
+    const srph_bsr * a, double * x, const double * b, double tolerance, uint32_t max_iterations
+);
+
+#endif
@@ -1,6 +1,10 @@
 #ifndef SERAPHIM_VECTOR_H
 #define SERAPHIM_VECTOR_H
 
+#include <type_traits>
+
+#include "maths/matrix.h"
+
 typedef struct vec3 {
     union {
         struct { 
@@ -51,4 +55,28 @@ double srph_vec3_length(const vec3 * x);
 
 void srph_vec3_print(const vec3 * x);
 
+// zero-copy views between the C and C++ vector types, which share a layout
+static_assert(sizeof(vec3) == sizeof(srph::vec3_t), "vec3 and vec3_t must have the same size");
+static_assert(std::is_standard_layout<srph::vec3_t>::value, "vec3_t must be standard layout");
+
+namespace srph {
+    namespace vec {
+        inline vec3_t & view(vec3 & x){
+            return *reinterpret_cast<vec3_t *>(x.raw);
+        }
+
+        inline const vec3_t & view(const vec3 & x){
+            return *reinterpret_cast<const vec3_t *>(x.raw);
+        }
+
+        inline vec3 & view(vec3_t & x){
+            return *reinterpret_cast<vec3 *>(x.data());
+        }
+
+        inline const vec3 & view(const vec3_t & x){
+            return *reinterpret_cast<const vec3 *>(x.data());
+        }
+    }
+}
+
 #endif
@@ -5,17 +5,24 @@
 
 #include "maths/sdf/sdf.h"
 #include "maths/quat.h"
-#include "physics/constraint.h"
 #include "physics/sphere.h"
 #include "physics/transform.h"
 
+// world space bounds of a matter, swept over a time interval
+typedef struct srph_matter_bounds {
+    srph_sphere sphere;
+    srph_bound3 box;
+} srph_matter_bounds;
+
 typedef struct srph_matter {
     srph_transform transform;
 
     srph_material material;
     srph_sdf * sdf;
 
-    srph_array _vertices;
+    // position in the physics engine's awake or asleep list
+    uint32_t _physics_index;
+    bool _is_asleep;
 
     bool is_uniform;
 
@@ -48,6 +55,7 @@ typedef struct srph_matter {
     
     srph::vec3_t to_local_space(const srph::vec3_t & x) const;
 
+    void accelerate(double delta);
     void physics_tick(double delta);
     
     srph::vec3_t get_velocity(const srph::vec3_t & x);
@@ -76,6 +84,7 @@ void srph_matter_destroy(srph_matter * m);
 double srph_matter_mass(srph_matter * m);
 void srph_matter_bound(const srph_matter * m, srph_bound3 * b);
 void srph_matter_sphere_bound(const srph_matter * m, double t, srph_sphere * s);
+void srph_matter_bounds_update(const srph_matter * m, double t, srph_matter_bounds * b);
 
 
 #endif
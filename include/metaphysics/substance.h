@@ -11,8 +11,8 @@ namespace srph {
         struct data_t {
             float near;
             float far;
-            float _1;
-            float _2;
+            uint32_t shape;
+            uint32_t colour;
 
             f32vec3_t r;
             uint32_t id;
@@ -20,7 +20,10 @@ namespace srph {
             f32mat4_t transform;
 
             data_t();
-            data_t(float near, float far, const f32vec3_t & r, uint32_t id, const f32mat4_t & transform);
+            data_t(
+                float near, float far, uint32_t shape, uint32_t colour, 
+                const f32vec3_t & r, uint32_t id, const f32mat4_t & transform
+            );
 
             struct comparator_t {
                 bool operator()(const substance_t::data_t & a, const substance_t::data_t & b) const;
@@ -33,13 +36,22 @@ namespace srph {
 
         substance_t(uint32_t i);
         substance_t(srph_form * form, srph_matter * matter);
+        substance_t(const substance_t & substance) = delete;
+        ~substance_t();
 
         data_t get_data(const vec3_t & eye_position);
         uint32_t get_id() const;
+        uint32_t get_shape() const;
+
+        // set on the shape ids of substances that need patches of their own
+        static constexpr uint32_t unique_shape_bit = 1u << 31;
 
         uint32_t id;
         srph_form form;
         srph_matter matter;
+
+        // position in the renderer's substance list
+        uint32_t _renderer_index;
     };
 }
 
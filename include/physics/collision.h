@@ -1,10 +1,14 @@
 #ifndef SERAPHIM_COLLISION_H
 #define SERAPHIM_COLLISION_H
 
+#include "core/arena.h"
+#include "core/small_array.h"
 #include "maths/matrix.h"
 #include "maths/vector.h"
 #include "metaphysics/matter.h"
 
+typedef srph::small_array_t<vec3, 8, srph::arena_allocator_t<vec3>> srph_contact_array;
+
 typedef struct srph_collision {
     bool is_intersecting;
     double t;
@@ -13,19 +17,21 @@ typedef struct srph_collision {
     vec3 xa;
     vec3 xb;
 
-    srph_array xs;
+    srph_contact_array xs;
 
     srph::vec3_t n;
-    srph::vec3_t vr;
 
-    double depth;
     srph_matter * a;
     srph_matter * b;
 
-    srph_collision(srph_matter * a, srph_matter * b);
+    srph_collision(
+        srph_matter * a, srph_matter * b, 
+        const srph_matter_bounds * bounds_a, const srph_matter_bounds * bounds_b, srph_arena * arena
+    );
 
+    // finds the contact normal and learns the overlap as sample points of both sdfs,
+    // impulses and penetration are left to the contact solver
     void correct();
-    void colliding_correct();
 
     struct comparator_t {
         bool operator()(const srph_collision & a, const srph_collision & b);
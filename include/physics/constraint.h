@@ -10,6 +10,9 @@ typedef struct srph_vertex {
     vec3 x;
     vec3 v;
     double w;
+
+    // position at the start of the current substep
+    vec3 _x0;
 } srph_vertex;
 
 struct srph_constraint;
@@ -19,6 +22,7 @@ typedef void (*srph_constraint_derivative_func)(struct srph_constraint * c, uint
 typedef struct srph_constraint {
     bool _is_equality;
     double _stiffness;
+    double _lambda;
     void * _data;
     srph_constraint_func _c_func;
     srph_constraint_derivative_func _dc_func;
@@ -36,4 +40,13 @@ void srph_constraint_init(
 void srph_constraint_update(srph_constraint * c, vec3 * dp, uint32_t i, double s); 
 double srph_constraint_scaling_factor(srph_constraint * c);
 
+// xpbd projection over a substep of length dt, accumulating into _lambda
+void srph_constraint_solve(srph_constraint * c, double dt);
+
+// stiffness of INFINITY makes a constraint rigid
+srph_constraint * srph_constraint_distance_create(srph_vertex * a, srph_vertex * b, double d, double stiffness);
+srph_constraint * srph_constraint_joint_create(srph_vertex * a, srph_vertex * b, double stiffness);
+srph_constraint * srph_constraint_contact_create(srph_vertex * a, const vec3 * n, double d);
+void srph_constraint_destroy(srph_constraint * c);
+
 #endif
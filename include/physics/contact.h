@@ -0,0 +1,54 @@
+#ifndef SERAPHIM_CONTACT_H
+#define SERAPHIM_CONTACT_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "physics/collision.h"
+
+typedef struct srph_contact {
+    srph_matter * a;
+    srph_matter * b;
+
+    // contact point and basis in world space, with n pointing from a to b
+    srph::vec3_t x;
+    srph::vec3_t n;
+    srph::vec3_t t[2];
+
+    // the contact point in a's local space, to find the same point again next tick
+    srph::vec3_t xa;
+    double depth;
+
+    double normal_mass;
+    double tangent_mass[2];
+    double target_velocity;
+    double friction;
+    double restitution;
+
+    // accumulated impulses, applied to b and opposite to a
+    double jn;
+    double jt[2];
+} srph_contact;
+
+typedef struct srph_contact_solver {
+    uint32_t iterations;
+
+    std::vector<srph_contact> contacts;
+    std::vector<srph_contact> _previous;
+} srph_contact_solver;
+
+void srph_contact_solver_create(srph_contact_solver * s, uint32_t iterations);
+void srph_contact_solver_destroy(srph_contact_solver * s);
+
+// starts a new tick, keeping the last tick's impulses for warm starting
+void srph_contact_solver_begin(srph_contact_solver * s);
+
+// adds up to four contacts spanning where the collision's matters overlap
+void srph_contact_solver_add(srph_contact_solver * s, const srph_collision * c);
+
+// applies impulses for a tick of length t, including those that push penetrating
+// matters apart over the next few ticks
+void srph_contact_solver_solve(srph_contact_solver * s, double t);
+
+#endif
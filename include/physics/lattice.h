@@ -0,0 +1,36 @@
+#ifndef SERAPHIM_LATTICE_H
+#define SERAPHIM_LATTICE_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "physics/constraint.h"
+
+// a grid of free vertices held to their neighbours by distance constraints, for cloth.
+// a chain is a lattice one vertex wide
+typedef struct srph_lattice {
+    uint32_t width;
+    uint32_t height;
+
+    // sized once on creation, as the constraints point into it
+    std::vector<srph_vertex> vertices;
+    std::vector<srph_constraint *> constraints;
+} srph_lattice;
+
+// vertex (i, j) starts at x + i * u + j * v, and rest lengths are the lengths of u and v
+void srph_lattice_create(
+    srph_lattice * l, uint32_t width, uint32_t height,
+    const vec3 * x, const vec3 * u, const vec3 * v, double stiffness
+);
+void srph_lattice_destroy(srph_lattice * l);
+
+srph_vertex * srph_lattice_vertex(srph_lattice * l, uint32_t i, uint32_t j);
+
+// pinned vertices have no inverse mass, so the solver never moves them
+void srph_lattice_pin(srph_lattice * l, uint32_t i, uint32_t j);
+
+// keeps every vertex on the positive side of the plane n . x = d
+void srph_lattice_add_plane(srph_lattice * l, const vec3 * n, double d);
+
+#endif
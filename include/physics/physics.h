@@ -2,7 +2,10 @@
 #define PHYSICS_H
 
 #include "collision.h"
+#include "contact.h"
+#include "solver.h"
 
+#include "core/arena.h"
 #include "core/constant.h"
 #include "metaphysics/matter.h"
 
@@ -18,11 +21,24 @@ namespace srph {
 
         void start();
 
+        // advances by one tick of at most constant::sigma, returning its length
+        double tick();
+
         void register_matter(srph_matter * matter);
+        void register_matters(const std::vector<srph_matter *> & matters);
         void unregister_matter(srph_matter * matter);
+        void unregister_matters(const std::vector<srph_matter *> & matters);
+
+        // constraints act on vertices, which must outlive them
+        void register_constraint(srph_constraint * constraint);
+        void register_constraints(const std::vector<srph_constraint *> & constraints);
+        void unregister_constraint(srph_constraint * constraint);
+        void unregister_constraints(const std::vector<srph_constraint *> & constraints);
 
         int get_frame_count();
 
+        void remove_matter(srph_matter * matter);
+
         bool quit;
         std::thread thread;
 
@@ -31,6 +47,17 @@ namespace srph {
         std::vector<srph_matter *> matters;
         std::vector<srph_matter *> asleep_matters;
 
+        // bounds swept over a tick, parallel to matters and asleep_matters
+        std::vector<srph_matter_bounds> bounds;
+        std::vector<srph_matter_bounds> asleep_bounds;
+
+        // per tick storage, reused across ticks
+        srph_arena arena;
+        std::vector<srph_collision> collisions;
+
+        srph_solver solver;
+        srph_contact_solver contact_solver;
+
         int frames;
 
         void run();
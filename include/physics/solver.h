@@ -0,0 +1,34 @@
+#ifndef SERAPHIM_SOLVER_H
+#define SERAPHIM_SOLVER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "physics/constraint.h"
+
+// constraints are graph coloured so that no two constraints of the same 
+// colour share a vertex, and each colour is solved in parallel
+typedef struct srph_solver {
+    uint32_t substeps;
+    uint32_t iterations;
+
+    std::vector<srph_constraint *> constraints;
+
+    bool _is_coloured;
+    std::vector<srph_vertex *> _vertices;
+    std::vector<srph_constraint *> _coloured;
+    std::vector<uint32_t> _colour_offsets;
+} srph_solver;
+
+void srph_solver_create(srph_solver * s, uint32_t substeps, uint32_t iterations);
+void srph_solver_destroy(srph_solver * s);
+
+void srph_solver_add(srph_solver * s, srph_constraint * c);
+void srph_solver_remove(srph_solver * s, srph_constraint * c);
+void srph_solver_add_array(srph_solver * s, srph_constraint * const * cs, uint32_t n);
+void srph_solver_remove_array(srph_solver * s, srph_constraint * const * cs, uint32_t n);
+
+void srph_solver_step(srph_solver * s, double dt, const vec3 * gravity);
+
+#endif
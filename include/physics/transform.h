@@ -11,7 +11,12 @@
 typedef struct srph_transform {
     srph::vec3_t position;
     srph::quat_t rotation;
-    std::shared_ptr<srph::f32mat4_t> matrix;
+
+    // cached affine matrices, recalculated whenever position or rotation change
+    srph::matrix_t<double, 3, 4> _forward;
+    srph::matrix_t<double, 3, 4> _inverse;
+
+    srph_transform();
     
     void recalculate_matrix();
 
@@ -31,10 +36,14 @@ typedef struct srph_transform {
     srph::vec3_t to_local_space(const srph::vec3_t & x) const;
     srph::vec3_t to_global_space(const srph::vec3_t & x) const;
 
-    srph::f32mat4_t get_matrix();
+    srph::f32mat4_t get_matrix() const;
 } srph_transform;
 
 void srph_transform_to_local_space (srph_transform * tf, vec3 * tx, const vec3 * x);
 void srph_transform_to_global_space(srph_transform * tf, vec3 * tx, const vec3 * x);
 
+// batch transforms over n points, tx and x may alias
+void srph_transform_to_local_space_array (const srph_transform * tf, vec3 * tx, const vec3 * x, uint32_t n);
+void srph_transform_to_global_space_array(const srph_transform * tf, vec3 * tx, const vec3 * x, uint32_t n);
+
 #endif
@@ -0,0 +1,51 @@
+#ifndef BVH_H
+#define BVH_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "metaphysics/substance.h"
+
+namespace srph {
+    // bounding volume hierarchy over the world space bounds of substances, rebuilt every
+    // frame. nodes are flattened depth first, so an inner node is followed by its first
+    // child, and each node escapes to the next node outside of its subtree. this lets
+    // comp.glsl walk it without a stack
+    class bvh_t {
+    public:
+        static constexpr uint32_t null_index = ~0u;
+
+        struct node_t {
+            f32vec3_t lower;
+            uint32_t escape;
+
+            f32vec3_t upper;
+
+            // index into the substance buffer, or null_index for inner nodes
+            uint32_t substance;
+        };
+
+    private:
+        struct leaf_t {
+            f32vec3_t lower;
+            f32vec3_t upper;
+            f32vec3_t centre;
+            uint32_t substance;
+        };
+
+        std::vector<leaf_t> leaves;
+        std::vector<node_t> nodes;
+
+        void build(uint32_t begin, uint32_t end);
+
+    public:
+        // modifiers
+        void build(const std::vector<substance_t::data_t> & substances);
+
+        // accessors
+        const std::vector<node_t> & get_nodes() const;
+    };
+}
+
+#endif
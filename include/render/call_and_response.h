@@ -11,7 +11,7 @@ namespace srph {
 
         uint32_t index;
         uint32_t hash;
-        uint32_t substanceID;
+        uint32_t shapeID;
         uint32_t status;
 
     public:
@@ -21,7 +21,7 @@ namespace srph {
 
         call_t();
 
-        uint32_t get_substance_ID() const;
+        uint32_t get_shape_ID() const;
         f32vec3_t get_position() const;
         float get_radius() const;
         uint32_t get_index() const;
@@ -40,7 +40,7 @@ namespace srph {
         };  
 
         response_t();
-        response_t(const call_t & call, std::weak_ptr<substance_t> substance);
+        response_t(const call_t & call, srph_sdf * sdf, srph_matter * matter);
 
         const std::array<uint32_t, 8> & get_normals() const;
         const std::array<uint32_t, 8> & get_colours() const;
@@ -14,6 +14,7 @@ namespace srph {
         camera_t();
 
         void update(double delta, const keyboard_t & keyboard, const mouse_t & mouse);
+        void set_pose(const vec3_t & x, const quat_t & q);
 
         f32mat4_t get_matrix();
         vec3_t get_position() const;
@@ -4,16 +4,30 @@
 #include "maths/matrix.h"
 
 namespace srph {
-    class light_t {
-    private:
-        f32vec3_t x;
-        uint32_t id;
+    struct light_t {
+        struct data_t {
+            f32vec3_t x;
+            uint32_t id;
 
-        f32vec4_t colour;
+            f32vec3_t colour;
+
+            // set by the renderer, which changes it whenever shadows cached for the light go stale
+            uint32_t version;
+
+            data_t();
+            data_t(const f32vec3_t & x, uint32_t id, const f32vec3_t & colour);
+        };
 
-    public:
-        light_t();
         light_t(const f32vec3_t & x, const f32vec4_t & colour);
+
+        data_t get_data() const;
+
+        // lights are dynamic, and both of these are read again every frame
+        f32vec3_t x;
+        f32vec4_t colour;
+
+        // position in the renderer's light list
+        uint32_t _renderer_index;
     };
 }
 
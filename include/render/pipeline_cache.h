@@ -0,0 +1,37 @@
+#ifndef PIPELINE_CACHE_H
+#define PIPELINE_CACHE_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <string>
+
+#include "core/device.h"
+
+namespace srph {
+    // pipeline cache persisted between runs. data saved by a different driver
+    // or device is discarded on load, leaving an empty cache
+    class pipeline_cache_t {
+    private:
+        device_t * device;
+        std::string path;
+        VkPipelineCache pipeline_cache;
+        bool is_warm;
+
+        bool is_compatible(const std::string & data) const;
+
+    public:
+        // constructors and destructors
+        pipeline_cache_t(device_t * device, const std::string & path);
+        ~pipeline_cache_t();
+
+        // writes the cache back to disk, returning false on failure
+        bool save() const;
+
+        // accessors
+        VkPipelineCache get_handle() const;
+        bool get_is_warm() const;
+    };
+}
+
+#endif
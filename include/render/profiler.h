@@ -0,0 +1,138 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#define GLFW_INCLUDE_VULKAN
+#include <GLFW/glfw3.h>
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "core/device.h"
+
+namespace srph {
+    class profiler_t {
+    public:
+        // gpu stages are bracketed by a pair of timestamps each
+        enum gpu_stage_t {
+            gpu_stage_write,
+            gpu_stage_cluster,
+            gpu_stage_shadow,
+            gpu_stage_dispatch,
+            gpu_stage_reconstruct,
+            gpu_stage_read,
+            gpu_stage_graphics,
+            gpu_stage_count
+        };
+
+        enum cpu_stage_t {
+            cpu_stage_upload,
+            cpu_stage_requests,
+            cpu_stage_record,
+            cpu_stage_wait,
+            cpu_stage_render,
+            cpu_stage_count
+        };
+
+        // times are in milliseconds, and negative when the stage was not measured
+        struct sample_t {
+            uint32_t frame;
+            double cpu[cpu_stage_count];
+            double gpu[gpu_stage_count];
+
+            // time each queue sat idle between the end of its work for the last frame and
+            // the start of its work for this one. timestamps are only comparable within a 
+            // queue, so the compute and graphics passes are never compared with each other
+            double compute_idle;
+            double graphics_idle;
+
+            // fraction of the width and height that was raymarched
+            double resolution_scale;
+
+            // patches requested by the last dispatch, and resident patches replaced to make room
+            uint32_t patch_requests;
+            uint32_t patch_evictions;
+
+            // lights that reached a cluster already holding as many as it can, summed over clusters
+            uint32_t dropped_lights;
+
+            // shader invocations, or zero without pipeline statistics queries
+            uint64_t compute_invocations;
+            uint64_t fragment_invocations;
+
+            // raw timestamps at the start and end of each stage
+            uint64_t ticks[gpu_stage_count][2];
+        };
+
+    private:
+        device_t * device;
+
+        // each set holds the queries of one command buffer in flight
+        uint32_t sets;
+
+        VkQueryPool timestamp_pool;
+        VkQueryPool compute_statistics_pool;
+        VkQueryPool graphics_statistics_pool;
+
+        double timestamp_period;
+        uint64_t compute_timestamp_mask;
+        uint64_t graphics_timestamp_mask;
+
+        // rolling history, oldest sample at head once full
+        std::vector<sample_t> history;
+        uint32_t capacity;
+        uint32_t head;
+
+        // samples still being collected, one per frame in flight
+        std::vector<sample_t> pending;
+
+        // where each queue's work ended in the last completed sample, or zero before any
+        uint64_t compute_end;
+        uint64_t graphics_end;
+
+        static uint64_t mask_from_bits(uint32_t valid_bits);
+        VkQueryPool create_pool(VkQueryType type, VkQueryPipelineStatisticFlags statistics, uint32_t count) const;
+        uint64_t get_timestamp_mask(gpu_stage_t stage) const;
+        VkQueryPool get_statistics_pool(gpu_stage_t stage) const;
+        uint32_t get_query(uint32_t set, gpu_stage_t stage) const;
+        double get_idle(uint64_t & end, uint64_t begin, uint64_t next_end, uint64_t mask);
+
+    public:
+        static constexpr const char * cpu_stage_names[cpu_stage_count] = {
+            "upload", "requests", "record", "wait", "render"
+        };
+
+        static constexpr const char * gpu_stage_names[gpu_stage_count] = {
+            "write", "cluster", "shadow", "dispatch", "reconstruct", "read", "graphics"
+        };
+
+        // constructors and destructors
+        profiler_t(device_t * device, uint32_t sets, uint32_t slots, uint32_t capacity);
+        ~profiler_t();
+
+        // recording, outside of any render pass
+        void record_begin(VkCommandBuffer command_buffer, uint32_t set, gpu_stage_t stage) const;
+        void record_end(VkCommandBuffer command_buffer, uint32_t set, gpu_stage_t stage) const;
+
+        // collecting a frame in one of the slots, resolving each stage once the command 
+        // buffer it was recorded into has completed
+        void begin_frame(uint32_t slot, uint32_t frame);
+        void set_cpu_time(uint32_t slot, cpu_stage_t stage, double time);
+        void set_resolution_scale(uint32_t slot, double scale);
+        void set_patch_churn(uint32_t slot, uint32_t requests, uint32_t evictions);
+        void set_dropped_lights(uint32_t slot, uint32_t lights);
+        void resolve(uint32_t slot, uint32_t set, gpu_stage_t stage);
+        void end_frame(uint32_t slot);
+        const sample_t & get_pending(uint32_t slot) const;
+
+        // accessors
+        bool has_timestamps() const;
+        bool has_statistics() const;
+        std::vector<sample_t> get_history() const;
+        const sample_t * get_latest() const;
+
+        bool save_csv(const char * path) const;
+    };
+}
+
+#endif
@@ -12,8 +12,12 @@
 
 #include "core/buffer.h"
 #include "ui/window.h"
+#include "render/bvh.h"
 #include "render/camera.h"
 #include "render/light.h"
+#include "render/pipeline_cache.h"
+#include "render/profiler.h"
+#include "render/shader.h"
 #include "render/swapchain.h"
 #include "render/texture.h"
 #include "core/command.h"
@@ -24,6 +28,59 @@ namespace srph {
     class renderer_t {
     private:
         // types
+        // holds a reference to its sdf, and to the matter of a substance that does
+        // not share its patches
+        struct shape_t {
+            srph_sdf * sdf;
+            srph_matter * matter;
+            uint32_t instances;
+        };
+
+        // specialisation constants of comp.glsl and cluster.glsl, in constant id order
+        struct specialisation_t {
+            uint32_t work_group_size_x;
+            uint32_t work_group_size_y;
+            uint32_t max_steps;
+            uint32_t max_hash_retries;
+            uint32_t cone_tile_size;
+            uint32_t cone_levels;
+            uint32_t cluster_grid_x;
+            uint32_t cluster_grid_y;
+            uint32_t cluster_grid_z;
+            uint32_t max_cluster_lights;
+            float cluster_near;
+            float light_cutoff;
+            float shadow_threshold;
+            uint32_t shadow_cell_scale;
+            VkBool32 is_shadow_pass;
+            uint32_t patch_ways;
+        };
+
+        // visibility of a light at the corners of a cell, see comp.glsl
+        struct shadow_t {
+            uint32_t hash;
+            uint32_t version;
+            u32vec2_t visibility;
+        };
+
+        struct shadow_request_t {
+            f32vec3_t position;
+            float size;
+
+            uint32_t light;
+            uint32_t version;
+            uint32_t substance;
+            uint32_t hash;
+        };
+
+        // a compute pipeline specialised for one work group shape
+        struct variant_t {
+            u32vec2_t work_group_size;
+            VkPipeline pipeline;
+            double time;
+            uint32_t samples;
+        };
+
         struct push_constant_t {
             u32vec2_t window_size;
             float render_distance;
@@ -40,6 +97,23 @@ namespace srph {
             uint32_t texture_depth;
             uint32_t patch_pool_size;
             float epsilon;
+
+            u32vec2_t render_size;
+            f32vec2_t jitter;
+        };
+
+        // the smallest push constant range every device supports
+        static_assert(sizeof(push_constant_t) <= 128, "Push constants must fit in 128 bytes");
+
+        struct reconstruct_constant_t {
+            f32mat4_t reprojection;
+
+            u32vec2_t size;
+            u32vec2_t render_size;
+
+            f32vec2_t jitter;
+            float focal_depth;
+            float history_weight;
         };
 
         // constants
@@ -48,13 +122,78 @@ namespace srph {
         static constexpr uint32_t number_of_patches = 1000000;
         static constexpr uint32_t patch_sample_size = 2;
         static constexpr uint32_t max_cache_size = 1000;  
+        static constexpr uint32_t profiler_history = 1024;
+
+        // patches go in any slot of the bucket of patch_ways slots their hash falls in. the 
+        // shader stamps each slot with the frame it was last used, and requests a patch into
+        // the least recently used slot of its bucket
+        static constexpr uint32_t patch_ways = 4;
+        static constexpr uint32_t patch_age_binding = 6;
+        static_assert(number_of_patches % patch_ways == 0, "Patches must fill whole buckets");
 
-        std::set<uint32_t> indices;
-        std::set<uint32_t> hashes;
+        static constexpr uint32_t max_steps = 128;
+        static constexpr uint32_t max_hash_retries = 10;
+
+        // start distances are cone marched over tiles of pixels, halving the tile for each level
+        static constexpr uint32_t cone_tile_size = 8;
+        static constexpr uint32_t cone_levels = 2;
+
+        // work group shapes are autotuned over the first frames, and the
+        // fastest is remembered per device, driver and shader
+        static constexpr uint32_t max_work_group_area = 1024;
+        static constexpr uint32_t min_work_group_side = 8;
+        static constexpr uint32_t autotune_frames = 8;
+        static constexpr const char * autotune_path = "autotune.txt";
+
+        // the raymarch is scaled down to hold the frame budget, and reconstructed at full 
+        // size from the new samples and the last frame
+        static constexpr double default_frame_budget = 1000.0 / 60.0;
+        static constexpr float min_resolution_scale = 0.5f;
+        static constexpr float resolution_gain = 0.25f;
+        static constexpr uint32_t resolution_interval = 8;
+        static constexpr float history_weight = 0.9f;
+        static constexpr uint32_t jitter_frames = 16;
+        static constexpr uint32_t reconstruct_work_group_size = 8;
+        static constexpr uint32_t sample_binding = 13;
+        static constexpr uint32_t history_binding = 14;
+
+        // substances are traversed through a hierarchy instead of being culled per work
+        // group, and their buffers grow to fit however many are registered
+        static constexpr uint32_t min_substance_capacity = 256;
+        static constexpr uint32_t bvh_binding = 7;
+
+        // lights are assigned to clusters, cells of the view frustum split evenly across the
+        // image and exponentially in depth. each cluster lists up to max_cluster_lights, and
+        // a light reaches as far as its intensity stays above light_cutoff. lights past the 
+        // limit are dropped dimmest first, and counted after the last cluster
+        static constexpr uint32_t cluster_grid_x = 16;
+        static constexpr uint32_t cluster_grid_y = 9;
+        static constexpr uint32_t cluster_grid_z = 24;
+        static constexpr uint32_t max_cluster_lights = 64;
+        static constexpr float cluster_near = 1.0f;
+        static constexpr float light_cutoff = 1.0f / 256.0f;
+        static constexpr uint32_t cluster_binding = 8;
+        static constexpr uint32_t cluster_work_group_size = 64;
+        static constexpr uint32_t cluster_overflow_offset = cluster_grid_x * cluster_grid_y * cluster_grid_z * (max_cluster_lights + 1);
+        static constexpr uint32_t min_light_capacity = 256;
+
+        // lights that would add less than this to a pixel are not shadowed
+        static constexpr float shadow_threshold = 1.0f / 64.0f;
+
+        // soft shadows are cached in a pool of cells, each a few patches wide, and filled in
+        // by a shadow pass of one work group per requested cell
+        static constexpr uint32_t shadow_pool_size = 1 << 18;
+        static constexpr uint32_t number_of_shadow_requests = 1024;
+        static constexpr uint32_t shadow_cell_scale = 2;
+        static constexpr uint32_t shadow_binding = 9;
+        static constexpr uint32_t shadow_request_binding = 15;
+
+        // slots that have ever been filled, so that replacing them counts as an eviction
+        std::vector<bool> resident_patches;
 
         // fields
-        u32vec2_t work_group_count;
-        u32vec2_t work_group_size;
+        u32vec2_t size;
+        uint32_t work_group_area;
         uint32_t patch_image_size; 
         push_constant_t push_constants;
         device_t * device;
@@ -66,8 +205,23 @@ namespace srph {
         VkPipelineLayout pipeline_layout;
         std::vector<std::shared_ptr<command_buffer_t>> command_buffers;
 
-        VkPipeline compute_pipeline;
+        std::vector<variant_t> variants;
+        uint32_t variant;
+        uint32_t tuning_frame;
+        bool is_tuning;
         VkPipelineLayout compute_pipeline_layout;
+        VkPipeline reconstruct_pipeline;
+        VkPipeline cluster_pipeline;
+        VkPipeline shadow_pipeline;
+        VkPipelineLayout reconstruct_pipeline_layout;
+
+        // dynamic resolution
+        double frame_budget;
+        float resolution_scale;
+        u32vec2_t render_size;
+        uint32_t resize_frame;
+        f32mat4_t previous_eye_transform;
+        bool has_history;
 
         int frames;
         int current_frame;
@@ -75,23 +229,54 @@ namespace srph {
         std::vector<VkSemaphore> compute_done_semas;
         std::vector<VkSemaphore> render_finished_semas;
         std::vector<VkFence> in_flight_fences;
+        std::vector<VkFence> compute_fences;
 
         VkDescriptorSetLayout descriptor_layout;
+        std::vector<VkDescriptorSetLayoutBinding> descriptor_bindings;
         std::vector<VkDescriptorSet> desc_sets;
         VkDescriptorPool desc_pool;
 
         VkQueue present_queue;
+
+        // offscreen rendering reads the render texture back instead of presenting it
+        bool is_headless;
+        std::unique_ptr<host_buffer_t<uint32_t>> readback_buffer;
+        std::vector<uint32_t> frame;
+
+        // compute command buffers use the query sets of their frame in flight,
+        // and graphics command buffers those after them by swapchain image
+        std::unique_ptr<profiler_t> profiler;
         
-        std::string fragment_shader_code;
-        std::string vertex_shader_code;
+        // pipelines are rebuilt with the swapchain, so creation goes through a persistent cache
+        static constexpr const char * pipeline_cache_path = "pipeline_cache.bin";
+        std::unique_ptr<pipeline_cache_t> pipeline_cache;
+
+        std::vector<std::shared_ptr<substance_t>> substances;
+        uint32_t substance_capacity;
+        bvh_t bvh;
+
+        std::vector<std::shared_ptr<light_t>> lights;
+        uint32_t light_capacity;
+
+        // cached shadows belong to a version of their light, which changes whenever the light
+        // does, or a substance within its reach moves, appears or leaves. each list holds what
+        // was last seen of the substance or light at the same index, and moved_bounds the 
+        // spheres around substances that changed since the last frame
+        std::vector<substance_t::data_t> substance_history;
+        std::vector<light_t::data_t> light_history;
+        std::vector<f32vec4_t> moved_bounds;
+        uint32_t shadow_version;
 
-        std::set<std::shared_ptr<substance_t>, substance_t::comparator_t> substances;
+        // patches are requested per shape, so responses scale with unique sdfs
+        std::map<uint32_t, shape_t> shapes;
 
         std::unique_ptr<swapchain_t> swapchain;
         std::weak_ptr<camera_t> main_camera;
 
         // textures
-        std::unique_ptr<texture_t> render_texture; 
+        // one per frame in flight, so a dispatch can write while the last frame is drawn
+        std::vector<std::unique_ptr<texture_t>> render_textures;
+        std::unique_ptr<texture_t> sample_texture;
         std::unique_ptr<texture_t> colour_texture;
         std::unique_ptr<texture_t> normal_texture;
         
@@ -103,10 +288,13 @@ namespace srph {
         std::unique_ptr<device_buffer_t<response_t::patch_t>> patch_buffer;
         std::unique_ptr<device_buffer_t<substance_t::data_t>> substance_buffer;
         std::unique_ptr<device_buffer_t<call_t>> call_buffer;
-        std::unique_ptr<device_buffer_t<light_t>> light_buffer;
+        std::unique_ptr<device_buffer_t<light_t::data_t>> light_buffer;
         std::unique_ptr<device_buffer_t<uint32_t>> pointer_buffer;
-        std::unique_ptr<device_buffer_t<f32vec2_t>> frustum_buffer;
-        std::unique_ptr<device_buffer_t<f32vec4_t>> lighting_buffer;
+        std::unique_ptr<device_buffer_t<uint32_t>> patch_age_buffer;
+        std::unique_ptr<device_buffer_t<uint32_t>> cluster_buffer;
+        std::unique_ptr<device_buffer_t<bvh_t::node_t>> bvh_buffer;
+        std::unique_ptr<device_buffer_t<shadow_t>> shadow_buffer;
+        std::unique_ptr<device_buffer_t<shadow_request_t>> shadow_request_buffer;
       
         std::map<call_t, response_t, call_t::comparator_t> response_cache;
         std::list<std::map<call_t, response_t, call_t::comparator_t>::iterator> prev_calls;
@@ -114,10 +302,13 @@ namespace srph {
         std::chrono::high_resolution_clock::time_point start;
 
         // initialisation functions
-        VkShaderModule create_shader_module(std::string code);
+        VkShaderModule create_shader_module(const shader::code_t & code);
         void create_render_pass();
         void create_graphics_pipeline();    
-        void create_compute_pipeline();
+        void create_compute_pipeline_layout();
+        VkPipeline create_compute_pipeline(const shader::code_t & code, u32vec2_t work_group_size, bool is_shadow_pass = false);
+        void create_variants();
+        void create_reconstruct_pipeline();
         void create_framebuffers();
         void create_command_buffers();
         void create_descriptor_set_layout();
@@ -125,13 +316,30 @@ namespace srph {
         void create_sync();
         void create_compute_command_buffers();
         void create_buffers();
+        void create_substance_buffers();
+        uint32_t get_command_buffer_index(uint32_t frame, uint32_t image_index) const;
 
         // helper functions
+        uint32_t get_work_group_area() const;
+        std::vector<u32vec2_t> get_work_group_sizes() const;
+        u32vec2_t get_work_group_count() const;
+        std::string get_autotune_key() const;
+        std::map<std::string, u32vec2_t> load_autotune() const;
+        void update_autotune();
+        f32vec2_t get_jitter() const;
+        void update_resolution();
         void recreate_swapchain();
         void cleanup_swapchain();
         void handle_requests(uint32_t frame);
         void present(uint32_t image_index) const;
-        response_t get_response(const call_t & call, std::weak_ptr<substance_t> substance);   
+        void record_readback(VkCommandBuffer command_buffer);
+        response_t get_response(const call_t & call, const shape_t & shape);   
+        void reserve_substances(uint32_t n);
+        void reserve_lights(uint32_t n);
+        void update_light_versions(std::vector<light_t::data_t> & light_data);
+        void update_descriptor_sets(const std::vector<VkWriteDescriptorSet> & write_desc_sets);
+        void add_shape(substance_t * substance);
+        void remove_shape(substance_t * substance);
         
     public:
         // constructors and destructors
@@ -139,8 +347,7 @@ namespace srph {
             device_t * device,
             VkSurfaceKHR surface, window_t * window,
             std::shared_ptr<camera_t> test_camera,
-            u32vec2_t work_group_count, u32vec2_t work_group_size,
-            uint32_t max_image_size
+            u32vec2_t size, uint32_t max_image_size
         );
         ~renderer_t();
 
@@ -149,9 +356,30 @@ namespace srph {
         void set_main_camera(std::weak_ptr<camera_t> camera);
 
         void register_substance(std::shared_ptr<substance_t> substance);
+        void register_substances(const std::vector<std::shared_ptr<substance_t>> & substances);
         void unregister_substance(std::shared_ptr<substance_t> substance);
+        void unregister_substances(const std::vector<std::shared_ptr<substance_t>> & substances);
+
+        void register_light(std::shared_ptr<light_t> light);
+        void register_lights(const std::vector<std::shared_ptr<light_t>> & lights);
+        void unregister_light(std::shared_ptr<light_t> light);
+        void unregister_lights(const std::vector<std::shared_ptr<light_t>> & lights);
 
         int get_frame_count();
+
+        // milliseconds spent in the compute stages of the last frame, as the frame budget 
+        // counts them, or negative if they were not all measured
+        double get_gpu_time() const;
+        const profiler_t & get_profiler() const;
+
+        // target for the compute work of a frame in milliseconds, or zero to always
+        // render at full resolution
+        void set_frame_budget(double milliseconds);
+        u32vec2_t get_render_size() const;
+
+        // rgba8 pixels of the last frame, only filled in when headless
+        const std::vector<uint32_t> & get_frame() const;
+        u32vec2_t get_size() const;
     };
 }
 
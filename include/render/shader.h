@@ -0,0 +1,21 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace srph { namespace shader {
+    // spir-v compiled from src/render/shader at build time and embedded in the binary
+    struct code_t {
+        const uint32_t * words;
+        size_t size;
+    };
+
+    extern const code_t compute;
+    extern const code_t vertex;
+    extern const code_t fragment;
+    extern const code_t reconstruct;
+    extern const code_t cluster;
+}}
+
+#endif
@@ -34,7 +34,7 @@ namespace srph {
         // constructors and destructors
         texture_t(
             uint32_t binding, device_t * device,
-            u32vec3_t size, VkImageUsageFlags usage,
+            u32vec3_t size, VkFormat format, VkImageUsageFlags usage,
             VkFormatFeatureFlagBits format_feature, VkDescriptorType descriptor_type
         );
         ~texture_t();
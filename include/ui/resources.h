@@ -1,10 +1,14 @@
 #ifndef RESOURCES_H
 #define RESOURCES_H
 
+#include <stddef.h>
+
 #include <string>
 
 namespace srph { namespace resources {
+    // returns an empty string if the file cannot be read
     std::string load_file(std::string filename); 
+    bool save_file(std::string filename, const void * data, size_t size);
 }}
 
-#endif 
+#endif
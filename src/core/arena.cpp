@@ -0,0 +1,108 @@
+#include "core/arena.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALIGNMENT 16
+
+static size_t align(size_t size){
+    return (size + ALIGNMENT - 1) & ~((size_t) ALIGNMENT - 1);
+}
+
+static srph_arena_chunk * chunk_create(size_t size, srph_arena_chunk * next){
+    srph_arena_chunk * c = (srph_arena_chunk *) malloc(sizeof(srph_arena_chunk) + size);
+    assert(c != NULL);
+
+    c->next = next;
+    c->size = size;
+    c->used = 0;
+    return c;
+}
+
+void srph_arena_create(srph_arena * a, size_t chunk_size){
+    assert(a != NULL && chunk_size > 0);
+
+    a->_chunk_size = align(chunk_size);
+    a->_head = chunk_create(a->_chunk_size, NULL);
+    a->_total_used = 0;
+    a->_last = NULL;
+}
+
+void srph_arena_destroy(srph_arena * a){
+    if (a == NULL){
+        return;
+    }
+
+    while (a->_head != NULL){
+        srph_arena_chunk * next = a->_head->next;
+        free(a->_head);
+        a->_head = next;
+    }
+}
+
+void * srph_arena_alloc(srph_arena * a, size_t size){
+    assert(a != NULL);
+    size = align(size);
+
+    srph_arena_chunk * c = a->_head;
+    if (c->used + size > c->size){
+        size_t chunk_size = a->_chunk_size;
+        while (chunk_size < size){
+            chunk_size *= 2;
+        }
+
+        c = chunk_create(chunk_size, a->_head);
+        a->_head = c;
+    }
+
+    void * data = c->data + c->used;
+    c->used += size;
+    a->_total_used += size;
+    a->_last = data;
+    return data;
+}
+
+void * srph_arena_realloc(srph_arena * a, void * data, size_t old_size, size_t new_size){
+    if (data == NULL){
+        return srph_arena_alloc(a, new_size);
+    }
+
+    old_size = align(old_size);
+    new_size = align(new_size);
+    if (new_size <= old_size){
+        return data;
+    }
+
+    // grow in place if this was the last allocation and there is room
+    srph_arena_chunk * c = a->_head;
+    if (data == a->_last && c->used - old_size + new_size <= c->size){
+        c->used += new_size - old_size;
+        a->_total_used += new_size - old_size;
+        return data;
+    }
+
+    void * new_data = srph_arena_alloc(a, new_size);
+    memcpy(new_data, data, old_size);
+    return new_data;
+}
+
+void srph_arena_reset(srph_arena * a){
+    assert(a != NULL);
+
+    // coalesce into a single chunk large enough for everything used since the 
+    // last reset, so that a steady state makes no further heap allocations
+    if (a->_head->next != NULL){
+        size_t size = a->_chunk_size;
+        while (size < a->_total_used){
+            size *= 2;
+        }
+
+        srph_arena_destroy(a);
+        a->_head = chunk_create(size, NULL);
+    }
+
+    a->_head->used = 0;
+    a->_total_used = 0;
+    a->_last = NULL;
+}
@@ -11,10 +11,20 @@ void srph_array_create(srph_array * a, uint32_t element_size){
     a->size = 0;
     a->capacity = 1;
     a->_data = malloc(element_size); 
+    a->_arena = NULL;
+}
+
+void srph_array_create_in(srph_array * a, uint32_t element_size, srph_arena * arena){
+    a->element_size = element_size;
+    a->size = 0;
+    a->capacity = 0;
+    a->_data = NULL; 
+    a->_arena = arena;
 }
 
 void srph_array_destroy(srph_array * a){
-    if (a != NULL && a->_data != NULL){
+    // arena backed storage is released when the arena is reset
+    if (a != NULL && a->_data != NULL && a->_arena == NULL){
         free(a->_data);
     }
 }
@@ -28,13 +38,22 @@ void * srph_array_last(const srph_array * a){
 }
 
 void * srph_array_end(const srph_array * a){
-    return a == NULL ? NULL : srph_array_at(a, a->size);
+    return a == NULL ? NULL : ((uint8_t *) a->_data) + a->element_size * a->size;
 }
 
 void * srph_array_push_back(srph_array * a){
     if (a->size == a->capacity){
-        a->capacity *= 2;
-        a->_data = realloc(a->_data, a->capacity * a->element_size); 
+        uint32_t capacity = a->capacity == 0 ? 8 : a->capacity * 2;
+
+        if (a->_arena != NULL){
+            a->_data = srph_arena_realloc(
+                a->_arena, a->_data, a->capacity * a->element_size, capacity * a->element_size
+            );
+        } else {
+            a->_data = realloc(a->_data, capacity * a->element_size); 
+        }
+
+        a->capacity = capacity;
     }
 
     a->size++;
@@ -52,14 +71,15 @@ void srph_array_pop_back(srph_array * a, void * data){
 
     a->size--;
 
-    if (a->size < a->capacity / 2 && a->capacity > 1){
+    // only shrink once a quarter full so that alternating push and pop doesnt thrash
+    if (a->_arena == NULL && a->size <= a->capacity / 4 && a->capacity > 1){
         a->capacity /= 2;
         a->_data = realloc(a->_data, a->capacity * a->element_size);
     } 
 }
 
 void * srph_array_at(const srph_array * a, uint32_t i){
-    if (a == NULL || i > a->size){
+    if (a == NULL || i >= a->size){
         return NULL;
     }
 
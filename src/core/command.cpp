@@ -7,13 +7,25 @@ command_buffer_t::~command_buffer_t(){
 }
 
 void command_buffer_t::submit(VkSemaphore wait_sema, VkSemaphore signal_sema, VkFence fence, VkPipelineStageFlags stage){
+    if (wait_sema == VK_NULL_HANDLE){
+        submit({}, {}, signal_sema, fence);
+    } else {
+        submit({ wait_sema }, { stage }, signal_sema, fence);
+    }
+}
+
+void command_buffer_t::submit(
+    const std::vector<VkSemaphore> & wait_semas, const std::vector<VkPipelineStageFlags> & stages,
+    VkSemaphore signal_sema, VkFence fence
+){
     VkSubmitInfo submit_info = {};
-    submit_info.pWaitDstStageMask = &stage;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submit_info.commandBufferCount = 1;
     submit_info.pCommandBuffers = &command_buffer;
     
-    submit_info.waitSemaphoreCount = wait_sema == VK_NULL_HANDLE ? 0 : 1;
-    submit_info.pWaitSemaphores = &wait_sema;
+    submit_info.waitSemaphoreCount = wait_semas.size();
+    submit_info.pWaitSemaphores = wait_semas.data();
+    submit_info.pWaitDstStageMask = stages.data();
     submit_info.signalSemaphoreCount = signal_sema == VK_NULL_HANDLE ? 0 : 1;
     submit_info.pSignalSemaphores = &signal_sema;
 
@@ -11,17 +11,40 @@ const std::vector<const char *> device_extensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
-device_t::device_t(VkInstance instance, VkSurfaceKHR surface, std::vector<const char *> enabled_validation_layers){
+device_t::device_t(
+    VkInstance instance, VkSurfaceKHR surface, std::vector<const char *> enabled_validation_layers, bool is_async_compute_allowed
+){
+    is_headless = surface == VK_NULL_HANDLE;
+    this->is_async_compute_allowed = is_async_compute_allowed;
+    present_family = ~0u;
+    compute_family = ~0u;
+    graphics_family = ~0u;
+
     physical_device = select_physical_device(instance, surface);
     select_queue_families(surface);
+    select_features();
     device = create_device(enabled_validation_layers);
 }
 
+std::vector<const char *> device_t::get_device_extensions() const {
+    return is_headless ? std::vector<const char *>() : device_extensions;
+}
+
+int device_t::rank_device_type(VkPhysicalDeviceType type){
+    switch (type){
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   return 4;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return 3;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    return 2;
+        case VK_PHYSICAL_DEVICE_TYPE_CPU:            return 1;
+        default:                                     return 0;
+    }
+}
+
 bool device_t::is_suitable_device(VkPhysicalDevice physical_device, VkSurfaceKHR surface) const {
-    // check that gpu isnt integrated
+    // check that gpu isnt integrated, unless rendering offscreen
     VkPhysicalDeviceProperties properties;
     vkGetPhysicalDeviceProperties(physical_device, &properties);
-    if (properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU){
+    if (!is_headless && properties.deviceType != VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU){
         return false;
     }
 
@@ -34,12 +57,16 @@ bool device_t::is_suitable_device(VkPhysicalDevice physical_device, VkSurfaceKHR
         return false;
     }
 
-    for (auto extension : device_extensions){
+    for (auto extension : get_device_extensions()){
         if (!device_has_extension(physical_device, extension)){
             return false;
         }
     }
 
+    if (is_headless){
+        return true;
+    }
+
     uint32_t formats_count = 0;
     vkGetPhysicalDeviceSurfaceFormatsKHR(physical_device, surface, &formats_count, nullptr);
 
@@ -78,12 +105,26 @@ VkPhysicalDevice device_t::select_physical_device(VkInstance instance, VkSurface
     std::vector<VkPhysicalDevice> devices(device_count);
     vkEnumeratePhysicalDevices(instance, &device_count, devices.data());
    
+    // prefer hardware, but fall back to software rasterisers when headless
+    VkPhysicalDevice best = VK_NULL_HANDLE;
+    int best_rank = -1;
     for (auto physical_device : devices){
         if (is_suitable_device(physical_device, surface)){
-            return physical_device;
+            VkPhysicalDeviceProperties properties;
+            vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+            int rank = rank_device_type(properties.deviceType);
+            if (rank > best_rank){
+                best = physical_device;
+                best_rank = rank;
+            }
         }
     }
 
+    if (best != VK_NULL_HANDLE){
+        return best;
+    }
+
     throw std::runtime_error("Error: Unable to find a suitable physical device!");
 }
 
@@ -98,8 +139,10 @@ bool device_t::has_adequate_queue_families(VkPhysicalDevice physical_device, VkS
     vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_families.data());
    
     for (uint32_t i = 0; i < queue_family_count; i++){
-        VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+        VkBool32 present_support = is_headless;
+        if (!is_headless){
+            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+        }
 
         if (queue_families[i].queueCount > 0){
             queue_families_found[0] |= present_support;
@@ -120,7 +163,9 @@ void device_t::select_queue_families(VkSurfaceKHR surface){
    
     for (uint32_t i = 0; i < queue_family_count; i++){
         VkBool32 present_support = false;
-        vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+        if (!is_headless){
+            vkGetPhysicalDeviceSurfaceSupportKHR(physical_device, i, surface, &present_support);
+        }
 
         if (queue_families[i].queueCount > 0){
             if (present_support){
@@ -131,16 +176,36 @@ void device_t::select_queue_families(VkSurfaceKHR surface){
                 graphics_family = i;
             }
 
-            if (queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT){
+            // prefer a family without graphics, so that compute runs asynchronously to it
+            bool is_dedicated = !(queue_families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT);
+            if ((queue_families[i].queueFlags & VK_QUEUE_COMPUTE_BIT) && (compute_family == ~0u || is_dedicated)){
                 compute_family = i;
             }
         }
     }
+
+    // otherwise compute shares the graphics queue, which is how frames ran before async compute
+    if (!is_async_compute_allowed && graphics_family != ~0u && (queue_families[graphics_family].queueFlags & VK_QUEUE_COMPUTE_BIT)){
+        compute_family = graphics_family;
+    }
+}
+
+void device_t::select_features(){
+    VkPhysicalDeviceFeatures supported_features;
+    vkGetPhysicalDeviceFeatures(physical_device, &supported_features);
+
+    // software devices may lack anisotropic filtering, which is never sampled anyway
+    features = {};
+    features.samplerAnisotropy       = supported_features.samplerAnisotropy;
+    features.pipelineStatisticsQuery = supported_features.pipelineStatisticsQuery;
 }
 
 VkDevice device_t::create_device(std::vector<const char *> enabled_validation_layers) const {
     std::vector<VkDeviceQueueCreateInfo> queue_create_infos;
-    std::set<uint32_t> unique_queue_families = { graphics_family, present_family, compute_family };
+    std::set<uint32_t> unique_queue_families = { graphics_family, compute_family };
+    if (!is_headless){
+        unique_queue_families.insert(present_family);
+    }
     
     float queue_priority = 1.0f;
     VkDeviceQueueCreateInfo queue_create_info = {};
@@ -152,16 +217,14 @@ VkDevice device_t::create_device(std::vector<const char *> enabled_validation_la
         queue_create_infos.push_back(queue_create_info);
     }
 
-    VkPhysicalDeviceFeatures device_features = {};
-    device_features.samplerAnisotropy        = VK_TRUE;
-
     VkDeviceCreateInfo create_info      = {};
     create_info.sType                   = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     create_info.pQueueCreateInfos       = queue_create_infos.data();
     create_info.queueCreateInfoCount    = static_cast<uint32_t>(queue_create_infos.size());
-    create_info.pEnabledFeatures        = &device_features;
-    create_info.enabledExtensionCount   = device_extensions.size();
-    create_info.ppEnabledExtensionNames = device_extensions.data();
+    create_info.pEnabledFeatures        = &features;
+    auto extensions = get_device_extensions();
+    create_info.enabledExtensionCount   = extensions.size();
+    create_info.ppEnabledExtensionNames = extensions.data();
     create_info.enabledLayerCount       = static_cast<uint32_t>(enabled_validation_layers.size());
     create_info.ppEnabledLayerNames     = enabled_validation_layers.data();
 
@@ -196,3 +259,15 @@ uint32_t device_t::get_graphics_family() const {
 uint32_t device_t::get_present_family() const {
     return present_family;
 }
+
+bool device_t::get_is_headless() const {
+    return is_headless;
+}
+
+bool device_t::has_async_compute() const {
+    return !is_headless && compute_family != graphics_family;
+}
+
+const VkPhysicalDeviceFeatures & device_t::get_features() const {
+    return features;
+}
@@ -0,0 +1,274 @@
+#include "core/scene.h"
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "maths/sdf/platonic.h"
+#include "maths/sdf/primitive.h"
+
+static_assert(sizeof(srph_scene_header) % 8 == 0, "Scene header must preserve record alignment");
+static_assert(sizeof(srph_scene_sdf) % 8 == 0, "Scene sdf records must be eight byte aligned");
+static_assert(sizeof(srph_scene_material) % 8 == 0, "Scene material records must be eight byte aligned");
+static_assert(sizeof(srph_scene_substance) % 8 == 0, "Scene substance records must be eight byte aligned");
+
+static uint32_t parameter_count(uint32_t type){
+    switch (type){
+        case SRPH_SDF_TYPE_SPHERE:     return 1;
+        case SRPH_SDF_TYPE_TORUS:      return 2;
+        case SRPH_SDF_TYPE_CUBOID:     return 3;
+        case SRPH_SDF_TYPE_OCTAHEDRON: return 1;
+        default:                       return 0;
+    }
+}
+
+static bool is_table_valid(const srph_scene * scene, uint64_t offset, uint64_t count, size_t record_size){
+    return
+        offset % 8 == 0 && offset >= sizeof(srph_scene_header) && offset <= scene->_size &&
+        count <= (scene->_size - offset) / record_size;
+}
+
+uint32_t srph_scene_writer_add_sdf(srph_scene_writer * w, const srph_sdf * sdf){
+    assert(w != NULL && sdf != NULL);
+
+    uint32_t n = parameter_count(sdf->type);
+    if (n == 0){
+        return SRPH_SCENE_INVALID_INDEX;
+    }
+
+    srph_scene_sdf s = {};
+    s.type = sdf->type;
+    memcpy(s.parameters, sdf->_data, n * sizeof(double));
+
+    w->sdfs.push_back(s);
+    return w->sdfs.size() - 1;
+}
+
+uint32_t srph_scene_writer_add_material(srph_scene_writer * w, const srph_material * material){
+    assert(w != NULL && material != NULL);
+
+    srph_scene_material s;
+    memcpy(s.colour, material->colour.raw, sizeof(s.colour));
+    s.density = material->density;
+    s.restitution = material->restitution;
+    s.static_friction = material->static_friction;
+    s.dynamic_friction = material->dynamic_friction;
+
+    w->materials.push_back(s);
+    return w->materials.size() - 1;
+}
+
+void srph_scene_writer_add_substance(
+    srph_scene_writer * w, uint32_t sdf, uint32_t material, const srph_matter * matter
+){
+    assert(w != NULL && matter != NULL);
+    assert(sdf < w->sdfs.size() && material < w->materials.size());
+
+    srph_scene_substance s = {};
+    s.sdf = sdf;
+    s.material = material;
+    s.is_uniform = matter->is_uniform;
+
+    srph::vec3_t x = matter->get_position();
+    srph::quat_t q = matter->get_rotation();
+    for (int i = 0; i < 3; i++){
+        s.position[i] = x[i];
+        s.v[i] = matter->v[i];
+        s.omega[i] = matter->omega[i];
+    }
+
+    for (int i = 0; i < 4; i++){
+        s.rotation[i] = q[i];
+    }
+
+    w->substances.push_back(s);
+}
+
+bool srph_scene_writer_save(const srph_scene_writer * w, const char * path){
+    assert(w != NULL && path != NULL);
+
+    srph_scene_header header = {};
+    header.magic = SRPH_SCENE_MAGIC;
+    header.version = SRPH_SCENE_VERSION;
+    header.num_sdfs = w->sdfs.size();
+    header.num_materials = w->materials.size();
+    header.num_substances = w->substances.size();
+
+    header.sdf_offset = sizeof(srph_scene_header);
+    header.material_offset = header.sdf_offset + w->sdfs.size() * sizeof(srph_scene_sdf);
+    header.substance_offset = header.material_offset + w->materials.size() * sizeof(srph_scene_material);
+
+    FILE * file = fopen(path, "wb");
+    if (file == NULL){
+        return false;
+    }
+
+    bool is_written =
+        fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(w->sdfs.data(), sizeof(srph_scene_sdf), w->sdfs.size(), file) == w->sdfs.size() &&
+        fwrite(w->materials.data(), sizeof(srph_scene_material), w->materials.size(), file) == w->materials.size() &&
+        fwrite(w->substances.data(), sizeof(srph_scene_substance), w->substances.size(), file) == w->substances.size();
+
+    return fclose(file) == 0 && is_written;
+}
+
+bool srph_scene_open(srph_scene * scene, const char * path){
+    assert(scene != NULL && path != NULL);
+
+    *scene = {};
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < sizeof(srph_scene_header)){
+        close(fd);
+        return false;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    void * map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED){
+        return false;
+    }
+
+    scene->_map = map;
+    scene->_size = info.st_size;
+
+    const srph_scene_header * header = (const srph_scene_header *) map;
+    bool is_valid =
+        header->magic == SRPH_SCENE_MAGIC && header->version == SRPH_SCENE_VERSION &&
+        is_table_valid(scene, header->sdf_offset, header->num_sdfs, sizeof(srph_scene_sdf)) &&
+        is_table_valid(scene, header->material_offset, header->num_materials, sizeof(srph_scene_material)) &&
+        is_table_valid(scene, header->substance_offset, header->num_substances, sizeof(srph_scene_substance));
+
+    if (!is_valid){
+        srph_scene_close(scene);
+        return false;
+    }
+
+    // records are streamed once in file order
+    madvise(map, scene->_size, MADV_SEQUENTIAL);
+
+    const char * base = (const char *) map;
+    scene->header = header;
+    scene->sdfs = (const srph_scene_sdf *) (base + header->sdf_offset);
+    scene->materials = (const srph_scene_material *) (base + header->material_offset);
+    scene->substances = (const srph_scene_substance *) (base + header->substance_offset);
+
+    return true;
+}
+
+void srph_scene_close(srph_scene * scene){
+    if (scene != NULL && scene->_map != NULL){
+        munmap(scene->_map, scene->_size);
+        *scene = {};
+    }
+}
+
+srph_sdf * srph_scene_sdf_create(const srph_scene_sdf * s){
+    assert(s != NULL);
+
+    const double * p = s->parameters;
+    switch (s->type){
+        case SRPH_SDF_TYPE_SPHERE:
+            return srph_sdf_sphere_create(p[0]);
+        case SRPH_SDF_TYPE_TORUS:
+            return srph_sdf_torus_create(p[0], p[1]);
+        case SRPH_SDF_TYPE_CUBOID: {
+            vec3 r = { p[0], p[1], p[2] };
+            return srph_sdf_cuboid_create(&r);
+        }
+        case SRPH_SDF_TYPE_OCTAHEDRON:
+            return srph_sdf_octahedron_create(p[0]);
+        default:
+            return NULL;
+    }
+}
+
+void srph_scene_material_read(const srph_scene_material * s, srph_material * material){
+    assert(s != NULL && material != NULL);
+
+    memcpy(material->colour.raw, s->colour, sizeof(s->colour));
+    material->density = s->density;
+    material->restitution = s->restitution;
+    material->static_friction = s->static_friction;
+    material->dynamic_friction = s->dynamic_friction;
+}
+
+void srph_scene_matter_init(
+    const srph_scene_substance * s, srph_sdf * sdf, const srph_material * material, srph_matter * m
+){
+    assert(s != NULL && m != NULL);
+
+    // rotate first so that vertices are placed with the full transform
+    m->transform = srph_transform();
+    m->transform.rotate(srph::quat_t(s->rotation[0], s->rotation[1], s->rotation[2], s->rotation[3]));
+
+    vec3 x = { s->position[0], s->position[1], s->position[2] };
+    srph_matter_init(m, sdf, material, &x, s->is_uniform);
+
+    m->v = srph::vec3_t(s->v[0], s->v[1], s->v[2]);
+    m->omega = srph::vec3_t(s->omega[0], s->omega[1], s->omega[2]);
+}
+
+bool srph_scene_read_substances(
+    const char * path, std::vector<srph_sdf *> * sdfs, std::vector<std::shared_ptr<srph::substance_t>> * substances
+){
+    assert(path != NULL && sdfs != NULL && substances != NULL);
+
+    srph_scene scene;
+    if (!srph_scene_open(&scene, path)){
+        return false;
+    }
+
+    // indices are checked up front, so that nothing has been created when one is bad
+    const srph_scene_header * header = scene.header;
+    for (uint32_t i = 0; i < header->num_substances; i++){
+        const srph_scene_substance * s = &scene.substances[i];
+        if (s->sdf >= header->num_sdfs || s->material >= header->num_materials){
+            srph_scene_close(&scene);
+            return false;
+        }
+    }
+
+    std::vector<srph_sdf *> scene_sdfs(header->num_sdfs);
+    for (uint32_t i = 0; i < header->num_sdfs; i++){
+        scene_sdfs[i] = srph_scene_sdf_create(&scene.sdfs[i]);
+        if (scene_sdfs[i] == NULL){
+            for (uint32_t j = 0; j < i; j++){
+                srph_sdf_destroy(scene_sdfs[j]);
+            }
+            srph_scene_close(&scene);
+            return false;
+        }
+    }
+
+    std::vector<srph_material> materials(header->num_materials);
+    for (uint32_t i = 0; i < header->num_materials; i++){
+        srph_scene_material_read(&scene.materials[i], &materials[i]);
+    }
+
+    substances->reserve(substances->size() + header->num_substances);
+
+    srph_form form;
+    srph_matter matter;
+    for (uint32_t i = 0; i < header->num_substances; i++){
+        const srph_scene_substance * s = &scene.substances[i];
+        srph_scene_matter_init(s, scene_sdfs[s->sdf], &materials[s->material], &matter);
+        substances->push_back(std::make_shared<srph::substance_t>(&form, &matter));
+        srph_matter_destroy(&matter);
+    }
+
+    srph_scene_close(&scene);
+
+    sdfs->insert(sdfs->end(), scene_sdfs.begin(), scene_sdfs.end());
+    return true;
+}
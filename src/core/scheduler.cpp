@@ -1,5 +1,7 @@
 #include "core/scheduler.h"
 
+#include <atomic>
+
 using namespace srph::scheduler;
 
 bool quit = true;
@@ -42,13 +44,12 @@ void thread_pool_function(){
             }
         }
 
-        std::unique_lock<std::mutex> cv_lock(cv_mutex);
-        if (is_queue_empty){
-            cv.wait(cv_lock);
-        } else if (is_task_ready){
+        if (is_task_ready){
+            // run without holding any locks so that tasks execute concurrently
             (*task.f)();
             
             if (task.is_repeatable && *task.is_repeatable && !quit){
+                std::lock_guard<std::mutex> task_queue_lock(task_queue_mutex);
                 task_queue.emplace(
                     task.t + task.period, 
                     task.f,
@@ -58,7 +59,12 @@ void thread_pool_function(){
             }
                 
         } else {
-            cv.wait_until(cv_lock, task.t);
+            std::unique_lock<std::mutex> cv_lock(cv_mutex);
+            if (is_queue_empty){
+                cv.wait(cv_lock);
+            } else {
+                cv.wait_until(cv_lock, task.t);
+            }
         }
     }
 
@@ -91,6 +97,52 @@ void srph::scheduler::terminate(){
     }
 }
 
+void srph::scheduler::parallel_for(uint32_t n, const std::function<void(uint32_t, uint32_t)> & f){
+    uint32_t chunks = std::min(n, 4 * (number_of_threads + 1));
+    if (quit || chunks <= 1){
+        f(0, n);
+        return;
+    }
+
+    struct state_t {
+        std::atomic<uint32_t> next;
+        std::atomic<uint32_t> done;
+        std::mutex mutex;
+        std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<state_t>();
+    state->next = 0;
+    state->done = 0;
+
+    // chunks are claimed dynamically, so helpers that start late find nothing 
+    // to do and the caller never waits on a chunk that has not started
+    auto work = [state, chunks, n, &f](){
+        uint32_t c;
+        while ((c = state->next++) < chunks){
+            // in 64 bits, as n * c overflows once n reaches a few hundred million
+            f(
+                static_cast<uint32_t>(static_cast<uint64_t>(n) * c / chunks), 
+                static_cast<uint32_t>(static_cast<uint64_t>(n) * (c + 1) / chunks)
+            );
+
+            if (++state->done == chunks){
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->cv.notify_all();
+            }
+        }
+    };
+
+    for (uint32_t i = 0; i < number_of_threads; i++){
+        schedule_at(clock_t::now(), work);
+    }
+
+    work();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [state, chunks](){ return state->done == chunks; });
+}
+
 bool __private::task_t::comparator_t::operator()(const __private::task_t & a, const __private::task_t & b){
     return a.t > b.t;
 }
@@ -10,6 +10,7 @@
 #include <cstring>
 #include <memory>
 
+#include "core/scene.h"
 #include "core/scheduler.h"
 #include "render/renderer.h"
 
@@ -21,24 +22,25 @@ const std::vector<const char *> validation_layers = {
 #endif
 };
 
-srph::seraphim_t::seraphim_t(){
+srph::seraphim_t::seraphim_t(bool is_headless, bool is_async_compute_allowed){
+    this->is_headless = is_headless;
+
 #if SERAPHIM_DEBUG
     std::cout << "Running in debug mode." << std::endl;
 #else 
     std::cout << "Running in release mode." << std::endl;
 #endif
 
-    work_group_count = u32vec2_t(48u, 20u);
-    work_group_size = u32vec2_t(32u);
+    // the renderer picks a work group shape that divides this evenly
+    resolution = u32vec2_t(1536u, 640u);
 
-    if (!glfwInit()){
-        throw std::runtime_error("Error: Failed to initialise GLFW.");
-    }
+    if (!is_headless){
+        if (!glfwInit()){
+            throw std::runtime_error("Error: Failed to initialise GLFW.");
+        }
 
-    window = std::make_unique<window_t>(u32vec2_t(
-        work_group_count[0] * work_group_size[0],
-        work_group_count[1] * work_group_size[1]
-    ));
+        window = std::make_unique<window_t>(resolution);
+    }
 
     uint32_t extension_count = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &extension_count, nullptr);
@@ -58,11 +60,12 @@ srph::seraphim_t::seraphim_t(){
     }
 #endif
 
-    if (glfwCreateWindowSurface(instance, window->get_window(), nullptr, &surface) != VK_SUCCESS) {
+    surface = VK_NULL_HANDLE;
+    if (!is_headless && glfwCreateWindowSurface(instance, window->get_window(), nullptr, &surface) != VK_SUCCESS) {
 	    throw std::runtime_error("Error: Failed to create window surface.");
     }
 
-    device = std::make_unique<device_t>(instance, surface, validation_layers);
+    device = std::make_unique<device_t>(instance, surface, validation_layers, is_async_compute_allowed);
 
 #if SERAPHIM_DEBUG
     VkPhysicalDeviceProperties properties = {};
@@ -81,7 +84,7 @@ srph::seraphim_t::seraphim_t(){
     scheduler::initialise();
 
     renderer = std::make_unique<renderer_t>(
-        device.get(), surface, window.get(), test_camera, work_group_count, work_group_size, max_image_size
+        device.get(), surface, window.get(), test_camera, resolution, max_image_size
     );
 
     physics = std::make_unique<physics_t>();
@@ -118,14 +121,23 @@ void srph_cleanup(srph::seraphim_t * engine){
     }
 #endif
  
-    vkDestroySurfaceKHR(engine->instance, engine->surface, nullptr);
+    if (engine->surface != VK_NULL_HANDLE){
+        vkDestroySurfaceKHR(engine->instance, engine->surface, nullptr);
+    }
 
     // destroy instance
     vkDestroyInstance(engine->instance, nullptr);
 
     engine->window.reset();
 
-    glfwTerminate();
+    if (!engine->is_headless){
+        glfwTerminate();
+    }
+
+    for (auto sdf : engine->sdfs){
+        srph_sdf_destroy(sdf);
+    }
+    engine->sdfs.clear();
 
     printf("Seraphim engine exiting gracefully.\n");
 }
@@ -149,10 +161,13 @@ void seraphim_t::monitor_fps(){
 }
 
 std::vector<const char *> srph::seraphim_t::get_required_extensions(){
-    uint32_t      extension_count = 0;
-    const char ** glfw_extensions = glfwGetRequiredInstanceExtensions(&extension_count);
+    std::vector<const char *> required_extensions;
 
-    std::vector<const char *> required_extensions(glfw_extensions, glfw_extensions + extension_count);
+    if (!is_headless){
+        uint32_t      extension_count = 0;
+        const char ** glfw_extensions = glfwGetRequiredInstanceExtensions(&extension_count);
+        required_extensions.assign(glfw_extensions, glfw_extensions + extension_count);
+    }
 
 #if SERAPHIM_DEBUG
     required_extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
@@ -193,7 +208,7 @@ void srph::seraphim_t::create_instance(){
     app_info.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
     app_info.pEngineName = "Seraphim";
     app_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app_info.apiVersion = VK_MAKE_VERSION(1, 0, 0);
+    app_info.apiVersion = VK_API_VERSION_1_1;
 
     auto required_extensions = get_required_extensions(); 
     VkInstanceCreateInfo create_info = {};
@@ -298,20 +313,166 @@ void srph::seraphim_t::run(){
     }
 }
 
-void srph::seraphim_t::annihilate(std::shared_ptr<substance_t> substance){
-    renderer->unregister_substance(substance);
-    physics->unregister_matter(&substance->matter);
+void srph::seraphim_t::benchmark(uint32_t frames){
+    std::vector<double> cpu_times;
+    std::vector<double> gpu_times;
+
+    // churn in the patch pool, which settles once the orbit has seen the scene
+    uint64_t patch_requests = 0;
+    uint64_t patch_evictions = 0;
+    uint64_t dropped_lights = 0;
+
+    // time each queue waits on the other, averaged over the frames that measured it
+    double compute_idle = 0.0;
+    double graphics_idle = 0.0;
+    uint32_t idle_samples = 0;
+
+    // orbit the origin, looking inwards, once over the run
+    double radius = 8.0;
+    double height = 2.0;
+
+    if (!is_headless){
+        window->show();
+    }
+
+    for (uint32_t i = 0; i < frames; i++){
+        if (!is_headless){
+            glfwPollEvents();
+        }
+
+        double theta = 2.0 * constant::pi * i / std::max(frames, 1u);
+        vec3_t x(-radius * sin(theta), height, -radius * cos(theta));
+        test_camera->set_pose(x, quat_t::angle_axis(theta, vec::view(srph_vec3_up)));
+
+        u32vec2_t render_size = renderer->get_render_size();
+
+        auto start = std::chrono::steady_clock::now();
+        renderer->render();
+        auto end = std::chrono::steady_clock::now();
+
+        double cpu_time = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+        cpu_times.push_back(cpu_time);
+        gpu_times.push_back(renderer->get_gpu_time());
+
+        if (auto sample = renderer->get_profiler().get_latest()){
+            patch_requests += sample->patch_requests;
+            patch_evictions += sample->patch_evictions;
+            dropped_lights += sample->dropped_lights;
+
+            if (sample->compute_idle >= 0 && sample->graphics_idle >= 0){
+                compute_idle += sample->compute_idle;
+                graphics_idle += sample->graphics_idle;
+                idle_samples++;
+            }
+        }
+
+        std::cout << 
+            "Frame " << i << ": CPU " << cpu_time << " ms; GPU " << gpu_times.back() << " ms; " << 
+            render_size[0] << "x" << render_size[1] << std::endl;
+    }
+
+    if (frames == 0){
+        return;
+    }
+
+    std::sort(cpu_times.begin(), cpu_times.end());
+    std::sort(gpu_times.begin(), gpu_times.end());
+
+    auto mean = [](const std::vector<double> & xs){
+        double total = 0.0;
+        for (double x : xs){
+            total += x;
+        }
+        return total / xs.size();
+    };
+
+    std::cout << 
+        "CPU: mean " << mean(cpu_times) << " ms, median " << cpu_times[frames / 2] << " ms, max " << cpu_times.back() << " ms" << std::endl <<
+        "GPU: mean " << mean(gpu_times) << " ms, median " << gpu_times[frames / 2] << " ms, max " << gpu_times.back() << " ms" << std::endl <<
+        "Patches: " << patch_requests << " requested, " << patch_evictions << " evicted" << std::endl <<
+        "Lights: " << dropped_lights << " dropped from full clusters" << std::endl;
+
+    // headless frames have no graphics queue to overlap with
+    if (idle_samples > 0){
+        std::cout << 
+            "Idle: compute mean " << compute_idle / idle_samples << " ms, graphics mean " << graphics_idle / idle_samples << " ms, " <<
+            (device->has_async_compute() ? "async" : "shared") << " compute queue" << std::endl;
+    }
+}
+
+void srph::seraphim_t::annihilate(handle_t substance){
+    srph_annihilate_substances(this, &substance, 1);
+}
+
+static void spawn(
+    seraphim_t * srph, const std::vector<std::shared_ptr<substance_t>> & substances, handle_t * handles
+){
+    std::vector<srph_matter *> matters;
+    matters.reserve(substances.size());
+
+    srph->substances.reserve(srph->substances.size() + substances.size());
+    for (uint32_t i = 0; i < substances.size(); i++){
+        handle_t h = srph->substances.insert(substances[i]);
+        if (handles != NULL){
+            handles[i] = h;
+        }
+        matters.push_back(&substances[i]->matter);
+    }
+
+    srph->renderer->register_substances(substances);
+    srph->physics->register_matters(matters);
+}
+
+handle_t srph_create_substance(seraphim_t * srph, srph_form * form, srph_matter * matter){
+    handle_t h;
+    srph_create_substances(srph, form, matter, 1, &h);
+    return h;
+}
+
+substance_t * srph_get_substance(seraphim_t * srph, handle_t substance){
+    auto s = srph->substances.get(substance);
+    return s == NULL ? NULL : s->get();
+}
+
+void srph_create_substances(
+    seraphim_t * srph, srph_form * form, srph_matter * matters, uint32_t n, handle_t * handles
+){
+    std::vector<std::shared_ptr<substance_t>> substances;
+    substances.reserve(n);
+    for (uint32_t i = 0; i < n; i++){
+        substances.push_back(std::make_shared<substance_t>(form, &matters[i]));
+    }
+
+    spawn(srph, substances, handles);
+}
 
-    auto it = substances.find(substance);
-    if (it != substances.end()){
-        substances.erase(it);
+void srph_annihilate_substances(seraphim_t * srph, const handle_t * handles, uint32_t n){
+    std::vector<std::shared_ptr<substance_t>> substances;
+    std::vector<srph_matter *> matters;
+    substances.reserve(n);
+    matters.reserve(n);
+
+    for (uint32_t i = 0; i < n; i++){
+        auto s = srph->substances.get(handles[i]);
+        if (s != NULL){
+            substances.push_back(*s);
+            matters.push_back(&(*s)->matter);
+            srph->substances.erase(handles[i]);
+        }
     }
+
+    // the batch keeps substances alive until both subsystems have let go
+    srph->physics->unregister_matters(matters);
+    srph->renderer->unregister_substances(substances);
 }
 
-substance_t * srph_create_substance(seraphim_t * srph, srph_form * form, srph_matter * matter){
-    auto substance = std::make_shared<substance_t>(form, matter);
-    srph->substances.insert(substance);
-    srph->renderer->register_substance(substance);
-    srph->physics->register_matter(&substance->matter);
-    return substance.get();
+bool srph_load_scene(seraphim_t * srph, const char * path){
+    std::vector<std::shared_ptr<substance_t>> substances;
+    if (!srph_scene_read_substances(path, &srph->sdfs, &substances)){
+        return false;
+    }
+
+    spawn(srph, substances, NULL);
+
+    return true;
 }
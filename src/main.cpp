@@ -1,14 +1,17 @@
+#include <iostream>
+#include <string>
+
+#include "core/random.h"
 #include "core/seraphim.h"
 #include "core/scheduler.h"
 #include "maths/sdf/primitive.h"
 #include "maths/sdf/platonic.h"
+#include "physics/lattice.h"
 #include "physics/transform.h"
 
 using namespace srph;
 
-int main(){
-    srph::seraphim_t engine;
-
+static void create_default_scene(srph::seraphim_t * engine){
     srph_material material;
     material.static_friction = 0.2;
     material.dynamic_friction = 0.1;
@@ -24,7 +27,7 @@ int main(){
     vec3 position = { 0.0, -100.0, 0.0 };
     srph_matter floor_matter;
     srph_matter_init(&floor_matter, floor_sdf, &material, &position, true);
-    srph_create_substance(&engine, &form, &floor_matter);
+    srph_create_substance(engine, &form, &floor_matter);
 
     vec3 cube_size;
     srph_vec3_fill(&cube_size, 0.5);
@@ -33,17 +36,140 @@ int main(){
     position = { 0.0, 3.0, 0.0 };
     srph_matter cube_matter;
     srph_matter_init(&cube_matter, cube_sdf, &material, &position, true);
-    srph_create_substance(&engine, &form, &cube_matter);
-
-    engine.run();
-
-    srph_cleanup(&engine);
+    srph_create_substance(engine, &form, &cube_matter);
 
+    // the substances hold their own references to the sdfs
     srph_matter_destroy(&floor_matter);
     srph_matter_destroy(&cube_matter);
 
     srph_sdf_destroy(floor_sdf);
     srph_sdf_destroy(cube_sdf);
+}
+
+// scenes carry no lights yet, so every scene gets the light the renderer used to hard-code,
+// and optionally a field of dim lights scattered over the floor
+static void create_lights(srph::seraphim_t * engine, uint32_t n){
+    std::vector<std::shared_ptr<light_t>> lights;
+    lights.push_back(std::make_shared<light_t>(f32vec3_t(0.0f, 4.0f, -4.0f), f32vec4_t(50.0f)));
+
+    srph_random random;
+    srph_random_default_seed(&random);
+
+    for (uint32_t i = 0; i < n; i++){
+        f32vec3_t x(
+            srph_random_f64_range(&random, -50.0, 50.0),
+            srph_random_f64_range(&random, 0.5, 5.0),
+            srph_random_f64_range(&random, -50.0, 50.0)
+        );
+
+        f32vec4_t colour(
+            srph_random_f64_range(&random, 0.0, 1.0),
+            srph_random_f64_range(&random, 0.0, 1.0),
+            srph_random_f64_range(&random, 0.0, 1.0),
+            0.0
+        );
+
+        lights.push_back(std::make_shared<light_t>(x, colour));
+    }
+
+    engine->renderer->register_lights(lights);
+}
+
+// a square of cloth pinned along one edge, which falls onto the top of the floor. it is
+// simulated by the vertex solver but not drawn
+static void create_cloth(srph::seraphim_t * engine, srph_lattice * cloth, uint32_t n){
+    vec3 x = { -1.0, 5.0, -1.0 };
+    vec3 u = { 2.0 / n, 0.0, 0.0 };
+    vec3 v = { 0.0, 0.0, 2.0 / n };
+    srph_lattice_create(cloth, n, n, &x, &u, &v, INFINITY);
+
+    for (uint32_t i = 0; i < n; i++){
+        srph_lattice_pin(cloth, i, 0);
+    }
+
+    vec3 up = { 0.0, 1.0, 0.0 };
+    srph_lattice_add_plane(cloth, &up, 0.0);
+
+    engine->physics->register_constraints(cloth->constraints);
+}
+
+int main(int argc, char ** argv){
+    bool is_headless = false;
+    bool is_benchmark = false;
+    bool is_async_compute_allowed = true;
+    uint32_t frames = 300;
+    const char * scene = nullptr;
+    const char * profile = nullptr;
+    double budget = -1.0;
+    uint32_t lights = 0;
+    uint32_t cloth_size = 0;
+
+    for (int i = 1; i < argc; i++){
+        std::string arg = argv[i];
+        if (arg == "--headless"){
+            is_headless = true;
+        } else if (arg == "--benchmark"){
+            is_benchmark = true;
+        } else if (arg == "--sync-compute"){
+            is_async_compute_allowed = false;
+        } else if (arg == "--frames" && i + 1 < argc){
+            frames = std::stoul(argv[++i]);
+        } else if (arg == "--profile" && i + 1 < argc){
+            profile = argv[++i];
+        } else if (arg == "--budget" && i + 1 < argc){
+            budget = std::stod(argv[++i]);
+        } else if (arg == "--lights" && i + 1 < argc){
+            lights = std::stoul(argv[++i]);
+        } else if (arg == "--cloth" && i + 1 < argc){
+            cloth_size = std::stoul(argv[++i]);
+        } else {
+            scene = argv[i];
+        }
+    }
+
+    srph::seraphim_t engine(is_headless, is_async_compute_allowed);
+
+    if (scene != nullptr){
+        if (!srph_load_scene(&engine, scene)){
+            std::cout << "Error: Failed to load scene " << scene << std::endl;
+            srph_cleanup(&engine);
+            return 1;
+        }
+    } else {
+        create_default_scene(&engine);
+    }
+
+    create_lights(&engine, lights);
+
+    srph_lattice cloth;
+    if (cloth_size > 0){
+        create_cloth(&engine, &cloth, cloth_size);
+    }
+
+    // a budget of zero renders at full resolution every frame
+    if (budget >= 0){
+        engine.renderer->set_frame_budget(budget);
+    }
+
+    // headless runs always benchmark, and windowed ones can, to compare queue idle time
+    // with and without --sync-compute
+    if (is_headless || is_benchmark){
+        engine.benchmark(frames);
+    } else {
+        engine.run();
+    }
+
+    if (profile != nullptr && !engine.renderer->get_profiler().save_csv(profile)){
+        std::cout << "Error: Failed to write profile " << profile << std::endl;
+    }
+
+    // the physics thread lets go of the constraints before their vertices are freed
+    if (cloth_size > 0){
+        engine.physics->unregister_constraints(cloth.constraints);
+        srph_lattice_destroy(&cloth);
+    }
+
+    srph_cleanup(&engine);
 
     return 0;
 }
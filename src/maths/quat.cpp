@@ -22,9 +22,9 @@ quat_t quat_t::angle_axis(double angle, const vec3_t & a){
 }
 
 quat_t quat_t::euler_angles(const vec3_t & e){
-    vec3 e1 = { e[0], e[1], e[2] };
-    srph_vec3_normalise(&e1, &e1);
-    return angle_axis(vec::length(e), vec3_t(e1.x, e1.y, e1.z));
+    vec3 e1;
+    srph_vec3_normalise(&e1, &vec::view(e));
+    return angle_axis(vec::length(e), vec::view(e1));
 }
 
 quat_t quat_t::inverse() const {
@@ -65,6 +65,7 @@ srph_sdf * srph_sdf_cuboid_create(const vec3 * r){
     *r_ptr = *r;
 
     srph_sdf_create(sdf, cuboid_phi, r_ptr); 
+    sdf->type = SRPH_SDF_TYPE_CUBOID;
     return sdf;
 }
 
@@ -82,5 +83,6 @@ srph_sdf * srph_sdf_octahedron_create(double e){
     *e2 = e;
 
     srph_sdf_create(sdf, octahedron_phi, e2);
+    sdf->type = SRPH_SDF_TYPE_OCTAHEDRON;
     return sdf;
 }
@@ -30,6 +30,7 @@ srph_sdf * srph_sdf_sphere_create(double r){
     *r2 = r;
 
     srph_sdf_create(sdf, sphere_phi, r2); 
+    sdf->type = SRPH_SDF_TYPE_SPHERE;
 
     return sdf;
 }
@@ -49,6 +50,7 @@ srph_sdf * srph_sdf_torus_create(double r1, double r2){
     rs[1] = r2;
     
     srph_sdf_create(sdf, torus_phi, rs); 
+    sdf->type = SRPH_SDF_TYPE_TORUS;
 
     return sdf;
 }
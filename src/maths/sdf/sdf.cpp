@@ -5,6 +5,8 @@
 #include <assert.h>
 #include <stdlib.h>
 
+#include <new>
+
 #include "core/random.h"
 #include "maths/sdf/primitive.h"
 #include "physics/sphere.h"
@@ -12,12 +14,19 @@
 #define VOLUME_SAMPLES 10000
 #define SUPPORT_ALPHA 0.5
 #define SAMPLE_DENSITY 0.1
+#define EVICTION_CANDIDATES 8
+#define NULL_INDEX (~0u)
 
 void srph_sdf_create(srph_sdf * sdf, srph_sdf_func phi, void * data){
     if (sdf == NULL){
         return;
     }
 
+    static std::atomic<uint32_t> next_id(0);
+    sdf->id = next_id++;
+    new (&sdf->_references) std::atomic<uint32_t>(1);
+
+    sdf->type = SRPH_SDF_TYPE_CUSTOM;
     sdf->_phi = phi;
     sdf->_data = data;
     
@@ -26,7 +35,13 @@ void srph_sdf_create(srph_sdf * sdf, srph_sdf_func phi, void * data){
     sdf->_is_inertia_tensor_valid = false;
     sdf->_volume = -1.0;
 
-    srph_array_create(&sdf->vertices, sizeof(vec3));
+    // sdfs are malloc'd by their creators, so construct the arrays in place
+    new (&sdf->vertices) srph::small_array_t<vec3>();
+    new (&sdf->_links) srph::small_array_t<srph_sdf_link>();
+    new (&sdf->_buckets) srph::small_array_t<uint32_t>();
+
+    sdf->_cursor = 0;
+    srph_sdf_set_max_vertices(sdf, SRPH_SDF_DEFAULT_MAX_VERTICES);
 }
 
 srph::mat3_t srph_sdf_inertia_tensor(srph_sdf * sdf){
@@ -220,31 +235,181 @@ srph_bound3 * srph_sdf_bound(srph_sdf * sdf){
     return &sdf->_bound;
 }
 
-void srph_sdf_destroy(srph_sdf * sdf){
+srph_sdf * srph_sdf_acquire(srph_sdf * sdf){
     if (sdf != NULL){
+        sdf->_references++;
+    }
+    return sdf;
+}
+
+// releases a reference, freeing the sdf once the last one is gone
+void srph_sdf_destroy(srph_sdf * sdf){
+    if (sdf != NULL && --sdf->_references == 0){
         if (sdf->_data != NULL){
             free(sdf->_data);
         }
 
-        srph_array_destroy(&sdf->vertices);
+        sdf->vertices.~small_array_t();
+        sdf->_links.~small_array_t();
+        sdf->_buckets.~small_array_t();
+        sdf->_references.~atomic();
         
         free(sdf);
     }
 }
 
+static vec3 * vertex_at(srph_sdf * sdf, uint32_t i){
+    return &sdf->vertices[i];
+}
+
+static srph_sdf_link * link_at(srph_sdf * sdf, uint32_t i){
+    return &sdf->_links[i];
+}
+
+static uint32_t * bucket_at(srph_sdf * sdf, int64_t x, int64_t y, int64_t z){
+    uint64_t h = ((uint64_t) x * 73856093) ^ ((uint64_t) y * 19349663) ^ ((uint64_t) z * 83492791);
+    return &sdf->_buckets[h & (sdf->_buckets.size() - 1)];
+}
+
+static int64_t cell(double x){
+    return (int64_t) floor(x / SAMPLE_DENSITY);
+}
+
+static uint32_t * bucket_of(srph_sdf * sdf, const vec3 * x){
+    return bucket_at(sdf, cell(x->x), cell(x->y), cell(x->z));
+}
+
+static void link_vertex(srph_sdf * sdf, uint32_t i){
+    uint32_t * head = bucket_of(sdf, vertex_at(sdf, i));
+    link_at(sdf, i)->next = *head;
+    *head = i;
+}
+
+static void unlink_vertex(srph_sdf * sdf, uint32_t i){
+    uint32_t * j = bucket_of(sdf, vertex_at(sdf, i));
+    while (*j != i){
+        assert(*j != NULL_INDEX);
+        j = &link_at(sdf, *j)->next;
+    }
+    *j = link_at(sdf, i)->next;
+}
+
+// counts the vertices within radius r of x
+static uint32_t count_neighbours(srph_sdf * sdf, const vec3 * x, double r){
+    int64_t d = (int64_t) ceil(r / SAMPLE_DENSITY);
+    int64_t cx = cell(x->x);
+    int64_t cy = cell(x->y);
+    int64_t cz = cell(x->z);
+    uint32_t count = 0;
+
+    for (int64_t i = cx - d; i <= cx + d; i++){
+        for (int64_t j = cy - d; j <= cy + d; j++){
+            for (int64_t k = cz - d; k <= cz + d; k++){
+                uint32_t v = *bucket_at(sdf, i, j, k);
+                while (v != NULL_INDEX){
+                    const vec3 * y = vertex_at(sdf, v);
+                    if (cell(y->x) == i && cell(y->y) == j && cell(y->z) == k && srph_vec3_distance(x, y) < r){
+                        count++;
+                    }
+                    v = link_at(sdf, v)->next;
+                }
+            }
+        }
+    }
+
+    return count;
+}
+
+static bool has_neighbour(srph_sdf * sdf, const vec3 * x){
+    int64_t cx = cell(x->x);
+    int64_t cy = cell(x->y);
+    int64_t cz = cell(x->z);
+
+    for (int64_t i = cx - 1; i <= cx + 1; i++){
+        for (int64_t j = cy - 1; j <= cy + 1; j++){
+            for (int64_t k = cz - 1; k <= cz + 1; k++){
+                uint32_t v = *bucket_at(sdf, i, j, k);
+                while (v != NULL_INDEX){
+                    if (srph_vec3_distance(x, vertex_at(sdf, v)) < SAMPLE_DENSITY){
+                        return true;
+                    }
+                    v = link_at(sdf, v)->next;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+static void remove_vertex(srph_sdf * sdf, uint32_t i){
+    uint32_t last = sdf->vertices.size() - 1;
+    unlink_vertex(sdf, i);
+
+    if (i != last){
+        unlink_vertex(sdf, last);
+        *vertex_at(sdf, i) = *vertex_at(sdf, last);
+        link_vertex(sdf, i);
+    }
+
+    sdf->vertices.pop_back();
+    sdf->_links.pop_back();
+}
+
+// evicts the sample with the most redundant surface coverage from a rotating
+// window of candidates, so that sparse regions of the surface are kept
+static void evict_vertex(srph_sdf * sdf){
+    uint32_t size = sdf->vertices.size();
+    uint32_t victim = sdf->_cursor % size;
+    uint32_t victim_count = 0;
+
+    for (uint32_t c = 0; c < EVICTION_CANDIDATES && c < size; c++){
+        uint32_t i = (sdf->_cursor + c) % size;
+        uint32_t count = count_neighbours(sdf, vertex_at(sdf, i), 2.0 * SAMPLE_DENSITY);
+        if (count > victim_count){
+            victim = i;
+            victim_count = count;
+        }
+    }
+
+    sdf->_cursor = (sdf->_cursor + EVICTION_CANDIDATES) % size;
+    remove_vertex(sdf, victim);
+}
+
+void srph_sdf_set_max_vertices(srph_sdf * sdf, uint32_t max_vertices){
+    assert(sdf != NULL && max_vertices > 0);
+    sdf->max_vertices = max_vertices;
+
+    while (sdf->vertices.size() > max_vertices){
+        evict_vertex(sdf);
+    }
+
+    // rehash with a power of two number of buckets, at least twice the capacity
+    uint32_t buckets = 64;
+    while (buckets < 2 * max_vertices){
+        buckets *= 2;
+    }
+
+    sdf->_buckets.clear();
+    sdf->_buckets.resize(buckets, NULL_INDEX);
+
+    for (uint32_t i = 0; i < sdf->vertices.size(); i++){
+        link_vertex(sdf, i);
+    }
+}
+
 void srph_sdf_add_sample(srph_sdf * sdf, const vec3 * x){
     assert(sdf != NULL);
 
-    if (!srph_sdf_contains(sdf, x)){
+    if (!srph_sdf_contains(sdf, x) || has_neighbour(sdf, x)){
         return;
     }
 
-    for (uint32_t i = 0; i < sdf->vertices.size; i++){
-        const vec3 * y = (vec3 *) srph_array_at(&sdf->vertices, i);
-        if (srph_vec3_distance(x, y) < SAMPLE_DENSITY){
-            return;
-        }
+    if (sdf->vertices.size() >= sdf->max_vertices){
+        evict_vertex(sdf);
     }
 
-    *((vec3 *) srph_array_push_back(&sdf->vertices)) = *x;
+    sdf->vertices.push_back(*x);
+    sdf->_links.push_back({ NULL_INDEX });
+    link_vertex(sdf, sdf->vertices.size() - 1);
 } 
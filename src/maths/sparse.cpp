@@ -0,0 +1,290 @@
+#include "maths/sparse.h"
+
+#include <assert.h>
+#include <float.h>
+#include <math.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "core/constant.h"
+#include "core/scheduler.h"
+#include "maths/matrix.h"
+
+using namespace srph;
+
+#define BLOCK_SIZE 3
+#define BLOCK_ELEMENTS (BLOCK_SIZE * BLOCK_SIZE)
+
+// rows per task below which multiplication is not worth splitting across threads
+#define PARALLEL_ROWS 256
+
+static void parallel_rows(uint32_t n, const std::function<void(uint32_t, uint32_t)> & f){
+    if (n < PARALLEL_ROWS){
+        f(0, n);
+    } else {
+        scheduler::parallel_for(n, f);
+    }
+}
+
+void srph_csr_create(srph_csr * a, srph_matrix * m){
+    assert(a != NULL && m != NULL);
+
+    a->width = m->width;
+    a->height = m->height;
+    a->row_offsets.assign(m->height + 1, 0);
+
+    // count the entries in each row, including the mirror of symmetric entries
+    for (auto & item : m->s){
+        uint32_t x = (uint32_t) (item.i % m->width);
+        uint32_t y = (uint32_t) (item.i / m->width);
+        a->row_offsets[y + 1]++;
+
+        if (m->_is_symmetric && x != y){
+            a->row_offsets[x + 1]++;
+        }
+    }
+
+    for (uint32_t y = 0; y < m->height; y++){
+        a->row_offsets[y + 1] += a->row_offsets[y];
+    }
+
+    a->columns.resize(a->row_offsets[m->height]);
+    a->values.resize(a->row_offsets[m->height]);
+
+    // items are ordered by row then column and symmetric items are stored in the 
+    // lower triangle, so each row receives its own entries before any mirrored 
+    // ones and all columns end up sorted
+    std::vector<uint32_t> next(a->row_offsets.begin(), a->row_offsets.end() - 1);
+    for (auto & item : m->s){
+        uint32_t x = (uint32_t) (item.i % m->width);
+        uint32_t y = (uint32_t) (item.i / m->width);
+
+        a->columns[next[y]] = x;
+        a->values[next[y]++] = item.a;
+
+        if (m->_is_symmetric && x != y){
+            a->columns[next[x]] = y;
+            a->values[next[x]++] = item.a;
+        }
+    }
+}
+
+void srph_bsr_create(srph_bsr * a, srph_matrix * m){
+    assert(a != NULL && m != NULL);
+    assert(m->width % BLOCK_SIZE == 0 && m->height % BLOCK_SIZE == 0);
+
+    srph_csr csr;
+    srph_csr_create(&csr, m);
+
+    a->block_width = m->width / BLOCK_SIZE;
+    a->block_height = m->height / BLOCK_SIZE;
+    a->row_offsets.assign(a->block_height + 1, 0);
+    a->columns.clear();
+    a->values.clear();
+
+    std::vector<uint32_t> block_columns;
+    for (uint32_t by = 0; by < a->block_height; by++){
+        // find the distinct block columns over the rows of this block row
+        block_columns.clear();
+        for (uint32_t y = by * BLOCK_SIZE; y < (by + 1) * BLOCK_SIZE; y++){
+            for (uint32_t j = csr.row_offsets[y]; j < csr.row_offsets[y + 1]; j++){
+                block_columns.push_back(csr.columns[j] / BLOCK_SIZE);
+            }
+        }
+
+        std::sort(block_columns.begin(), block_columns.end());
+        block_columns.erase(std::unique(block_columns.begin(), block_columns.end()), block_columns.end());
+
+        uint32_t offset = a->columns.size();
+        a->columns.insert(a->columns.end(), block_columns.begin(), block_columns.end());
+        a->values.resize(a->columns.size() * BLOCK_ELEMENTS, 0.0);
+        a->row_offsets[by + 1] = a->columns.size();
+
+        for (uint32_t y = by * BLOCK_SIZE; y < (by + 1) * BLOCK_SIZE; y++){
+            for (uint32_t j = csr.row_offsets[y]; j < csr.row_offsets[y + 1]; j++){
+                uint32_t x = csr.columns[j];
+                uint32_t b = offset + std::lower_bound(
+                    block_columns.begin(), block_columns.end(), x / BLOCK_SIZE
+                ) - block_columns.begin();
+
+                a->values[b * BLOCK_ELEMENTS + (x % BLOCK_SIZE) * BLOCK_SIZE + y % BLOCK_SIZE] = csr.values[j];
+            }
+        }
+    }
+}
+
+void srph_csr_multiply(const srph_csr * a, double * y, const double * x){
+    parallel_rows(a->height, [a, y, x](uint32_t begin, uint32_t end){
+        for (uint32_t row = begin; row < end; row++){
+            double s = 0.0;
+            for (uint32_t j = a->row_offsets[row]; j < a->row_offsets[row + 1]; j++){
+                s += a->values[j] * x[a->columns[j]];
+            }
+            y[row] = s;
+        }
+    });
+}
+
+void srph_bsr_multiply(const srph_bsr * a, double * y, const double * x){
+    parallel_rows(a->block_height, [a, y, x](uint32_t begin, uint32_t end){
+        for (uint32_t row = begin; row < end; row++){
+            double s[BLOCK_SIZE] = { 0.0, 0.0, 0.0 };
+
+            for (uint32_t j = a->row_offsets[row]; j < a->row_offsets[row + 1]; j++){
+                const double * block = a->values.data() + j * BLOCK_ELEMENTS;
+                const double * xj = x + a->columns[j] * BLOCK_SIZE;
+
+                for (uint32_t c = 0; c < BLOCK_SIZE; c++){
+                    for (uint32_t r = 0; r < BLOCK_SIZE; r++){
+                        s[r] += block[c * BLOCK_SIZE + r] * xj[c];
+                    }
+                }
+            }
+
+            for (uint32_t r = 0; r < BLOCK_SIZE; r++){
+                y[row * BLOCK_SIZE + r] = s[r];
+            }
+        }
+    });
+}
+
+static double dot(uint32_t n, const double * a, const double * b){
+    double s = 0.0;
+    for (uint32_t i = 0; i < n; i++){
+        s += a[i] * b[i];
+    }
+    return s;
+}
+
+typedef std::function<void(double *, const double *)> linear_func;
+
+static srph_pcg_result pcg(
+    uint32_t n, const linear_func & multiply, const linear_func & precondition,
+    double * x, const double * b, double tolerance, uint32_t max_iterations
+){
+    std::vector<double> r(n);
+    std::vector<double> z(n);
+    std::vector<double> p(n);
+    std::vector<double> ap(n);
+
+    multiply(r.data(), x);
+    for (uint32_t i = 0; i < n; i++){
+        r[i] = b[i] - r[i];
+    }
+
+    double threshold = tolerance * tolerance * std::max(dot(n, b, b), DBL_MIN);
+    double rr = dot(n, r.data(), r.data());
+
+    srph_pcg_result result = { 0, sqrt(rr) };
+    if (rr <= threshold){
+        return result;
+    }
+
+    precondition(z.data(), r.data());
+    p = z;
+    double rz = dot(n, r.data(), z.data());
+
+    for (result.iterations = 1; result.iterations <= max_iterations; result.iterations++){
+        multiply(ap.data(), p.data());
+
+        double pap = dot(n, p.data(), ap.data());
+        if (pap <= 0.0){
+            // breakdown, the matrix is not positive definite
+            break;
+        }
+
+        double alpha = rz / pap;
+        for (uint32_t i = 0; i < n; i++){
+            x[i] += alpha * p[i];
+            r[i] -= alpha * ap[i];
+        }
+
+        rr = dot(n, r.data(), r.data());
+        if (rr <= threshold){
+            break;
+        }
+
+        precondition(z.data(), r.data());
+        double rz_new = dot(n, r.data(), z.data());
+        double beta = rz_new / rz;
+        rz = rz_new;
+
+        for (uint32_t i = 0; i < n; i++){
+            p[i] = z[i] + beta * p[i];
+        }
+    }
+
+    result.iterations = std::min(result.iterations, max_iterations);
+    result.residual = sqrt(rr);
+    return result;
+}
+
+srph_pcg_result srph_csr_solve(
+    const srph_csr * a, double * x, const double * b, double tolerance, uint32_t max_iterations
+){
+    assert(a != NULL && a->width == a->height);
+
+    // jacobi preconditioner
+    std::vector<double> inverse_diagonal(a->height, 1.0);
+    for (uint32_t row = 0; row < a->height; row++){
+        for (uint32_t j = a->row_offsets[row]; j < a->row_offsets[row + 1]; j++){
+            if (a->columns[j] == row && a->values[j] != 0.0){
+                inverse_diagonal[row] = 1.0 / a->values[j];
+            }
+        }
+    }
+
+    return pcg(
+        a->height, 
+        [a](double * y, const double * x){ srph_csr_multiply(a, y, x); },
+        [&inverse_diagonal](double * z, const double * r){
+            for (uint32_t i = 0; i < inverse_diagonal.size(); i++){
+                z[i] = inverse_diagonal[i] * r[i];
+            }
+        },
+        x, b, tolerance, max_iterations
+    );
+}
+
+srph_pcg_result srph_bsr_solve(
+    const srph_bsr * a, double * x, const double * b, double tolerance, uint32_t max_iterations
+){
+    assert(a != NULL && a->block_width == a->block_height);
+
+    // block jacobi preconditioner, falling back to jacobi for nearly singular blocks
+    std::vector<mat3_t> inverse_diagonal(a->block_height, mat3_t::identity());
+    for (uint32_t row = 0; row < a->block_height; row++){
+        for (uint32_t j = a->row_offsets[row]; j < a->row_offsets[row + 1]; j++){
+            if (a->columns[j] == row){
+                mat3_t block;
+                std::copy(
+                    a->values.begin() + j * BLOCK_ELEMENTS, 
+                    a->values.begin() + (j + 1) * BLOCK_ELEMENTS, 
+                    block.begin()
+                );
+
+                if (fabs(mat::determinant(block)) > constant::epsilon){
+                    inverse_diagonal[row] = mat::inverse(block);
+                } else {
+                    for (uint32_t k = 0; k < BLOCK_SIZE; k++){
+                        double d = block.get(k, k);
+                        inverse_diagonal[row].set(k, k, d == 0.0 ? 1.0 : 1.0 / d);
+                    }
+                }
+            }
+        }
+    }
+
+    return pcg(
+        a->block_height * BLOCK_SIZE, 
+        [a](double * y, const double * x){ srph_bsr_multiply(a, y, x); },
+        [&inverse_diagonal](double * z, const double * r){
+            for (uint32_t i = 0; i < inverse_diagonal.size(); i++){
+                vec3_t zi = inverse_diagonal[i] * vec3_t(r[i * 3], r[i * 3 + 1], r[i * 3 + 2]);
+                std::copy(zi.begin(), zi.end(), z + i * 3);
+            }
+        },
+        x, b, tolerance, max_iterations
+    );
+}
@@ -1,16 +1,6 @@
 #include "metaphysics/matter.h"
 
-static void update_vertices(srph_matter * m){
-    while (m->_vertices.size < m->sdf->vertices.size){
-        vec3 * x_sdf = (vec3 *) srph_array_at(&m->sdf->vertices, m->_vertices.size);
-
-        srph_vertex * vertex = (srph_vertex *) srph_array_push_back(&m->_vertices);
-        vertex->_x_key = x_sdf;
-        vertex->w = 1.0; // TODO
-        srph_transform_to_global_space(&m->transform, &vertex->x, x_sdf);
-        srph_vec3_fill(&vertex->v, 0.0);
-    }
-}
+#include "core/constant.h"
 
 using namespace srph;
 
@@ -20,25 +10,26 @@ void srph_matter_init(
     srph_matter * m, srph_sdf * sdf, const srph_material * material, 
     const vec3 * x, bool is_uniform
 ){
-    m->sdf = sdf;
+    m->sdf = srph_sdf_acquire(sdf);
     m->material = *material;
     m->is_uniform = is_uniform;
     
-    m->transform.set_position(srph::vec3_t(x->x, x->y, x->z));
+    m->transform.set_position(srph::vec::view(*x));
 
     m->omega = vec3_t(0.01, 0.01, 0.01);
 
     m->_is_mass_calculated = false;
     m->_is_inertia_tensor_valid = false;
     m->_is_inv_inertia_tensor_valid = false;
-    
-    srph_array_create(&m->_vertices, sizeof(srph_vertex));
-    
-    update_vertices(m); // TODO: remove
+
+
+    m->_physics_index = ~0u;
+    m->_is_asleep = false;
 }
 
 void srph_matter_destroy(srph_matter * m){
-    srph_array_destroy(&m->_vertices);
+    srph_sdf_destroy(m->sdf);
+    m->sdf = NULL;
 }
 
 quat_t srph_matter::get_rotation() const {
@@ -65,16 +56,14 @@ void srph_matter_bound(const srph_matter * m, srph_bound3 * b){
     srph_bound3_create(b);
 
     srph_bound3 * sdf_bound = srph_sdf_bound(m->sdf);
+    vec3 xs[8];
     for (int i = 0; i < 8; i++){  
-        vec3 x1;
-        srph_bound3_vertex(sdf_bound, i, x1.raw);
-    
-        vec3_t x(x1.x, x1.y, x1.z);
-        x = m->transform.to_global_space(x);
-    
-        x1 = { x[0], x[1], x[2] };
+        srph_bound3_vertex(sdf_bound, i, xs[i].raw);
+    }
 
-        srph_bound3_capture(b, x1.raw);
+    srph_transform_to_global_space_array(&m->transform, xs, xs, 8);
+    for (int i = 0; i < 8; i++){  
+        srph_bound3_capture(b, xs[i].raw);
     }
 }
 
@@ -119,8 +108,7 @@ void srph_matter::calculate_centre_of_mass(){
 
 vec3_t srph_matter::get_centre_of_mass(){
     if (is_uniform){
-        vec3 * c = srph_sdf_com(sdf);
-        return vec3_t(c->x, c->y, c->z);
+        return vec::view(*srph_sdf_com(sdf));
     }
 
     if (!_is_mass_calculated){
@@ -156,18 +144,20 @@ void srph_matter::rotate(const quat_t & q){
 }
 
 void srph_matter::reset_acceleration() {
-    a = vec3_t(0.0, -9.8, 0.0);
+    a = vec3_t(0.0, -constant::gravity, 0.0);
+}
+
+void srph_matter::accelerate(double t){
+    v += a * t;
 }
 
 void srph_matter::physics_tick(double t){
-    // update position
-    transform.translate((a * 0.5 * t + v) * t);
+    // update position, with velocities that have already been accelerated and had
+    // contact impulses applied this tick
+    transform.translate(v * t);
     
-    // update rotation
-    transform.rotate(quat_t::euler_angles(omega * t));
-
-    // integrate accelerations into velocities
-    v += a * t;
+    // update rotation, which also moves the inertia tensor
+    rotate(quat_t::euler_angles(omega * t));
     
     if (transform.get_position()[1] < -90.0){
         transform.set_position(vec3_t(0.0, -100.0, 0.0));
@@ -220,14 +210,17 @@ void srph_matter_sphere_bound(const srph_matter * m, double t, srph_sphere * s){
     srph_bound3 * b = srph_sdf_bound(m->sdf);
     srph_bound3_midpoint(b, s->c.raw);
     
-    srph::vec3_t p1 = m->transform.get_position();
-    vec3 p = { p1[0], p1[1], p1[2] };
-    srph_vec3_add(&s->c, &s->c, &p);
+    srph::vec3_t p = m->transform.get_position();
+    srph_vec3_add(&s->c, &s->c, &srph::vec::view(p));
     
     vec3 r3;
     srph_bound3_radius(b, r3.raw);
     s->r = srph_vec3_length(&r3);
 
-    vec3 v1 = { m->v[0], m->v[1], m->v[2] };
-    s->r += srph_vec3_length(&v1) * t;
+    s->r += srph_vec3_length(&srph::vec::view(m->v)) * t;
+}
+
+void srph_matter_bounds_update(const srph_matter * m, double t, srph_matter_bounds * b){
+    srph_matter_sphere_bound(m, t, &b->sphere);
+    b->box = m->get_moving_bound(t);
 }
@@ -6,6 +6,8 @@ using namespace srph;
 
 substance_t::substance_t(uint32_t id) {
     this->id = id;
+    _renderer_index = ~0u;
+    matter.sdf = NULL;
 }
 
 substance_t::substance_t(srph_form * form, srph_matter * matter){
@@ -14,6 +16,14 @@ substance_t::substance_t(srph_form * form, srph_matter * matter){
     this->form = *form;
     this->matter = *matter;
     this->id = id++;
+    _renderer_index = ~0u;
+
+    // the copy holds its own reference to the shared sdf
+    srph_sdf_acquire(this->matter.sdf);
+}
+
+substance_t::~substance_t(){
+    srph_matter_destroy(&matter);
 }
 
 bool substance_t::comparator_t::operator()(std::shared_ptr<substance_t> a, std::shared_ptr<substance_t> b) const {
@@ -24,13 +34,23 @@ uint32_t substance_t::get_id() const {
     return id;
 }
 
+uint32_t substance_t::get_shape() const {
+    // uniform matter looks the same wherever its sdf is reused, so it shares patches by
+    // sdf, but matter that varies over its shape is keyed by its own id instead
+    if (matter.is_uniform){
+        return matter.sdf->id;
+    }
+    
+    return id | unique_shape_bit;
+}
+
 substance_t::data_t substance_t::get_data(const vec3_t & eye_position){
     vec3 r;
     srph_bound3_radius(srph_sdf_bound(matter.sdf), r.raw);
     vec3_t eye = matter.to_local_space(eye_position);
 
-    vec3 a = { eye[0], eye[1], eye[2] };
-    srph_vec3_abs(&a, &a);
+    vec3 a;
+    srph_vec3_abs(&a, &vec::view(eye));
 
     vec3 x;
     srph_vec3_subtract(&x, &a, &r);
@@ -38,13 +58,26 @@ substance_t::data_t substance_t::get_data(const vec3_t & eye_position){
     
     float near = srph_vec3_length(&x);
     
-    x = { eye[0], eye[1], eye[2] };
     srph_vec3_add(&x, &a, &r);
     
     float far = srph_vec3_length(&x);
 
+    // uniform matter is drawn with the albedo of its material over shared white patches,
+    // while other matter carries its colours in its own patches
+    vec3 c = matter.material.colour;
+    if (!matter.is_uniform){
+        srph_vec3_fill(&c, 1.0);
+    }
+
+    uint8_t colour[4] = {
+        static_cast<uint8_t>(fmax(0.0, fmin(c.x * 255.0, 255.0))),
+        static_cast<uint8_t>(fmax(0.0, fmin(c.y * 255.0, 255.0))),
+        static_cast<uint8_t>(fmax(0.0, fmin(c.z * 255.0, 255.0))),
+        255
+    };
+
     return data_t(
-        near, far,
+        near, far, get_shape(), *reinterpret_cast<uint32_t *>(colour),
         f32vec3_t(r.x, r.y, r.z),
         id,
         matter.get_matrix()
@@ -59,9 +92,14 @@ substance_t::data_t::data_t(){
     id = ~0;
 }
 
-substance_t::data_t::data_t(float near, float far, const f32vec3_t & r, uint32_t id, const f32mat4_t & transform){
+substance_t::data_t::data_t(
+    float near, float far, uint32_t shape, uint32_t colour, 
+    const f32vec3_t & r, uint32_t id, const f32mat4_t & transform
+){
     this->near = near;
     this->far = far;
+    this->shape = shape;
+    this->colour = colour;
     this->r = r;
     this->id = id;
     this->transform = transform;
@@ -39,21 +39,12 @@ static double time_to_collision_func(void * data, const vec3 * x){
     }
  
     vec3 n = srph_sdf_normal(a->sdf, &xa);
+    srph::vec3_t n1 = a->get_rotation() * srph::vec::view(n);
 
-    srph::vec3_t n1(n.x, n.y, n.z);
-    n1 = a->get_rotation() * n1;
+    const srph::vec3_t & x1 = srph::vec::view(*x);
+    srph::vec3_t vr = a->get_velocity(x1) - b->get_velocity(x1);
 
-    n = { n1[0], n1[1], n1[2] };
-
-    //TODO
-    srph::vec3_t x1(x->x, x->y, x->z);
-    srph::vec3_t va = a->get_velocity(x1);
-    srph::vec3_t vb = b->get_velocity(x1);
-    srph::vec3_t vr1 = va - vb;
-
-    vec3 vr = { vr1[0], vr1[2], vr1[2] };
-
-    double vrn = srph_vec3_dot(&vr, &n);
+    double vrn = srph::vec::dot(vr, n1);
 
     if (vrn <= 0){
         return DBL_MAX;
@@ -63,37 +54,43 @@ static double time_to_collision_func(void * data, const vec3 * x){
     return phi / vrn;        
 }
 
-static void find_contact_points(srph_array * xs, srph_matter * a, srph_matter * b){
-    for (uint32_t i = 0; i < a->sdf->vertices.size; i++){
-        vec3 * x = (vec3 *) srph_array_at(&a->sdf->vertices, i);
-        vec3 x_global, x_local_b;
-        srph_transform_to_global_space(&a->transform, &x_global, x);
-        srph_transform_to_local_space(&b->transform, &x_local_b, &x_global);
+static void find_contact_points(srph_contact_array * xs, srph_matter * a, srph_matter * b){
+    const uint32_t batch_size = 64;
+    vec3 x_global[batch_size];
+    vec3 x_local_b[batch_size];
+
+    const vec3 * vertices = a->sdf->vertices.data();
+    uint32_t size = a->sdf->vertices.size();
 
-        if (srph_sdf_contains(b->sdf, &x_local_b)){
-            *((vec3 *) srph_array_push_back(xs)) = x_global;
+    for (uint32_t i = 0; i < size; i += batch_size){
+        uint32_t n = std::min(batch_size, size - i);
+        srph_transform_to_global_space_array(&a->transform, x_global, vertices + i, n);
+        srph_transform_to_local_space_array(&b->transform, x_local_b, x_global, n);
+
+        for (uint32_t j = 0; j < n; j++){
+            if (srph_sdf_contains(b->sdf, &x_local_b[j])){
+                xs->push_back(x_global[j]);
+            }
         }
     }
 }
 
 using namespace srph;
 
-srph_collision::srph_collision(srph_matter * a, srph_matter * b){
+srph_collision::srph_collision(
+    srph_matter * a, srph_matter * b, 
+    const srph_matter_bounds * bounds_a, const srph_matter_bounds * bounds_b, srph_arena * arena
+) : 
+    xs(srph::arena_allocator_t<vec3>(arena))
+{
     this->a = a;
     this->b = b;
     is_intersecting = false;
     t = constant::sigma;
 
-    srph_sphere sa, sb;
-    srph_matter_sphere_bound(a, constant::sigma, &sa);
-    srph_matter_sphere_bound(b, constant::sigma, &sb);
-
-    if (srph_sphere_intersect(&sa, &sb)){
-        srph_bound3 bound_a = a->get_moving_bound(constant::sigma);
-        srph_bound3 bound_b = b->get_moving_bound(constant::sigma);
-
+    if (srph_sphere_intersect(&bounds_a->sphere, &bounds_b->sphere)){
         srph_bound3 bound_i;
-        srph_bound3_intersection(&bound_a, &bound_b, &bound_i);
+        srph_bound3_intersection(&bounds_a->box, &bounds_b->box, &bound_i);
 
         vec3 xs1[4];
         srph_bound3_vertex(&bound_i, 0, xs1[0].raw);
@@ -103,8 +100,7 @@ srph_collision::srph_collision(srph_matter * a, srph_matter * b){
 
         srph_opt_sample s;
         srph_opt_nelder_mead(&s, intersection_func, this, xs1, NULL);
-        depth = fabs(s.fx);
-        x = s.x; 
+        x = s.x;
 
         double iota = constant::iota;
         srph_opt_nelder_mead(&s, time_to_collision_func, this, xs1, &iota);
@@ -113,96 +109,48 @@ srph_collision::srph_collision(srph_matter * a, srph_matter * b){
     }
 
     if (is_intersecting){
-        srph_array xs;
-        srph_array_create(&xs, sizeof(vec3));
-
         find_contact_points(&xs, a, b);
         find_contact_points(&xs, b, a);
-        
-        vec3 cx = srph_vec3_zero;
-        for (uint32_t i = 0; i < xs.size; i++){
-            srph_vec3_add(&cx, &cx, (vec3 *) srph_array_at(&xs, i));  
-        }
-
-        if (!srph_array_is_empty(&xs)){
-            srph_vec3_scale(&cx, &cx, 1.0 / (double) xs.size);
-            x = cx;
-        }
-
-        srph_array_destroy(&xs);
-    }
-}
-
-void srph_collision::colliding_correct(){
-    // calculate collision impulse magnitude
-    auto mata = a->get_material(&xa);
-    auto matb = b->get_material(&xb);
-
-    double CoR = std::max(mata.restitution, matb.restitution);
-
-    srph::vec3_t x1(x.x, x.y, x.z);
-
-    double jr = (1.0 + CoR) * vec::dot(vr, n) / (
-        1.0 / srph_matter_mass(a) + a->get_inverse_angular_mass(x1, n) +
-        1.0 / srph_matter_mass(b) + b->get_inverse_angular_mass(x1, n)
-    );
-
-    a->apply_impulse_at(n * -jr, x1);
-    b->apply_impulse_at(n *  jr, x1);
-
-    // apply friction force
-    vec3_t t = vr - n * vec::dot(vr, n);
-    if (t != vec3_t()){
-        // no surface friction because impact vector is perpendicular to surface
-        vec3 t1 = { t[0], t[1], t[2] };
-        srph_vec3_normalise(&t1, &t1);
-        t = vec3_t(t1.x, t1.y, t1.z);
-        
-        double vrt = vec::dot(vr, t); 
-        auto mvta = srph_matter_mass(a) * vrt;
-        auto mvtb = srph_matter_mass(b) * vrt;
-
-        double js = std::max(mata.static_friction,  matb.static_friction ) * jr;
-        double jd = std::max(mata.dynamic_friction, matb.dynamic_friction) * jr;
-
-        double ka = -(mvta <= js) ? mvta : jd;
-        double kb =  (mvtb <= js) ? mvtb : jd;
-
-        a->apply_impulse_at(t * ka, x1);
-        b->apply_impulse_at(t * kb, x1);
     }
 }
 
 void srph_collision::correct(){
+    // learn the deepest point, so that later collisions find more of the overlap
     srph_transform_to_local_space(&a->transform, &xa, &x);
     srph_transform_to_local_space(&b->transform, &xb, &x);
 
     srph_sdf_add_sample(a->sdf, &xa);
     srph_sdf_add_sample(b->sdf, &xb);
- 
-    // choose best normal based on smallest second derivative
-    auto ja = srph_sdf_jacobian(a->sdf, &xa);
-    auto jb = srph_sdf_jacobian(b->sdf, &xb);
 
-    vec3 n1;
-    if (vec::length(ja) <= vec::length(jb)){
-        n1 = srph_sdf_normal(a->sdf, &xa);
-        n = a->get_rotation() * vec3_t(n1.x, n1.y, n1.z);
+    // the deepest point often lands on an edge of the overlap, where normals point 
+    // sideways, so the normal is found at the centre of the overlap instead
+    vec3 c = x;
+    for (auto & xi : xs){
+        srph_vec3_add(&c, &c, &xi);
+    }
+    srph_vec3_scale(&c, &c, 1.0 / (double) (xs.size() + 1));
 
+    srph_transform_to_local_space(&a->transform, &xa, &c);
+    srph_transform_to_local_space(&b->transform, &xb, &c);
+ 
+    // take the normal of whichever matter is smoother there. where both are as smooth
+    // or as sharp as each other, as on the faces or shared edges of stacked boxes, use
+    // the sum of the two, in which the sides of shared edges cancel out. n points 
+    // from a to b, so b's outward normal is flipped
+    double ka = vec::length(srph_sdf_jacobian(a->sdf, &xa));
+    double kb = vec::length(srph_sdf_jacobian(b->sdf, &xb));
+
+    vec3_t na = a->get_rotation() * vec::view(srph_sdf_normal(a->sdf, &xa));
+    vec3_t nb = b->get_rotation() * vec::view(srph_sdf_normal(b->sdf, &xb)) * -1.0;
+
+    if (ka < 0.5 * kb){
+        n = na;
+    } else if (kb < 0.5 * ka){
+        n = nb;
     } else {
-        n1 = srph_sdf_normal(b->sdf, &xb);
-        n = b->get_rotation() * vec3_t(n1.x, n1.y, n1.z);
+        n = na + nb;
     }
-
-    // extricate matters 
-    double sm = srph_matter_mass(a) + srph_matter_mass(b);
-    a->translate(n * -depth * srph_matter_mass(b) / sm);
-    b->translate(n *  depth * srph_matter_mass(a) / sm);
-    
-    // find relative velocity at point 
-    srph::vec3_t x1(x.x, x.y, x.z);
-    vr = a->get_velocity(x1) - b->get_velocity(x1);
-    colliding_correct();
+    n *= 1.0 / vec::length(n);
 }
 
 bool srph_collision::comparator_t::operator()(const srph_collision & a, const srph_collision & b){
@@ -1,7 +1,49 @@
 #include "physics/constraint.h"
 
+#include <assert.h>
+#include <math.h>
 #include <stdlib.h>
 
+typedef struct contact_data {
+    vec3 n;
+    double d;
+} contact_data;
+
+static srph_constraint * constraint_create(uint32_t n){
+    srph_constraint * c = (srph_constraint *) malloc(sizeof(srph_constraint) + n * sizeof(srph_vertex *));
+    assert(c != NULL);
+    return c;
+}
+
+// |xa - xb| - d
+static double distance_c(srph_constraint * c){
+    double d = *((double *) c->_data);
+    return srph_vec3_distance(&c->_vertices[0]->x, &c->_vertices[1]->x) - d;
+}
+
+static void distance_dc(srph_constraint * c, uint32_t i, vec3 * dc){
+    srph_vec3_subtract(dc, &c->_vertices[0]->x, &c->_vertices[1]->x);
+
+    // the gradient is undefined when the points coincide
+    double l = srph_vec3_length(dc);
+    if (l == 0.0){
+        srph_vec3_fill(dc, 0.0);
+        return;
+    }
+
+    srph_vec3_scale(dc, dc, (i == 0 ? 1.0 : -1.0) / l);
+}
+
+// n . x - d >= 0
+static double contact_c(srph_constraint * c){
+    contact_data * data = (contact_data *) c->_data;
+    return srph_vec3_dot(&data->n, &c->_vertices[0]->x) - data->d;
+}
+
+static void contact_dc(srph_constraint * c, uint32_t i, vec3 * dc){
+    *dc = ((contact_data *) c->_data)->n;
+}
+
 void srph_constraint_init(
     srph_constraint * c, bool is_equality, double stiffness, uint32_t n,
     void * data, srph_constraint_func c_func, srph_constraint_derivative_func dc_func
@@ -12,6 +54,7 @@ void srph_constraint_init(
     c->_c_func = c_func;
     c->_dc_func = dc_func;
     c->n = n; 
+    c->_lambda = 0.0;
 }
 
 double srph_constraint_scaling_factor(srph_constraint * c){
@@ -43,3 +86,79 @@ void srph_constraint_update(srph_constraint * c, vec3 * dp, uint32_t i, double s
     c->_dc_func(c, i, dp);
     srph_vec3_scale(dp, dp, -s * c->_vertices[i]->w);
 }
+
+void srph_constraint_solve(srph_constraint * c, double dt){
+    double C = c->_c_func(c);
+    if (!c->_is_equality && C >= 0.0){
+        return;
+    }
+
+    // cache gradients for the common small constraints
+    const uint32_t cached = 4;
+    vec3 dcs[cached];
+
+    double q = 0.0;
+    vec3 dc;
+    for (uint32_t i = 0; i < c->n; i++){
+        c->_dc_func(c, i, &dc);
+        q += srph_vec3_dot(&dc, &dc) * c->_vertices[i]->w;
+
+        if (i < cached){
+            dcs[i] = dc;
+        }
+    }
+
+    double alpha = isinf(c->_stiffness) ? 0.0 : 1.0 / (c->_stiffness * dt * dt);
+    if (q + alpha == 0.0){
+        return;
+    }
+
+    double dlambda = (-C - alpha * c->_lambda) / (q + alpha);
+    c->_lambda += dlambda;
+
+    for (uint32_t i = 0; i < c->n; i++){
+        srph_vertex * v = c->_vertices[i];
+        if (i < cached){
+            dc = dcs[i];
+        } else {
+            c->_dc_func(c, i, &dc);
+        }
+        srph_vec3_scale(&dc, &dc, dlambda * v->w);
+        srph_vec3_add(&v->x, &v->x, &dc);
+    }
+}
+
+srph_constraint * srph_constraint_distance_create(srph_vertex * a, srph_vertex * b, double d, double stiffness){
+    double * data = (double *) malloc(sizeof(double));
+    assert(data != NULL);
+    *data = d;
+
+    srph_constraint * c = constraint_create(2);
+    srph_constraint_init(c, true, stiffness, 2, data, distance_c, distance_dc);
+    c->_vertices[0] = a;
+    c->_vertices[1] = b;
+    return c;
+}
+
+srph_constraint * srph_constraint_joint_create(srph_vertex * a, srph_vertex * b, double stiffness){
+    return srph_constraint_distance_create(a, b, 0.0, stiffness);
+}
+
+srph_constraint * srph_constraint_contact_create(srph_vertex * a, const vec3 * n, double d){
+    contact_data * data = (contact_data *) malloc(sizeof(contact_data));
+    assert(data != NULL);
+    srph_vec3_normalise(&data->n, n);
+    data->d = d;
+
+    srph_constraint * c = constraint_create(1);
+    srph_constraint_init(c, false, INFINITY, 1, data, contact_c, contact_dc);
+    c->_vertices[0] = a;
+    return c;
+}
+
+void srph_constraint_destroy(srph_constraint * c){
+    if (c != NULL){
+        free(c->_data);
+        free(c);
+    }
+}
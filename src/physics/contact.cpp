@@ -0,0 +1,225 @@
+#include "physics/contact.h"
+
+#include <algorithm>
+
+using namespace srph;
+
+// approach speed below which contacts do not bounce, so that stacks can rest
+#define RESTITUTION_THRESHOLD 0.5
+
+// penetration left alone so that resting contacts persist between ticks, and the
+// fraction of the rest pushed out each tick
+#define PENETRATION_SLOP 0.005
+#define POSITION_CORRECTION 0.2
+
+// a face is held by four points, which must be at least this far apart
+#define MAX_MANIFOLD_POINTS 4
+#define MANIFOLD_SPACING 0.01
+
+// how far a contact point may have moved on a to still be warm started as the same one
+#define WARM_START_DISTANCE 0.1
+
+static bool pair_comparator(const srph_contact & a, const srph_contact & b){
+    return a.a != b.a ? a.a < b.a : a.b < b.b;
+}
+
+static double effective_mass(srph_matter * a, srph_matter * b, const vec3_t & x, const vec3_t & d){
+    double k = 
+        1.0 / srph_matter_mass(a) + a->get_inverse_angular_mass(x, d) +
+        1.0 / srph_matter_mass(b) + b->get_inverse_angular_mass(x, d);
+    return 1.0 / k;
+}
+
+static void apply_impulse(srph_contact * c, const vec3_t & j){
+    c->a->apply_impulse_at(j * -1.0, c->x);
+    c->b->apply_impulse_at(j, c->x);
+}
+
+static void tangents(const vec3_t & n, vec3_t * t){
+    vec3_t axis = std::abs(n[0]) < 0.57735 ? vec3_t(1.0, 0.0, 0.0) : vec3_t(0.0, 1.0, 0.0);
+    t[0] = vec::cross(n, axis);
+    t[0] *= 1.0 / vec::length(t[0]);
+    t[1] = vec::cross(n, t[0]);
+}
+
+void srph_contact_solver_create(srph_contact_solver * s, uint32_t iterations){
+    s->iterations = iterations;
+}
+
+void srph_contact_solver_destroy(srph_contact_solver * s){
+    s->contacts.clear();
+    s->_previous.clear();
+}
+
+void srph_contact_solver_begin(srph_contact_solver * s){
+    std::swap(s->contacts, s->_previous);
+    std::sort(s->_previous.begin(), s->_previous.end(), pair_comparator);
+    s->contacts.clear();
+}
+
+// penetration at a point inside both matters, as the thickness of their overlap there
+static double penetration(srph_matter * a, srph_matter * b, const vec3_t & x){
+    vec3 xa = vec::view(a->to_local_space(x));
+    vec3 xb = vec::view(b->to_local_space(x));
+    return std::max(-(srph_sdf_phi(a->sdf, &xa) + srph_sdf_phi(b->sdf, &xb)), 0.0);
+}
+
+// the deepest point is always kept, and the rest are chosen to span as much of the 
+// contact as they can: the point furthest from it, then the points furthest to either 
+// side of the line between those two
+static uint32_t reduce(const srph_collision * collision, const vec3_t & n, vec3_t * manifold){
+    auto point = [&](uint32_t i){
+        return i == 0 ? vec::view(collision->x) : vec::view(collision->xs[i - 1]);
+    };
+    uint32_t size = collision->xs.size() + 1;
+
+    uint32_t deepest = 0;
+    double depth = -1.0;
+    for (uint32_t i = 0; i < size; i++){
+        double d = penetration(collision->a, collision->b, point(i));
+        if (d > depth){
+            depth = d;
+            deepest = i;
+        }
+    }
+    manifold[0] = point(deepest);
+
+    double furthest = MANIFOLD_SPACING;
+    uint32_t count = 1;
+    for (uint32_t i = 0; i < size; i++){
+        double d = vec::length(point(i) - manifold[0]);
+        if (d > furthest){
+            furthest = d;
+            manifold[1] = point(i);
+            count = 2;
+        }
+    }
+
+    if (count < 2){
+        return count;
+    }
+
+    // signed area of the triangle each point makes with the first two
+    vec3_t e = manifold[1] - manifold[0];
+    double sides[2] = { MANIFOLD_SPACING * MANIFOLD_SPACING, MANIFOLD_SPACING * MANIFOLD_SPACING };
+    vec3_t xs[2];
+    bool is_found[2] = { false, false };
+    for (uint32_t i = 0; i < size; i++){
+        double area = vec::dot(vec::cross(e, point(i) - manifold[0]), n);
+        int side = area < 0.0;
+        if (std::abs(area) > sides[side]){
+            sides[side] = std::abs(area);
+            xs[side] = point(i);
+            is_found[side] = true;
+        }
+    }
+
+    for (int side = 0; side < 2; side++){
+        if (is_found[side]){
+            manifold[count++] = xs[side];
+        }
+    }
+
+    return count;
+}
+
+void srph_contact_solver_add(srph_contact_solver * s, const srph_collision * collision){
+    srph_material mata = collision->a->get_material(&collision->xa);
+    srph_material matb = collision->b->get_material(&collision->xb);
+    double friction = std::max(mata.static_friction, matb.static_friction);
+    double restitution = std::max(mata.restitution, matb.restitution);
+
+    vec3_t manifold[MAX_MANIFOLD_POINTS];
+    uint32_t count = reduce(collision, collision->n, manifold);
+
+    for (uint32_t i = 0; i < count; i++){
+        srph_contact c;
+        c.a = collision->a;
+        c.b = collision->b;
+        c.x = manifold[i];
+        c.n = collision->n;
+        tangents(c.n, c.t);
+
+        c.xa = c.a->to_local_space(c.x);
+        c.depth = penetration(c.a, c.b, c.x);
+
+        c.normal_mass = effective_mass(c.a, c.b, c.x, c.n);
+        for (int k = 0; k < 2; k++){
+            c.tangent_mass[k] = effective_mass(c.a, c.b, c.x, c.t[k]);
+        }
+
+        c.friction = friction;
+        c.restitution = restitution;
+
+        // warm start from the impulses of this pair's nearest contact last tick, which
+        // are applied once every contact has been added
+        c.jn = 0.0;
+        c.jt[0] = 0.0;
+        c.jt[1] = 0.0;
+
+        auto range = std::equal_range(s->_previous.begin(), s->_previous.end(), c, pair_comparator);
+        auto nearest = range.second;
+        double distance = WARM_START_DISTANCE;
+        for (auto it = range.first; it != range.second; it++){
+            double d = vec::length(it->xa - c.xa);
+            if (d < distance){
+                distance = d;
+                nearest = it;
+            }
+        }
+
+        if (nearest != range.second){
+            vec3_t jt = nearest->t[0] * nearest->jt[0] + nearest->t[1] * nearest->jt[1];
+            c.jn = nearest->jn;
+            c.jt[0] = vec::dot(jt, c.t[0]);
+            c.jt[1] = vec::dot(jt, c.t[1]);
+
+            // each impulse is only carried over once, or two new points near one old
+            // point would both push with all of it
+            nearest->jn = 0.0;
+            nearest->jt[0] = 0.0;
+            nearest->jt[1] = 0.0;
+        }
+
+        s->contacts.push_back(c);
+    }
+}
+
+void srph_contact_solver_solve(srph_contact_solver * s, double t){
+    // contacts bounce off their approach speed from before any impulses this tick, as
+    // warm starting briefly moves bodies by the whole weight they carry. baumgarte 
+    // stabilisation asks each contact to separate fast enough to close a fraction of 
+    // its penetration past the slop by the end of the tick
+    for (auto & c : s->contacts){
+        double vn = vec::dot(c.a->get_velocity(c.x) - c.b->get_velocity(c.x), c.n);
+        double bounce = vn > RESTITUTION_THRESHOLD ? c.restitution * vn : 0.0;
+        double bias = POSITION_CORRECTION * std::max(c.depth - PENETRATION_SLOP, 0.0) / t;
+        c.target_velocity = -std::max(bounce, bias);
+    }
+
+    for (auto & c : s->contacts){
+        apply_impulse(&c, c.n * c.jn + c.t[0] * c.jt[0] + c.t[1] * c.jt[1]);
+    }
+
+    for (uint32_t i = 0; i < s->iterations; i++){
+        for (auto & c : s->contacts){
+            vec3_t vr = c.a->get_velocity(c.x) - c.b->get_velocity(c.x);
+
+            // normal impulse, accumulated impulse can only push bodies apart
+            double jn = std::max(c.jn + (vec::dot(vr, c.n) - c.target_velocity) * c.normal_mass, 0.0);
+            apply_impulse(&c, c.n * (jn - c.jn));
+            c.jn = jn;
+
+            // friction impulses, bounded by the coulomb cone
+            vr = c.a->get_velocity(c.x) - c.b->get_velocity(c.x);
+            double limit = c.friction * c.jn;
+
+            for (int k = 0; k < 2; k++){
+                double jt = c.jt[k] + vec::dot(vr, c.t[k]) * c.tangent_mass[k];
+                jt = std::max(-limit, std::min(jt, limit));
+                apply_impulse(&c, c.t[k] * (jt - c.jt[k]));
+                c.jt[k] = jt;
+            }
+        }
+    }
+}
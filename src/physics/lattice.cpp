@@ -0,0 +1,81 @@
+#include "physics/lattice.h"
+
+#include <assert.h>
+
+void srph_lattice_create(
+    srph_lattice * l, uint32_t width, uint32_t height,
+    const vec3 * x, const vec3 * u, const vec3 * v, double stiffness
+){
+    assert(l != NULL && width > 0 && height > 0);
+
+    l->width = width;
+    l->height = height;
+    l->vertices.resize(width * height);
+    l->constraints.clear();
+
+    for (uint32_t j = 0; j < height; j++){
+        for (uint32_t i = 0; i < width; i++){
+            srph_vertex * vertex = srph_lattice_vertex(l, i, j);
+
+            vec3 du, dv;
+            srph_vec3_scale(&du, u, i);
+            srph_vec3_scale(&dv, v, j);
+            srph_vec3_add(&vertex->x, x, &du);
+            srph_vec3_add(&vertex->x, &vertex->x, &dv);
+
+            vertex->_x_key = NULL;
+            vertex->_x0 = vertex->x;
+            srph_vec3_fill(&vertex->v, 0.0);
+            vertex->w = 1.0;
+        }
+    }
+
+    double lu = srph_vec3_length(u);
+    double lv = srph_vec3_length(v);
+
+    for (uint32_t j = 0; j < height; j++){
+        for (uint32_t i = 0; i < width; i++){
+            srph_vertex * a = srph_lattice_vertex(l, i, j);
+
+            if (i + 1 < width){
+                l->constraints.push_back(
+                    srph_constraint_distance_create(a, srph_lattice_vertex(l, i + 1, j), lu, stiffness)
+                );
+            }
+
+            if (j + 1 < height){
+                l->constraints.push_back(
+                    srph_constraint_distance_create(a, srph_lattice_vertex(l, i, j + 1), lv, stiffness)
+                );
+            }
+        }
+    }
+}
+
+void srph_lattice_destroy(srph_lattice * l){
+    if (l != NULL){
+        for (auto c : l->constraints){
+            srph_constraint_destroy(c);
+        }
+
+        l->constraints.clear();
+        l->vertices.clear();
+    }
+}
+
+srph_vertex * srph_lattice_vertex(srph_lattice * l, uint32_t i, uint32_t j){
+    assert(l != NULL && i < l->width && j < l->height);
+    return &l->vertices[j * l->width + i];
+}
+
+void srph_lattice_pin(srph_lattice * l, uint32_t i, uint32_t j){
+    srph_lattice_vertex(l, i, j)->w = 0.0;
+}
+
+void srph_lattice_add_plane(srph_lattice * l, const vec3 * n, double d){
+    assert(l != NULL && n != NULL);
+
+    for (auto & vertex : l->vertices){
+        l->constraints.push_back(srph_constraint_contact_create(&vertex, n, d));
+    }
+}
@@ -8,8 +8,37 @@
 
 using namespace srph;
 
+static void push(
+    std::vector<srph_matter *> * ms, std::vector<srph_matter_bounds> * bs, 
+    srph_matter * m, const srph_matter_bounds * b, bool is_asleep
+){
+    m->_physics_index = ms->size();
+    m->_is_asleep = is_asleep;
+    ms->push_back(m);
+    bs->push_back(*b);
+}
+
+// removes in constant time by moving the last matter into the gap
+static void swap_remove(std::vector<srph_matter *> * ms, std::vector<srph_matter_bounds> * bs, uint32_t i){
+    (*ms)[i] = ms->back();
+    (*bs)[i] = bs->back();
+    (*ms)[i]->_physics_index = i;
+    ms->pop_back();
+    bs->pop_back();
+}
+
 physics_t::physics_t(){
     quit = false;
+    frames = 0;
+    srph_arena_create(&arena, 1 << 16);
+
+    // the error left by a substep falls with the square of its length, so many substeps
+    // of one iteration converge far better than a few of several
+    srph_solver_create(&solver, 32, 1);
+
+    // a stack hands its weight down one contact per iteration, and twenty boxes need
+    // about thirty iterations to rest rather than creep
+    srph_contact_solver_create(&contact_solver, 30);
 }
 
 physics_t::~physics_t(){
@@ -19,6 +48,10 @@ physics_t::~physics_t(){
         thread.join();
     }
 
+    srph_arena_destroy(&arena);
+    srph_solver_destroy(&solver);
+    srph_contact_solver_destroy(&contact_solver);
+
     printf("joined physics thread\n");
 }
 
@@ -28,102 +61,162 @@ void physics_t::start(){
 
 void physics_t::run(){
     auto t = scheduler::clock_t::now();
-    auto previous = std::chrono::steady_clock::now();
 
     printf("physics thread starting\n");
       
     while (!quit){
-        frames++;
-        
-        auto now = std::chrono::steady_clock::now();
-        double delta = constant::sigma;
+        double delta = tick();
 
-        previous = now;
+        t += std::chrono::microseconds(static_cast<int64_t>(delta * 1000000.0));
+        std::this_thread::sleep_until(t);
+    }
+}
 
-        std::vector<srph_collision> collisions;
+double physics_t::tick(){
+    frames++;
     
-        {
-            std::lock_guard<std::mutex> lock(matters_mutex);
-            
-            // reset acceleration and apply gravity force
-            for (auto & m : matters){
-                if (m->get_position()[1] > -90.0){
-                    m->reset_acceleration();
-                }
-            }
+    double delta = constant::sigma;
+
+    collisions.clear();
+    srph_arena_reset(&arena);
 
-            // collide awake substances with each other
-            for (uint32_t i = 0; i < matters.size(); i++){
-                for (uint32_t j = i + 1; j < matters.size(); j++){
-                    collisions.emplace_back(matters[i], matters[j]);
-                }
+    {
+        // held for the whole tick, as collisions and contacts point at matters that
+        // could otherwise be unregistered and freed before they are solved
+        std::lock_guard<std::mutex> lock(matters_mutex);
+        
+        // reset acceleration and apply gravity force
+        for (auto & m : matters){
+            if (m->get_position()[1] > -90.0){
+                m->reset_acceleration();
             }
-            
-            // collide awake substances with asleep substances
-            for (auto awake_matter : matters){
-                for (auto asleep_matter : asleep_matters){
-                    collisions.emplace_back(asleep_matter, awake_matter);
-                }
+        }
+
+        // collide awake substances with each other
+        for (uint32_t i = 0; i < matters.size(); i++){
+            for (uint32_t j = i + 1; j < matters.size(); j++){
+                collisions.emplace_back(matters[i], matters[j], &bounds[i], &bounds[j], &arena);
             }
         }
         
+        // collide awake substances with asleep substances
+        for (uint32_t i = 0; i < matters.size(); i++){
+            for (uint32_t j = 0; j < asleep_matters.size(); j++){
+                collisions.emplace_back(
+                    asleep_matters[j], matters[i], &asleep_bounds[j], &bounds[i], &arena
+                );
+            }
+        }
+    
         // correct all present collisions and anticipate the next one
+        srph_contact_solver_begin(&contact_solver);
         for (auto & c : collisions){
             if (c.is_intersecting){
                 c.correct();
+                srph_contact_solver_add(&contact_solver, &c);
             } 
             delta = fmin(delta, c.t);
         }
-        
+
         delta = std::max(delta, constant::iota);
-       
-        {
-            std::lock_guard<std::mutex> lock(matters_mutex);
+
+        // accelerate before solving, so that contacts hold against this tick's gravity
+        // rather than last tick's
+        for (auto m : matters){
+            m->accelerate(delta);
+        }
+
+        srph_contact_solver_solve(&contact_solver, delta);
  
-            // apply acceleration and velocity changes to matters
-            for (auto m : matters){
-                m->physics_tick(delta);
-            } 
+        // move matters with their solved velocities
+        for (auto m : matters){
+            m->physics_tick(delta);
+        } 
+
+        // solve vertex constraints
+        vec3 gravity = { 0.0, -constant::gravity, 0.0 };
+        srph_solver_step(&solver, delta, &gravity);
+
+        // refresh the bounds of awake matters for the next tick
+        for (uint32_t i = 0; i < matters.size(); i++){
+            srph_matter_bounds_update(matters[i], constant::sigma, &bounds[i]);
+        }
 
-            // try to put matters to sleep
-            for (uint32_t i = 0; i < matters.size();){
-                auto m = matters[i]; 
-            
-                if (m->is_inert()){
-                    std::cout << "Matter going to sleep!" << std::endl;
-                    asleep_matters.push_back(m);
-                    matters[i] = matters[matters.size() - 1];
-                    matters.pop_back();
-                } else { 
-                    i++;
-                }
+        // try to put matters to sleep
+        for (uint32_t i = 0; i < matters.size();){
+            auto m = matters[i]; 
+        
+            if (m->is_inert()){
+                std::cout << "Matter going to sleep!" << std::endl;
+                srph_matter_bounds b = bounds[i];
+                swap_remove(&matters, &bounds, i);
+                push(&asleep_matters, &asleep_bounds, m, &b, true);
+            } else { 
+                i++;
             }
         }
-
-        t += std::chrono::microseconds(static_cast<int64_t>(delta * 1000000.0));
-        std::this_thread::sleep_until(t);
     }
+
+    return delta;
 }
 
 void physics_t::register_matter(srph_matter * matter){
-    std::lock_guard<std::mutex> lock(matters_mutex);
-    matters.push_back(matter);
+    register_matters({ matter });
 }
     
+void physics_t::register_matters(const std::vector<srph_matter *> & matters){
+    // bounds are computed outside of the lock, so the physics thread only
+    // waits for the append
+    std::vector<srph_matter_bounds> bounds(matters.size());
+    for (uint32_t i = 0; i < matters.size(); i++){
+        srph_matter_bounds_update(matters[i], constant::sigma, &bounds[i]);
+    }
+
+    std::lock_guard<std::mutex> lock(matters_mutex);
+    for (uint32_t i = 0; i < matters.size(); i++){
+        push(&this->matters, &this->bounds, matters[i], &bounds[i], false);
+    }
+}
+
 void physics_t::unregister_matter(srph_matter * matter){
+    unregister_matters({ matter });
+}
+
+void physics_t::unregister_matters(const std::vector<srph_matter *> & matters){
     std::lock_guard<std::mutex> lock(matters_mutex);
-    
-    auto it = std::find(matters.begin(), matters.end(), matter);
-    if (it != matters.end()){
-        matters.erase(it);
-    } else {
-        it = std::find(asleep_matters.begin(), asleep_matters.end(), matter);
-        if (it != asleep_matters.end()){
-            asleep_matters.erase(it);
-        }
+    for (auto m : matters){
+        remove_matter(m);
     }
 }
 
+void physics_t::remove_matter(srph_matter * matter){
+    auto & ms = matter->_is_asleep ? asleep_matters : matters;
+    auto & bs = matter->_is_asleep ? asleep_bounds : bounds;
+
+    uint32_t i = matter->_physics_index;
+    if (i < ms.size() && ms[i] == matter){
+        swap_remove(&ms, &bs, i);
+    }
+}
+
+void physics_t::register_constraint(srph_constraint * constraint){
+    register_constraints({ constraint });
+}
+
+void physics_t::register_constraints(const std::vector<srph_constraint *> & constraints){
+    std::lock_guard<std::mutex> lock(matters_mutex);
+    srph_solver_add_array(&solver, constraints.data(), constraints.size());
+}
+
+void physics_t::unregister_constraint(srph_constraint * constraint){
+    unregister_constraints({ constraint });
+}
+
+void physics_t::unregister_constraints(const std::vector<srph_constraint *> & constraints){
+    std::lock_guard<std::mutex> lock(matters_mutex);
+    srph_solver_remove_array(&solver, constraints.data(), constraints.size());
+}
+
 int physics_t::get_frame_count(){
     int f = frames;
     frames = 0;
@@ -0,0 +1,175 @@
+#include "physics/solver.h"
+
+#include <assert.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "core/scheduler.h"
+
+using namespace srph;
+
+// colours beyond this are merged into one final colour that is solved serially
+#define MAX_COLOURS 64
+
+// colours with fewer constraints than this are not worth dispatching to the pool
+#define PARALLEL_CONSTRAINTS 512
+
+static void colour(srph_solver * s){
+    std::unordered_map<srph_vertex *, uint64_t> used;
+    std::vector<uint32_t> colours(s->constraints.size());
+    std::vector<uint32_t> counts(MAX_COLOURS + 1, 0);
+
+    s->_vertices.clear();
+
+    // greedily assign each constraint the first colour free at all of its vertices
+    for (uint32_t i = 0; i < s->constraints.size(); i++){
+        srph_constraint * c = s->constraints[i];
+
+        uint64_t mask = 0;
+        for (uint32_t j = 0; j < c->n; j++){
+            auto it = used.find(c->_vertices[j]);
+            if (it == used.end()){
+                s->_vertices.push_back(c->_vertices[j]);
+                used[c->_vertices[j]] = 0;
+            } else {
+                mask |= it->second;
+            }
+        }
+
+        uint32_t k = 0;
+        while (k < MAX_COLOURS && (mask & (1ull << k)) != 0){
+            k++;
+        }
+
+        if (k < MAX_COLOURS){
+            for (uint32_t j = 0; j < c->n; j++){
+                used[c->_vertices[j]] |= 1ull << k;
+            }
+        }
+
+        colours[i] = k;
+        counts[k]++;
+    }
+
+    // counting sort constraints by colour
+    s->_colour_offsets.assign(MAX_COLOURS + 2, 0);
+    for (uint32_t k = 0; k <= MAX_COLOURS; k++){
+        s->_colour_offsets[k + 1] = s->_colour_offsets[k] + counts[k];
+    }
+
+    s->_coloured.resize(s->constraints.size());
+    std::vector<uint32_t> next(s->_colour_offsets.begin(), s->_colour_offsets.end() - 1);
+    for (uint32_t i = 0; i < s->constraints.size(); i++){
+        s->_coloured[next[colours[i]]++] = s->constraints[i];
+    }
+
+    s->_is_coloured = true;
+}
+
+void srph_solver_create(srph_solver * s, uint32_t substeps, uint32_t iterations){
+    assert(s != NULL && substeps > 0);
+
+    s->substeps = substeps;
+    s->iterations = iterations;
+    s->_is_coloured = false;
+}
+
+void srph_solver_destroy(srph_solver * s){
+    if (s != NULL){
+        s->constraints.clear();
+        s->_vertices.clear();
+        s->_coloured.clear();
+        s->_colour_offsets.clear();
+    }
+}
+
+void srph_solver_add(srph_solver * s, srph_constraint * c){
+    s->constraints.push_back(c);
+    s->_is_coloured = false;
+}
+
+void srph_solver_remove(srph_solver * s, srph_constraint * c){
+    auto it = std::find(s->constraints.begin(), s->constraints.end(), c);
+    if (it != s->constraints.end()){
+        *it = s->constraints.back();
+        s->constraints.pop_back();
+        s->_is_coloured = false;
+    }
+}
+
+void srph_solver_add_array(srph_solver * s, srph_constraint * const * cs, uint32_t n){
+    s->constraints.insert(s->constraints.end(), cs, cs + n);
+    s->_is_coloured = false;
+}
+
+// one pass over the constraints, rather than a search per removed constraint
+void srph_solver_remove_array(srph_solver * s, srph_constraint * const * cs, uint32_t n){
+    std::unordered_set<srph_constraint *> removed(cs, cs + n);
+    auto end = std::remove_if(s->constraints.begin(), s->constraints.end(), [&removed](srph_constraint * c){
+        return removed.count(c) > 0;
+    });
+
+    s->constraints.erase(end, s->constraints.end());
+    s->_is_coloured = false;
+}
+
+void srph_solver_step(srph_solver * s, double dt, const vec3 * gravity){
+    if (s->constraints.empty()){
+        return;
+    }
+
+    if (!s->_is_coloured){
+        colour(s);
+    }
+
+    double h = dt / s->substeps;
+
+    for (uint32_t substep = 0; substep < s->substeps; substep++){
+        // predict positions
+        for (auto v : s->_vertices){
+            v->_x0 = v->x;
+
+            if (v->w > 0.0){
+                vec3 dv;
+                srph_vec3_scale(&dv, gravity, h);
+                srph_vec3_add(&v->v, &v->v, &dv);
+
+                vec3 dx;
+                srph_vec3_scale(&dx, &v->v, h);
+                srph_vec3_add(&v->x, &v->x, &dx);
+            }
+        }
+
+        for (auto c : s->constraints){
+            c->_lambda = 0.0;
+        }
+
+        for (uint32_t i = 0; i < s->iterations; i++){
+            for (uint32_t k = 0; k <= MAX_COLOURS; k++){
+                srph_constraint ** cs = s->_coloured.data() + s->_colour_offsets[k];
+                uint32_t n = s->_colour_offsets[k + 1] - s->_colour_offsets[k];
+
+                auto solve = [cs, h](uint32_t begin, uint32_t end){
+                    for (uint32_t j = begin; j < end; j++){
+                        srph_constraint_solve(cs[j], h);
+                    }
+                };
+
+                // the overflow colour may share vertices, so it is always serial
+                if (k < MAX_COLOURS && n >= PARALLEL_CONSTRAINTS){
+                    scheduler::parallel_for(n, solve);
+                } else {
+                    solve(0, n);
+                }
+            }
+        }
+
+        // derive velocities from the corrected positions
+        for (auto v : s->_vertices){
+            srph_vec3_subtract(&v->v, &v->x, &v->_x0);
+            srph_vec3_scale(&v->v, &v->v, 1.0 / h);
+        }
+    }
+}
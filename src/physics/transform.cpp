@@ -2,79 +2,99 @@
 
 using namespace srph;
 
+static void apply(const matrix_t<double, 3, 4> & m, vec3 * tx, const vec3 * x, uint32_t n){
+    for (uint32_t i = 0; i < n; i++){
+        double x0 = x[i].x;
+        double x1 = x[i].y;
+        double x2 = x[i].z;
+
+        tx[i].x = m[0] * x0 + m[3] * x1 + m[6] * x2 + m[9];
+        tx[i].y = m[1] * x0 + m[4] * x1 + m[7] * x2 + m[10];
+        tx[i].z = m[2] * x0 + m[5] * x1 + m[8] * x2 + m[11];
+    }
+}
+
+srph_transform::srph_transform(){
+    recalculate_matrix();
+}
+
 void srph_transform::set_position(const vec3_t & x){
     position = x;
-    matrix.reset();
+    recalculate_matrix();
 }
 
 void srph_transform::translate(const vec3_t & x){
     position += x;
-    matrix.reset();
+    recalculate_matrix();
 }
 
 void srph_transform::rotate(const quat_t & q){
     rotation *= q;
-    matrix.reset();
+    recalculate_matrix();
 }
 
 vec3_t srph_transform::to_local_space(const vec3_t & x) const {
-    return rotation.inverse() * (x - position);
+    vec3_t tx;
+    apply(_inverse, &vec::view(tx), &vec::view(x), 1);
+    return tx;
 }
 
 void srph_transform_to_local_space(srph_transform * tf, vec3 * tx, const vec3 * x){
-    vec3 p = { tf->position[0], tf->position[1], tf->position[2] };
-    srph_vec3_subtract(tx, x, &p);
-    
-    vec3_t tx1 = tf->rotation.inverse() * vec3_t(tx->x, tx->y, tx->z);
-    *tx = { tx1[0], tx1[1], tx1[2] };
+    apply(tf->_inverse, tx, x, 1);
 }
 
 void srph_transform_to_global_space(srph_transform * tf, vec3 * tx, const vec3 * x){
-    vec3_t x1 = tf->to_global_space(vec3_t(x->x, x->y, x->z));
-    *tx = { x1[0], x1[1], x1[2] };
+    apply(tf->_forward, tx, x, 1);
+}
+
+void srph_transform_to_local_space_array(const srph_transform * tf, vec3 * tx, const vec3 * x, uint32_t n){
+    apply(tf->_inverse, tx, x, n);
+}
+
+void srph_transform_to_global_space_array(const srph_transform * tf, vec3 * tx, const vec3 * x, uint32_t n){
+    apply(tf->_forward, tx, x, n);
 }
 
 vec3_t srph_transform::to_local_direction(const vec3_t & x) const {
-    vec3 x1 = { x[0], x[1], x[2] };
-    srph_vec3_normalise(&x1, &x1);
-    
-    
-    return rotation.inverse() * vec3_t(x1.x, x1.y, x1.z);
+    vec3 x1;
+    srph_vec3_normalise(&x1, &vec::view(x));
+    return rotation.inverse() * vec::view(x1);
 }
 
 vec3_t srph_transform::to_global_space(const vec3_t & x) const {
-    return rotation * x + position;
+    vec3_t tx;
+    apply(_forward, &vec::view(tx), &vec::view(x), 1);
+    return tx;
 }
 
 vec3_t srph_transform::right() const {
-    return rotation * vec3_t(srph_vec3_right.x, srph_vec3_right.y, srph_vec3_right.z);
+    return _forward.get_column(0);
 }
 
 vec3_t srph_transform::up() const {
-    return rotation * vec3_t(srph_vec3_up.x, srph_vec3_up.y, srph_vec3_up.z);
+    return _forward.get_column(1);
 }
 
 vec3_t srph_transform::forward() const {
-    return rotation * vec3_t(srph_vec3_forward.x, srph_vec3_forward.y, srph_vec3_forward.z);
+    return _forward.get_column(2);
 }
 
 void srph_transform::recalculate_matrix() {
-    f32mat3_t r = mat::cast<float>(rotation.to_matrix());
+    mat3_t r = rotation.to_matrix();
+    _forward = matrix_t<double, 3, 4>(r.get_column(0), r.get_column(1), r.get_column(2), position);
 
-    f32vec4_t a(r.get_column(0), 0.0f);
-    f32vec4_t b(r.get_column(1), 0.0f);
-    f32vec4_t c(r.get_column(2), 0.0f);
-    f32vec4_t d(mat::cast<float>(position), 1.0f);
-    
-    matrix = std::make_shared<f32mat4_t>(a, b, c, d);
+    // the inverse of a rotation is its transpose
+    mat3_t ri = mat::transpose(r);
+    _inverse = matrix_t<double, 3, 4>(ri.get_column(0), ri.get_column(1), ri.get_column(2), ri * (position * -1.0));
 }
 
-f32mat4_t srph_transform::get_matrix(){
-    if (matrix == nullptr){
-        recalculate_matrix();
-    }
-
-    return *matrix;
+f32mat4_t srph_transform::get_matrix() const {
+    f32vec4_t a(mat::cast<float>(_forward.get_column(0)), 0.0f);
+    f32vec4_t b(mat::cast<float>(_forward.get_column(1)), 0.0f);
+    f32vec4_t c(mat::cast<float>(_forward.get_column(2)), 0.0f);
+    f32vec4_t d(mat::cast<float>(_forward.get_column(3)), 1.0f);
+    
+    return f32mat4_t(a, b, c, d);
 }
 
 vec3_t srph_transform::get_position() const {
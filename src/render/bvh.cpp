@@ -0,0 +1,92 @@
+#include "render/bvh.h"
+
+#include <math.h>
+
+#include <algorithm>
+#include <limits>
+
+using namespace srph;
+
+void bvh_t::build(const std::vector<substance_t::data_t> & substances){
+    leaves.clear();
+    nodes.clear();
+
+    for (uint32_t i = 0; i < substances.size(); i++){
+        const substance_t::data_t & s = substances[i];
+
+        // the world space box around a rotated box reaches along each axis as far as
+        // the rotated radii do in total
+        leaf_t leaf;
+        for (int row = 0; row < 3; row++){
+            float extent = 0;
+            for (int column = 0; column < 3; column++){
+                extent += fabsf(s.transform.get(row, column)) * s.r[column];
+            }
+
+            leaf.centre[row] = s.transform.get(row, 3);
+            leaf.lower[row] = leaf.centre[row] - extent;
+            leaf.upper[row] = leaf.centre[row] + extent;
+        }
+        leaf.substance = i;
+
+        leaves.push_back(leaf);
+    }
+
+    if (leaves.empty()){
+        // a single inner node too far away to ever be reached
+        float far = std::numeric_limits<float>::max();
+        nodes.push_back({ f32vec3_t(far), null_index, f32vec3_t(far), null_index });
+        return;
+    }
+
+    nodes.reserve(2 * leaves.size() - 1);
+    build(0, leaves.size());
+
+    // the last nodes of the right spine escape past the end of the hierarchy
+    for (auto & node : nodes){
+        if (node.escape == nodes.size()){
+            node.escape = null_index;
+        }
+    }
+}
+
+void bvh_t::build(uint32_t begin, uint32_t end){
+    uint32_t index = nodes.size();
+    nodes.push_back({ leaves[begin].lower, null_index, leaves[begin].upper, null_index });
+
+    f32vec3_t lower = leaves[begin].centre;
+    f32vec3_t upper = leaves[begin].centre;
+    for (uint32_t i = begin; i < end; i++){
+        for (int j = 0; j < 3; j++){
+            nodes[index].lower[j] = std::min(nodes[index].lower[j], leaves[i].lower[j]);
+            nodes[index].upper[j] = std::max(nodes[index].upper[j], leaves[i].upper[j]);
+            lower[j] = std::min(lower[j], leaves[i].centre[j]);
+            upper[j] = std::max(upper[j], leaves[i].centre[j]);
+        }
+    }
+
+    if (end - begin == 1){
+        nodes[index].substance = leaves[begin].substance;
+    } else {
+        // split at the median centre along the axis the centres are most spread across
+        f32vec3_t spread = upper - lower;
+        int axis = spread[0] > spread[1] ? (spread[0] > spread[2] ? 0 : 2) : (spread[1] > spread[2] ? 1 : 2);
+
+        uint32_t middle = (begin + end) / 2;
+        std::nth_element(
+            leaves.begin() + begin, leaves.begin() + middle, leaves.begin() + end,
+            [axis](const leaf_t & a, const leaf_t & b){
+                return a.centre[axis] < b.centre[axis];
+            }
+        );
+
+        build(begin, middle);
+        build(middle, end);
+    }
+
+    nodes[index].escape = nodes.size();
+}
+
+const std::vector<bvh_t::node_t> & bvh_t::get_nodes() const {
+    return nodes;
+}
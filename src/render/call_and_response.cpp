@@ -27,13 +27,13 @@ uint32_t call_t::get_hash() const {
     return hash;
 }
 
-uint32_t call_t::get_substance_ID() const {
-    return substanceID;
+uint32_t call_t::get_shape_ID() const {
+    return shapeID;
 }
 
 bool call_t::comparator_t::operator()(const call_t & a, const call_t & b) const {
-    if (a.substanceID != b.substanceID){
-        return a.substanceID < b.substanceID;
+    if (a.shapeID != b.shapeID){
+        return a.shapeID < b.shapeID;
     }
     
     if (std::abs(a.radius - b.radius) > constant::epsilon){
@@ -60,40 +60,40 @@ vec3_t vertices[8] = {
 
 response_t::response_t(){}
 
-response_t::response_t(const call_t & call, std::weak_ptr<substance_t> substance_ptr){
-    if (auto substance = substance_ptr.lock()){
-        srph_sdf * sdf = substance->matter.sdf;
-
+response_t::response_t(const call_t & call, srph_sdf * sdf, srph_matter * matter){
+    if (sdf != NULL){
         srph_bound3 * bound = srph_sdf_bound(sdf);
-        vec3 m;
-        srph_bound3_midpoint(bound, m.raw);
-        vec3_t p = mat::cast<double>(call.get_position()) - vec3_t(m.x, m.y, m.z);
+        vec3_t m;
+        srph_bound3_midpoint(bound, m.data());
+        vec3_t p = mat::cast<double>(call.get_position()) - m;
 
         uint32_t contains_mask = 0;
 
         for (int o = 0; o < 8; o++){
             vec3_t d = p + vertices[o] * call.get_radius();
-            vec3 d1 = { d[0], d[1], d[2] };
+            const vec3 & d1 = vec::view(d);
 
             if (!srph_sdf_contains(sdf, &d1)){
                 contains_mask |= 1 << o;
             }
 
-            vec3 n1 = srph_sdf_normal(sdf, &d1);
-            vec3_t n = vec3_t(n1.x, n1.y, n1.z) / 2 + 0.5;
+            vec3_t n = vec::view(srph_sdf_normal(sdf, &d1)) / 2 + 0.5;
 
             normals[o] = squash(vec4_t(n, 0.0));
 
-            vec3 c = substance->matter.get_material(&d1).colour;
+            // shared patches carry no albedo of their own and are tinted by the substance
+            vec3 c = { 1.0, 1.0, 1.0 };
+            if (matter != NULL){
+                c = matter->get_material(&d1).colour;
+            }
             colours[o] = squash(vec4_t(c.x, c.y, c.z, 0.0));
         }
 
         vec3_t c = p + call.get_radius();
-        vec3 c1 = { c[0], c[1], c[2] };
+        const vec3 & c1 = vec::view(c);
         float phi = static_cast<float>(srph_sdf_phi(sdf, &c1));
         
-        vec3 n1 = srph_sdf_normal(sdf, &c1);
-        vec3_t n = vec3_t(n1.x, n1.y, n1.z) / 2 + 0.5;
+        vec3_t n = vec::view(srph_sdf_normal(sdf, &c1)) / 2 + 0.5;
         uint32_t np = squash(vec4_t(n, 0.0));
 
         uint32_t x_elem = contains_mask << 16;
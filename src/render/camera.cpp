@@ -12,9 +12,7 @@ void camera_t::update(double delta, const keyboard_t & keyboard, const mouse_t &
     vec3_t forward = transform.forward();
     forward[1] = 0.0;
     
-    vec3 f1 = { forward[0], forward[1], forward[2] };
-    srph_vec3_normalise(&f1, &f1);
-    forward = vec3_t(f1.x, f1.y, f1.z);
+    srph_vec3_normalise(&vec::view(forward), &vec::view(forward));
 
     vec3_t right = transform.right();
 
@@ -36,7 +34,7 @@ void camera_t::update(double delta, const keyboard_t & keyboard, const mouse_t &
     
     transform.rotate(quat_t::angle_axis(
         delta * mouse.get_velocity()[0] / 2000, 
-        vec3_t(srph_vec3_up.x, srph_vec3_up.y, srph_vec3_up.z)
+        vec::view(srph_vec3_up)
     ));
 
     transform.rotate(quat_t::angle_axis(
@@ -45,6 +43,12 @@ void camera_t::update(double delta, const keyboard_t & keyboard, const mouse_t &
     ));
 }
 
+void camera_t::set_pose(const vec3_t & x, const quat_t & q){
+    transform = srph_transform();
+    transform.set_position(x);
+    transform.rotate(q);
+}
+
 f32mat4_t camera_t::get_matrix(){
     return transform.get_matrix();
 }
@@ -2,12 +2,24 @@
 
 using namespace srph;
 
-light_t::light_t(){
+light_t::data_t::data_t(){
     id = ~0;
+    version = 0;
+}
+
+light_t::data_t::data_t(const f32vec3_t & x, uint32_t id, const f32vec3_t & colour){
+    this->x = x;
+    this->id = id;
+    this->colour = colour;
+    version = 0;
 }
 
 light_t::light_t(const f32vec3_t & x, const f32vec4_t & colour){
     this->x = x;
     this->colour = colour;
-    id = 0;
+    _renderer_index = ~0;
+}
+
+light_t::data_t light_t::get_data() const {
+    return data_t(x, _renderer_index, f32vec3_t(colour[0], colour[1], colour[2]));
 }
@@ -0,0 +1,81 @@
+#include "render/pipeline_cache.h"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "ui/resources.h"
+
+using namespace srph;
+
+pipeline_cache_t::pipeline_cache_t(device_t * device, const std::string & path){
+    this->device = device;
+    this->path = path;
+
+    std::string data = resources::load_file(path);
+    is_warm = is_compatible(data);
+
+    VkPipelineCacheCreateInfo create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    create_info.initialDataSize = is_warm ? data.size() : 0;
+    create_info.pInitialData = is_warm ? data.data() : nullptr;
+
+    if (vkCreatePipelineCache(device->get_device(), &create_info, nullptr, &pipeline_cache) != VK_SUCCESS){
+        throw std::runtime_error("Error: Failed to create pipeline cache.");
+    }
+}
+
+pipeline_cache_t::~pipeline_cache_t(){
+    save();
+    vkDestroyPipelineCache(device->get_device(), pipeline_cache, nullptr);
+}
+
+bool pipeline_cache_t::is_compatible(const std::string & data) const {
+    // the header layout is fixed by the specification, see VkPipelineCacheHeaderVersionOne
+    struct header_t {
+        uint32_t size;
+        uint32_t version;
+        uint32_t vendor_id;
+        uint32_t device_id;
+        uint8_t uuid[VK_UUID_SIZE];
+    };
+
+    if (data.size() < sizeof(header_t)){
+        return false;
+    }
+
+    header_t header;
+    std::memcpy(&header, data.data(), sizeof(header_t));
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->get_physical_device(), &properties);
+
+    return 
+        header.size >= sizeof(header_t) &&
+        header.version == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+        header.vendor_id == properties.vendorID &&
+        header.device_id == properties.deviceID &&
+        std::memcmp(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+bool pipeline_cache_t::save() const {
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device->get_device(), pipeline_cache, &size, nullptr) != VK_SUCCESS){
+        return false;
+    }
+
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device->get_device(), pipeline_cache, &size, data.data()) != VK_SUCCESS){
+        return false;
+    }
+
+    return resources::save_file(path, data.data(), size);
+}
+
+VkPipelineCache pipeline_cache_t::get_handle() const {
+    return pipeline_cache;
+}
+
+bool pipeline_cache_t::get_is_warm() const {
+    return is_warm;
+}
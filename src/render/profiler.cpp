@@ -0,0 +1,286 @@
+#include "render/profiler.h"
+
+#include <assert.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <stdexcept>
+
+using namespace srph;
+
+profiler_t::profiler_t(device_t * device, uint32_t sets, uint32_t slots, uint32_t capacity){
+    this->device = device;
+    this->sets = sets;
+    this->capacity = capacity;
+    head = 0;
+    history.reserve(capacity);
+    compute_end = 0;
+    graphics_end = 0;
+
+    pending.resize(slots);
+    for (uint32_t slot = 0; slot < slots; slot++){
+        begin_frame(slot, 0);
+    }
+
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->get_physical_device(), &properties);
+    timestamp_period = properties.limits.timestampPeriod;
+
+    uint32_t queue_family_count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device->get_physical_device(), &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device->get_physical_device(), &queue_family_count, queue_families.data());
+
+    compute_timestamp_mask = mask_from_bits(queue_families[device->get_compute_family()].timestampValidBits);
+
+    // headless devices never record the graphics pass
+    graphics_timestamp_mask = device->get_is_headless() ? 0 :
+        mask_from_bits(queue_families[device->get_graphics_family()].timestampValidBits);
+
+    timestamp_pool = VK_NULL_HANDLE;
+    if (has_timestamps()){
+        timestamp_pool = create_pool(VK_QUERY_TYPE_TIMESTAMP, 0, sets * gpu_stage_count * 2);
+    }
+
+    compute_statistics_pool = VK_NULL_HANDLE;
+    graphics_statistics_pool = VK_NULL_HANDLE;
+    if (device->get_features().pipelineStatisticsQuery){
+        compute_statistics_pool = create_pool(
+            VK_QUERY_TYPE_PIPELINE_STATISTICS, VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT, sets
+        );
+        graphics_statistics_pool = create_pool(
+            VK_QUERY_TYPE_PIPELINE_STATISTICS, VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT, sets
+        );
+    }
+}
+
+profiler_t::~profiler_t(){
+    for (auto pool : { timestamp_pool, compute_statistics_pool, graphics_statistics_pool }){
+        if (pool != VK_NULL_HANDLE){
+            vkDestroyQueryPool(device->get_device(), pool, nullptr);
+        }
+    }
+}
+
+uint64_t profiler_t::mask_from_bits(uint32_t valid_bits){
+    return valid_bits >= 64 ? ~static_cast<uint64_t>(0) : (static_cast<uint64_t>(1) << valid_bits) - 1;
+}
+
+VkQueryPool profiler_t::create_pool(VkQueryType type, VkQueryPipelineStatisticFlags statistics, uint32_t count) const {
+    VkQueryPoolCreateInfo create_info = {};
+    create_info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    create_info.queryType = type;
+    create_info.queryCount = count;
+    create_info.pipelineStatistics = statistics;
+
+    VkQueryPool pool;
+    if (vkCreateQueryPool(device->get_device(), &create_info, nullptr, &pool) != VK_SUCCESS){
+        throw std::runtime_error("Error: Failed to create query pool.");
+    }
+
+    return pool;
+}
+
+uint64_t profiler_t::get_timestamp_mask(gpu_stage_t stage) const {
+    return stage == gpu_stage_graphics ? graphics_timestamp_mask : compute_timestamp_mask;
+}
+
+VkQueryPool profiler_t::get_statistics_pool(gpu_stage_t stage) const {
+    switch (stage){
+        case gpu_stage_dispatch: return compute_statistics_pool;
+        case gpu_stage_graphics: return graphics_statistics_pool;
+        default:                 return VK_NULL_HANDLE;
+    }
+}
+
+uint32_t profiler_t::get_query(uint32_t set, gpu_stage_t stage) const {
+    assert(set < sets);
+    return (set * gpu_stage_count + stage) * 2;
+}
+
+void profiler_t::record_begin(VkCommandBuffer command_buffer, uint32_t set, gpu_stage_t stage) const {
+    VkQueryPool statistics_pool = get_statistics_pool(stage);
+    if (statistics_pool != VK_NULL_HANDLE){
+        vkCmdResetQueryPool(command_buffer, statistics_pool, set, 1);
+        vkCmdBeginQuery(command_buffer, statistics_pool, set, 0);
+    }
+
+    if (get_timestamp_mask(stage) != 0){
+        uint32_t query = get_query(set, stage);
+        vkCmdResetQueryPool(command_buffer, timestamp_pool, query, 2);
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestamp_pool, query);
+    }
+}
+
+void profiler_t::record_end(VkCommandBuffer command_buffer, uint32_t set, gpu_stage_t stage) const {
+    if (get_timestamp_mask(stage) != 0){
+        vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestamp_pool, get_query(set, stage) + 1);
+    }
+
+    VkQueryPool statistics_pool = get_statistics_pool(stage);
+    if (statistics_pool != VK_NULL_HANDLE){
+        vkCmdEndQuery(command_buffer, statistics_pool, set);
+    }
+}
+
+double profiler_t::get_idle(uint64_t & end, uint64_t begin, uint64_t next_end, uint64_t mask){
+    double idle = end == 0 ? -1.0 : static_cast<double>((begin - end) & mask) * timestamp_period / 1000000.0;
+    end = next_end;
+    return idle;
+}
+
+void profiler_t::begin_frame(uint32_t slot, uint32_t frame){
+    sample_t & sample = pending[slot];
+    sample = {};
+    sample.frame = frame;
+    sample.compute_idle = -1.0;
+    sample.graphics_idle = -1.0;
+    sample.resolution_scale = 1.0;
+
+    for (double & time : sample.cpu){
+        time = -1.0;
+    }
+    for (double & time : sample.gpu){
+        time = -1.0;
+    }
+}
+
+void profiler_t::set_cpu_time(uint32_t slot, cpu_stage_t stage, double time){
+    pending[slot].cpu[stage] = time;
+}
+
+void profiler_t::set_resolution_scale(uint32_t slot, double scale){
+    pending[slot].resolution_scale = scale;
+}
+
+void profiler_t::set_patch_churn(uint32_t slot, uint32_t requests, uint32_t evictions){
+    pending[slot].patch_requests = requests;
+    pending[slot].patch_evictions = evictions;
+}
+
+void profiler_t::set_dropped_lights(uint32_t slot, uint32_t lights){
+    pending[slot].dropped_lights = lights;
+}
+
+void profiler_t::resolve(uint32_t slot, uint32_t set, gpu_stage_t stage){
+    sample_t & sample = pending[slot];
+
+    uint64_t mask = get_timestamp_mask(stage);
+    if (mask != 0){
+        uint64_t * timestamps = sample.ticks[stage];
+        VkResult result = vkGetQueryPoolResults(
+            device->get_device(), timestamp_pool, get_query(set, stage), 2, sizeof(sample.ticks[stage]), timestamps,
+            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+        );
+
+        if (result == VK_SUCCESS){
+            uint64_t ticks = (timestamps[1] - timestamps[0]) & mask;
+            sample.gpu[stage] = static_cast<double>(ticks) * timestamp_period / 1000000.0;
+        }
+    }
+
+    VkQueryPool statistics_pool = get_statistics_pool(stage);
+    if (statistics_pool != VK_NULL_HANDLE){
+        uint64_t invocations = 0;
+        VkResult result = vkGetQueryPoolResults(
+            device->get_device(), statistics_pool, set, 1, sizeof(invocations), &invocations,
+            sizeof(uint64_t), VK_QUERY_RESULT_64_BIT
+        );
+
+        if (result == VK_SUCCESS){
+            (stage == gpu_stage_dispatch ? sample.compute_invocations : sample.fragment_invocations) = invocations;
+        }
+    }
+}
+
+void profiler_t::end_frame(uint32_t slot){
+    sample_t & sample = pending[slot];
+
+    // compute work starts with the writes and ends with the readback
+    if (sample.gpu[gpu_stage_write] >= 0 && sample.gpu[gpu_stage_read] >= 0){
+        sample.compute_idle = get_idle(
+            compute_end, sample.ticks[gpu_stage_write][0], sample.ticks[gpu_stage_read][1], compute_timestamp_mask
+        );
+    }
+
+    if (sample.gpu[gpu_stage_graphics] >= 0){
+        sample.graphics_idle = get_idle(
+            graphics_end, sample.ticks[gpu_stage_graphics][0], sample.ticks[gpu_stage_graphics][1], graphics_timestamp_mask
+        );
+    }
+
+    if (capacity == 0){
+        return;
+    }
+
+    if (history.size() < capacity){
+        history.push_back(sample);
+    } else {
+        history[head] = sample;
+        head = (head + 1) % capacity;
+    }
+}
+
+const profiler_t::sample_t & profiler_t::get_pending(uint32_t slot) const {
+    return pending[slot];
+}
+
+bool profiler_t::has_timestamps() const {
+    return compute_timestamp_mask != 0 || graphics_timestamp_mask != 0;
+}
+
+bool profiler_t::has_statistics() const {
+    return compute_statistics_pool != VK_NULL_HANDLE;
+}
+
+std::vector<profiler_t::sample_t> profiler_t::get_history() const {
+    std::vector<sample_t> samples(history.begin() + head, history.end());
+    samples.insert(samples.end(), history.begin(), history.begin() + head);
+    return samples;
+}
+
+const profiler_t::sample_t * profiler_t::get_latest() const {
+    if (history.empty()){
+        return nullptr;
+    }
+
+    return &history[(head + history.size() - 1) % history.size()];
+}
+
+bool profiler_t::save_csv(const char * path) const {
+    FILE * file = fopen(path, "w");
+    if (file == NULL){
+        return false;
+    }
+
+    fprintf(file, "frame");
+    for (auto name : cpu_stage_names){
+        fprintf(file, ",cpu_%s_ms", name);
+    }
+    for (auto name : gpu_stage_names){
+        fprintf(file, ",gpu_%s_ms", name);
+    }
+    fprintf(file, ",compute_idle_ms,graphics_idle_ms,resolution_scale,patch_requests,patch_evictions,dropped_lights,compute_invocations,fragment_invocations\n");
+
+    for (auto & sample : get_history()){
+        fprintf(file, "%u", sample.frame);
+        for (double time : sample.cpu){
+            fprintf(file, ",%.4f", time);
+        }
+        for (double time : sample.gpu){
+            fprintf(file, ",%.4f", time);
+        }
+        fprintf(file, ",%.4f,%.4f,%.4f,%u,%u,%u,%llu,%llu\n",
+            sample.compute_idle,
+            sample.graphics_idle,
+            sample.resolution_scale,
+            sample.patch_requests,
+            sample.patch_evictions,
+            sample.dropped_lights,
+            static_cast<unsigned long long>(sample.compute_invocations),
+            static_cast<unsigned long long>(sample.fragment_invocations)
+        );
+    }
+
+    return fclose(file) == 0;
+}
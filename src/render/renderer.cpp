@@ -1,10 +1,15 @@
 #include "render/renderer.h"
 
-#include "ui/resources.h"
+#include "render/shader.h"
 #include "render/texture.h"
+#include "ui/resources.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <ctime>
+#include <iostream>
+#include <sstream>
 #include <stdexcept>
 
 using namespace srph;
@@ -13,15 +18,24 @@ renderer_t::renderer_t(
     device_t * device,
     VkSurfaceKHR surface, window_t * window,
     std::shared_ptr<camera_t> test_camera,
-    u32vec2_t work_group_count, u32vec2_t work_group_size,
-    uint32_t max_image_size
+    u32vec2_t size, uint32_t max_image_size
 ){
     this->device = device;
     this->surface = surface;
+    is_headless = device->get_is_headless();
+
+    this->size = size;
+    work_group_area = get_work_group_area();
 
-    this->work_group_count = work_group_count;
-    this->work_group_size = work_group_size;
+    render_size = size;
+    resolution_scale = 1.0f;
+    frame_budget = default_frame_budget;
+    resize_frame = 0;
+    has_history = false;
     patch_image_size = max_image_size / patch_sample_size;
+    substance_capacity = min_substance_capacity;
+    light_capacity = min_light_capacity;
+    shadow_version = 0;
 
     start = std::chrono::high_resolution_clock::now();
 
@@ -30,7 +44,7 @@ renderer_t::renderer_t(
     current_frame = 0;
     push_constants.current_frame = 0;
     push_constants.render_distance = constant::rho;
-    push_constants.window_size = window->get_size();
+    push_constants.window_size = is_headless ? size : window->get_size();
     push_constants.phi_initial = 0;
     push_constants.focal_depth = 1.0;
     push_constants.number_of_calls = number_of_calls;
@@ -38,58 +52,99 @@ renderer_t::renderer_t(
     push_constants.texture_depth = number_of_patches / patch_image_size / patch_image_size + 1;
     push_constants.patch_pool_size = number_of_patches;
     push_constants.epsilon = constant::epsilon;
+    push_constants.render_size = render_size;
+    push_constants.jitter = f32vec2_t(0.0f);
 
     set_main_camera(test_camera);
 
-    fragment_shader_code = resources::load_file("../src/render/shader/frag.glsl");
-    vertex_shader_code   = resources::load_file("../src/render/shader/vert.glsl");
-
-    vkGetDeviceQueue(device->get_device(), device->get_present_family(), 0, &present_queue);
-
-    swapchain = std::make_unique<swapchain_t>(device, push_constants.window_size, surface);
+    pipeline_cache = std::make_unique<pipeline_cache_t>(device, pipeline_cache_path);
 
-    create_render_pass();
+    if (!is_headless){
+        vkGetDeviceQueue(device->get_device(), device->get_present_family(), 0, &present_queue);
+        swapchain = std::make_unique<swapchain_t>(device, push_constants.window_size, surface);
+        create_render_pass();
+    }
 
-    u32vec3_t size = u32vec3_t(
+    u32vec3_t patch_texture_size = u32vec3_t(
         patch_image_size,
         patch_image_size,
         push_constants.texture_depth
     ) * patch_sample_size;
 
     normal_texture = std::make_unique<texture_t>(
-        11, device, size, 
+        11, device, patch_texture_size, VK_FORMAT_R8G8B8A8_UNORM,
         VK_IMAGE_USAGE_SAMPLED_BIT, 
         static_cast<VkFormatFeatureFlagBits>(VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT), 
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
     );
 
     colour_texture = std::make_unique<texture_t>(
-        12, device, size, 
+        12, device, patch_texture_size, VK_FORMAT_R8G8B8A8_UNORM,
         VK_IMAGE_USAGE_SAMPLED_BIT, 
         static_cast<VkFormatFeatureFlagBits>(VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_TRANSFER_DST_BIT), 
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER
     );
 
     create_descriptor_set_layout();
-    create_graphics_pipeline();
-    create_compute_pipeline();
+
+    auto pipeline_start = std::chrono::steady_clock::now();
+    if (!is_headless){
+        create_graphics_pipeline();
+    }
+    create_compute_pipeline_layout();
+    create_variants();
+    create_reconstruct_pipeline();
+    cluster_pipeline = create_compute_pipeline(shader::cluster, u32vec2_t(cluster_work_group_size, 1u));
+    shadow_pipeline = create_compute_pipeline(shader::compute, u32vec2_t(8u, 1u), true);
+    auto pipeline_end = std::chrono::steady_clock::now();
+
+    std::cout << 
+        "Pipelines created in " << 
+        std::chrono::duration_cast<std::chrono::microseconds>(pipeline_end - pipeline_start).count() / 1000.0 << 
+        " ms from a " << (pipeline_cache->get_is_warm() ? "warm" : "cold") << " cache." << std::endl;
+
+    profiler = std::make_unique<profiler_t>(device, frames_in_flight * 2, frames_in_flight, profiler_history);
 
     graphics_command_pool = std::make_unique<command_pool_t>(device->get_device(), device->get_graphics_family());
     compute_command_pool = std::make_unique<command_pool_t>(device->get_device(), device->get_compute_family());
 
-    create_framebuffers();
+    if (!is_headless){
+        create_framebuffers();
+    }
     create_descriptor_pool();
     create_sync();
 
-    render_texture = std::make_unique<texture_t>(
-        10, device, u32vec3_t(work_group_count[0] * work_group_size[0], work_group_count[1] * work_group_size[1], 1u), 
-        VK_IMAGE_USAGE_STORAGE_BIT,
-        VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+    // one render texture per frame in flight, so the next frame can be raymarched while 
+    // the last is still being drawn and presented
+    for (int i = 0; i < frames_in_flight; i++){
+        render_textures.push_back(std::make_unique<texture_t>(
+            10, device, u32vec3_t(size[0], size[1], 1u), VK_FORMAT_R8G8B8A8_UNORM,
+            VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+            VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
+        ));
+    }
+
+    // samples hold the colour and the distance along each ray, which is why they are float
+    sample_texture = std::make_unique<texture_t>(
+        sample_binding, device, u32vec3_t(size[0], size[1], 1u), VK_FORMAT_R16G16B16A16_SFLOAT,
+        VK_IMAGE_USAGE_STORAGE_BIT, VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE
     );
 
+    if (is_headless){
+        readback_buffer = std::make_unique<host_buffer_t<uint32_t>>(~0, device, size[0] * size[1]);
+        frame.resize(size[0] * size[1]);
+    }
+
     std::vector<VkWriteDescriptorSet> write_desc_sets;
-    for (auto descriptor_set : desc_sets){
-        write_desc_sets.push_back(render_texture->get_descriptor_write(descriptor_set));
+    for (int i = 0; i < frames_in_flight; i++){
+        VkDescriptorSet descriptor_set = desc_sets[i];
+        write_desc_sets.push_back(render_textures[i]->get_descriptor_write(descriptor_set));
+        write_desc_sets.push_back(sample_texture->get_descriptor_write(descriptor_set));
+
+        // the history is whatever the previous frame in flight reconstructed
+        VkWriteDescriptorSet history = render_textures[(i + frames_in_flight - 1) % frames_in_flight]->get_descriptor_write(descriptor_set);
+        history.dstBinding = history_binding;
+        write_desc_sets.push_back(history);
         write_desc_sets.push_back(normal_texture->get_descriptor_write(descriptor_set));
         write_desc_sets.push_back(colour_texture->get_descriptor_write(descriptor_set));
 
@@ -98,16 +153,25 @@ renderer_t::renderer_t(
         write_desc_sets.push_back(call_buffer->get_write_descriptor_set(descriptor_set));
         write_desc_sets.push_back(light_buffer->get_write_descriptor_set(descriptor_set));
         write_desc_sets.push_back(pointer_buffer->get_write_descriptor_set(descriptor_set));
-        write_desc_sets.push_back(frustum_buffer->get_write_descriptor_set(descriptor_set));
-        write_desc_sets.push_back(lighting_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(patch_age_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(cluster_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(bvh_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(shadow_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(shadow_request_buffer->get_write_descriptor_set(descriptor_set));
     }
 
     vkUpdateDescriptorSets(device->get_device(), write_desc_sets.size(), write_desc_sets.data(), 0, nullptr);
 
-    create_command_buffers();
+    if (!is_headless){
+        create_command_buffers();
+    }
 }
 
 void renderer_t::cleanup_swapchain(){
+    if (is_headless){
+        return;
+    }
+
     for (auto framebuffer : framebuffers){
 	    vkDestroyFramebuffer(device->get_device(), framebuffer, nullptr);
     }
@@ -126,18 +190,32 @@ renderer_t::~renderer_t(){
 
     cleanup_swapchain();
 
-    vkDestroyPipeline(device->get_device(), compute_pipeline, nullptr);
+    for (auto & variant : variants){
+        vkDestroyPipeline(device->get_device(), variant.pipeline, nullptr);
+    }
     vkDestroyPipelineLayout(device->get_device(), compute_pipeline_layout, nullptr);
+    vkDestroyPipeline(device->get_device(), reconstruct_pipeline, nullptr);
+    vkDestroyPipeline(device->get_device(), cluster_pipeline, nullptr);
+    vkDestroyPipeline(device->get_device(), shadow_pipeline, nullptr);
+    vkDestroyPipelineLayout(device->get_device(), reconstruct_pipeline_layout, nullptr);
+
+    profiler.reset();
+    pipeline_cache.reset();
+
+    for (auto & shape : shapes){
+        srph_sdf_destroy(shape.second.sdf);
+    }
 
     for (int i = 0; i < frames_in_flight; i++){
         vkDestroySemaphore(device->get_device(), image_available_semas[i], nullptr);
         vkDestroySemaphore(device->get_device(), compute_done_semas[i], nullptr);
         vkDestroySemaphore(device->get_device(), render_finished_semas[i], nullptr);
         vkDestroyFence(device->get_device(), in_flight_fences[i], nullptr);
+        vkDestroyFence(device->get_device(), compute_fences[i], nullptr);
     }
 }
   
-void renderer_t::create_compute_pipeline(){
+void renderer_t::create_compute_pipeline_layout(){
     VkPushConstantRange push_const_range = {};
     push_const_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
     push_const_range.size = sizeof(push_constant_t);
@@ -155,10 +233,42 @@ void renderer_t::create_compute_pipeline(){
     ){
         throw std::runtime_error("Error: Failed to create compute pipeline layout.");
     }
+}
+
+VkPipeline renderer_t::create_compute_pipeline(const shader::code_t & code, u32vec2_t work_group_size, bool is_shadow_pass){
+    specialisation_t specialisation;
+    specialisation.work_group_size_x = work_group_size[0];
+    specialisation.work_group_size_y = work_group_size[1];
+    specialisation.max_steps = max_steps;
+    specialisation.max_hash_retries = max_hash_retries;
+    specialisation.cone_tile_size = cone_tile_size;
+    specialisation.cone_levels = cone_levels;
+    specialisation.cluster_grid_x = cluster_grid_x;
+    specialisation.cluster_grid_y = cluster_grid_y;
+    specialisation.cluster_grid_z = cluster_grid_z;
+    specialisation.max_cluster_lights = max_cluster_lights;
+    specialisation.cluster_near = cluster_near;
+    specialisation.light_cutoff = light_cutoff;
+    specialisation.shadow_threshold = shadow_threshold;
+    specialisation.shadow_cell_scale = shadow_cell_scale;
+    specialisation.is_shadow_pass = is_shadow_pass ? VK_TRUE : VK_FALSE;
+    specialisation.patch_ways = patch_ways;
+
+    // constant ids follow the field order, matching the layout qualifiers in the shaders.
+    // entries for ids a shader does not declare are ignored
+    static_assert(sizeof(specialisation_t) % sizeof(uint32_t) == 0, "Specialisation constants must be four bytes each");
+    std::vector<VkSpecializationMapEntry> entries;
+    for (uint32_t i = 0; i < sizeof(specialisation_t) / sizeof(uint32_t); i++){
+        entries.push_back({ i, static_cast<uint32_t>(i * sizeof(uint32_t)), sizeof(uint32_t) });
+    }
 
-    std::string compute_shader_code = resources::load_file("../src/render/shader/comp.glsl");
+    VkSpecializationInfo specialisation_info = {};
+    specialisation_info.mapEntryCount = entries.size();
+    specialisation_info.pMapEntries = entries.data();
+    specialisation_info.dataSize = sizeof(specialisation_t);
+    specialisation_info.pData = &specialisation;
 
-    VkShaderModule module = create_shader_module(compute_shader_code);
+    VkShaderModule module = create_shader_module(code);
 
     VkComputePipelineCreateInfo pipeline_create_info = {};
     pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
@@ -166,12 +276,53 @@ void renderer_t::create_compute_pipeline(){
     pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
     pipeline_create_info.stage.module = module;
     pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.stage.pSpecializationInfo = &specialisation_info;
     pipeline_create_info.layout = compute_pipeline_layout;
 
-    if (vkCreateComputePipelines(device->get_device(), VK_NULL_HANDLE, 1, &pipeline_create_info, nullptr, &compute_pipeline) != VK_SUCCESS){
+    VkPipeline pipeline;
+    if (vkCreateComputePipelines(device->get_device(), pipeline_cache->get_handle(), 1, &pipeline_create_info, nullptr, &pipeline) != VK_SUCCESS){
         throw std::runtime_error("Error: Failed to create compute pipeline.");
     }
 
+    vkDestroyShaderModule(device->get_device(), module, nullptr);    
+    return pipeline;
+}
+
+void renderer_t::create_reconstruct_pipeline(){
+    VkPushConstantRange push_const_range = {};
+    push_const_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+    push_const_range.size = sizeof(reconstruct_constant_t);
+    push_const_range.offset = 0;
+
+    VkPipelineLayoutCreateInfo pipeline_layout_info = {};
+    pipeline_layout_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    pipeline_layout_info.setLayoutCount = 1;
+    pipeline_layout_info.pSetLayouts = &descriptor_layout;
+    pipeline_layout_info.pushConstantRangeCount = 1;
+    pipeline_layout_info.pPushConstantRanges = &push_const_range;
+
+    if (vkCreatePipelineLayout(
+	    device->get_device(), &pipeline_layout_info, nullptr, &reconstruct_pipeline_layout) != VK_SUCCESS
+    ){
+        throw std::runtime_error("Error: Failed to create reconstruct pipeline layout.");
+    }
+
+    VkShaderModule module = create_shader_module(shader::reconstruct);
+
+    VkComputePipelineCreateInfo pipeline_create_info = {};
+    pipeline_create_info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipeline_create_info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_create_info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    pipeline_create_info.stage.module = module;
+    pipeline_create_info.stage.pName = "main";
+    pipeline_create_info.layout = reconstruct_pipeline_layout;
+
+    if (vkCreateComputePipelines(
+        device->get_device(), pipeline_cache->get_handle(), 1, &pipeline_create_info, nullptr, &reconstruct_pipeline
+    ) != VK_SUCCESS){
+        throw std::runtime_error("Error: Failed to create reconstruct pipeline.");
+    }
+
     vkDestroyShaderModule(device->get_device(), module, nullptr);    
 }
 
@@ -232,8 +383,8 @@ void renderer_t::create_render_pass(){
 }
 
 void renderer_t::create_graphics_pipeline(){
-    VkShaderModule vert_shader_module = create_shader_module(vertex_shader_code);
-    VkShaderModule frag_shader_module = create_shader_module(fragment_shader_code);
+    VkShaderModule vert_shader_module = create_shader_module(shader::vertex);
+    VkShaderModule frag_shader_module = create_shader_module(shader::fragment);
 
     VkPipelineShaderStageCreateInfo vert_create_info = {}; 
     vert_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -374,7 +525,7 @@ void renderer_t::create_graphics_pipeline(){
     pipeline_info.basePipelineIndex = -1;
 
     if (vkCreateGraphicsPipelines(
-	    device->get_device(), VK_NULL_HANDLE, 1, 
+	    device->get_device(), pipeline_cache->get_handle(), 1, 
         &pipeline_info, nullptr, &graphics_pipeline
     ) != VK_SUCCESS){
         throw std::runtime_error("Error: Failed to create graphics pipeline.");
@@ -411,6 +562,8 @@ void renderer_t::create_framebuffers(){
 void renderer_t::create_command_buffers(){
     command_buffers.clear();
 
+    // one per frame in flight and swapchain image, indexed by get_command_buffer_index
+    for (uint32_t j = 0; j < frames_in_flight; j++)
     for (uint32_t i = 0; i < swapchain->get_size(); i++){
         command_buffers.push_back(graphics_command_pool->reusable_buffer([&](auto command_buffer){
             VkRenderPassBeginInfo render_pass_info = {};
@@ -420,6 +573,8 @@ void renderer_t::create_command_buffers(){
             render_pass_info.renderArea.offset = { 0, 0 };
             render_pass_info.renderArea.extent = swapchain->get_extents();
 
+            profiler->record_begin(command_buffer, frames_in_flight + j, profiler_t::gpu_stage_graphics);
+
             vkCmdBeginRenderPass(command_buffer, &render_pass_info, VK_SUBPASS_CONTENTS_INLINE);
                 vkCmdBindPipeline(
                     command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphics_pipeline
@@ -427,41 +582,54 @@ void renderer_t::create_command_buffers(){
 
                 vkCmdBindDescriptorSets(
                     command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout,
-                    0, 1, &desc_sets[i], 0, nullptr
+                    0, 1, &desc_sets[j], 0, nullptr
                 );
 
                 vkCmdDraw(command_buffer, 3, 1, 0, 0);
             vkCmdEndRenderPass(command_buffer);
+
+            profiler->record_end(command_buffer, frames_in_flight + j, profiler_t::gpu_stage_graphics);
         }));
     }
 }
 
+uint32_t renderer_t::get_command_buffer_index(uint32_t frame, uint32_t image_index) const {
+    return frame * swapchain->get_size() + image_index;
+}
+
 void renderer_t::create_descriptor_pool(){
-    std::vector<VkDescriptorPoolSize> pool_sizes = {
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         swapchain->get_size() },
-        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          swapchain->get_size() },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, swapchain->get_size() }
-    };
+    uint32_t n = frames_in_flight;
+
+    // every set holds one of each binding in the layout
+    std::map<VkDescriptorType, uint32_t> counts;
+    for (auto & binding : descriptor_bindings){
+        counts[binding.descriptorType] += binding.descriptorCount * n;
+    }
+
+    std::vector<VkDescriptorPoolSize> pool_sizes;
+    for (auto & count : counts){
+        pool_sizes.push_back({ count.first, count.second });
+    }
 
     VkDescriptorPoolCreateInfo pool_info = {};
     pool_info.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
     pool_info.poolSizeCount = pool_sizes.size();
     pool_info.pPoolSizes    = pool_sizes.data();
-    pool_info.maxSets       = swapchain->get_size();
+    pool_info.maxSets       = n;
 
     if (vkCreateDescriptorPool(device->get_device(), &pool_info, nullptr, &desc_pool) != VK_SUCCESS){
 	    throw std::runtime_error("Error: Failed to create descriptor pool.");
     }
 
-    std::vector<VkDescriptorSetLayout> layouts(swapchain->get_size(), descriptor_layout);
+    std::vector<VkDescriptorSetLayout> layouts(n, descriptor_layout);
 
     VkDescriptorSetAllocateInfo alloc_info = {};
     alloc_info.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
     alloc_info.descriptorPool     = desc_pool;
-    alloc_info.descriptorSetCount = swapchain->get_size();
+    alloc_info.descriptorSetCount = n;
     alloc_info.pSetLayouts        = layouts.data();
 
-    desc_sets.resize(swapchain->get_size());
+    desc_sets.resize(n);
     if (vkAllocateDescriptorSets(device->get_device(), &alloc_info, desc_sets.data()) != VK_SUCCESS){
 	    throw std::runtime_error("Error: Failed to allocate descriptor sets.");
     }
@@ -474,8 +642,19 @@ void renderer_t::create_descriptor_set_layout(){
     image_layout.descriptorCount = 1;
     image_layout.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT;
 
-    std::vector<VkDescriptorSetLayoutBinding> layouts = { 
+    VkDescriptorSetLayoutBinding sample_layout = {};
+    sample_layout.binding = sample_binding;
+    sample_layout.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+    sample_layout.descriptorCount = 1;
+    sample_layout.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+    VkDescriptorSetLayoutBinding history_layout = sample_layout;
+    history_layout.binding = history_binding;
+
+    descriptor_bindings = { 
         image_layout, 
+        sample_layout,
+        history_layout,
         normal_texture->get_descriptor_layout_binding(),
         colour_texture->get_descriptor_layout_binding(),
 
@@ -484,14 +663,17 @@ void renderer_t::create_descriptor_set_layout(){
         light_buffer->get_descriptor_set_layout_binding(),
         call_buffer->get_descriptor_set_layout_binding(),
         pointer_buffer->get_descriptor_set_layout_binding(),
-        frustum_buffer->get_descriptor_set_layout_binding(),
-        lighting_buffer->get_descriptor_set_layout_binding()
+        patch_age_buffer->get_descriptor_set_layout_binding(),
+        cluster_buffer->get_descriptor_set_layout_binding(),
+        bvh_buffer->get_descriptor_set_layout_binding(),
+        shadow_buffer->get_descriptor_set_layout_binding(),
+        shadow_request_buffer->get_descriptor_set_layout_binding()
     };
 
     VkDescriptorSetLayoutCreateInfo layout_info = {};
     layout_info.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layout_info.bindingCount = layouts.size();
-    layout_info.pBindings    = layouts.data();
+    layout_info.bindingCount = descriptor_bindings.size();
+    layout_info.pBindings    = descriptor_bindings.data();
 
     if (vkCreateDescriptorSetLayout(device->get_device(), &layout_info, nullptr, &descriptor_layout) != VK_SUCCESS){
         throw std::runtime_error("Error: Failed to create descriptor set layout.");
@@ -503,6 +685,7 @@ void renderer_t::create_sync(){
     compute_done_semas.resize(frames_in_flight);
     render_finished_semas.resize(frames_in_flight);
     in_flight_fences.resize(frames_in_flight);
+    compute_fences.resize(frames_in_flight);
 
     VkSemaphoreCreateInfo create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -517,6 +700,7 @@ void renderer_t::create_sync(){
         result |= vkCreateSemaphore(device->get_device(), &create_info, nullptr, &render_finished_semas[i]);
         result |= vkCreateSemaphore(device->get_device(), &create_info, nullptr, &compute_done_semas[i]);
         result |= vkCreateFence(device->get_device(), &fence_info, nullptr, &in_flight_fences[i]);
+        result |= vkCreateFence(device->get_device(), &fence_info, nullptr, &compute_fences[i]);
     }
 
     if (result != VK_SUCCESS){
@@ -538,87 +722,300 @@ void renderer_t::present(uint32_t image_index) const {
     vkQueuePresentKHR(present_queue, &present_info);
 }
 
+// sphere around the world space bounds of a substance, as its centre and radius
+static f32vec4_t get_bounding_sphere(const substance_t::data_t & data){
+    return f32vec4_t(data.transform.get(0, 3), data.transform.get(1, 3), data.transform.get(2, 3), vec::length(data.r));
+}
+
+static double milliseconds_since(std::chrono::steady_clock::time_point & previous){
+    auto now = std::chrono::steady_clock::now();
+    double time = std::chrono::duration_cast<std::chrono::microseconds>(now - previous).count() / 1000.0;
+    previous = now;
+    return time;
+}
+
 void renderer_t::render(){
     frames++;
 
-    uint32_t size = work_group_size[0] * work_group_size[1];
+    auto render_start = std::chrono::steady_clock::now();
+    auto stage_start = render_start;
 
-    // write substances
+    // the frame that last used this slot has to finish drawing before its render texture
+    // and queries are reused, after which its sample is complete
+    if (!is_headless){
+        vkWaitForFences(device->get_device(), 1, &in_flight_fences[current_frame], VK_TRUE, ~((uint64_t) 0));
+        vkResetFences(device->get_device(), 1, &in_flight_fences[current_frame]);
+
+        if (push_constants.current_frame >= frames_in_flight){
+            profiler->resolve(current_frame, frames_in_flight + current_frame, profiler_t::gpu_stage_graphics);
+            profiler->end_frame(current_frame);
+        }
+    }
+
+    double wait_time = milliseconds_since(stage_start);
+    profiler->begin_frame(current_frame, push_constants.current_frame);
+    profiler->set_resolution_scale(current_frame, static_cast<double>(render_size[0]) / size[0]);
+
+    // write substances, and the hierarchy the raymarch traverses them through
     std::vector<substance_t::data_t> substance_data;
-    for (auto s : substances){
-        substance_data.push_back(s->get_data(main_camera.lock()->get_position()));
+    substance_data.reserve(substances.size());
+    for (uint32_t i = 0; i < substances.size(); i++){
+        substance_t::data_t data = substances[i]->get_data(main_camera.lock()->get_position());
+        if (data.near < push_constants.render_distance){
+            substance_data.push_back(data);
+        }
+
+        // movement below epsilon accumulates until it is noticed
+        substance_t::data_t & previous = substance_history[i];
+        bool is_new = previous.id == static_cast<uint32_t>(~0);
+        if (is_new || vec::length(data.transform - previous.transform) > constant::epsilon || data.r != previous.r){
+            if (!is_new){
+                moved_bounds.push_back(get_bounding_sphere(previous));
+            }
+            moved_bounds.push_back(get_bounding_sphere(data));
+            previous = data;
+        }
     }
-    substance_data.resize(size);
 
-    std::sort(substance_data.begin(), substance_data.end(), substance_t::data_t::comparator_t());
+    bvh.build(substance_data);
+    bvh_buffer->write(bvh.get_nodes(), 0);
 
+    // nothing references the substance buffer when the hierarchy is empty, but every
+    // buffer is written each frame
+    if (substance_data.empty()){
+        substance_data.emplace_back();
+    }
     substance_buffer->write(substance_data, 0);
 
-    // write lights
-    std::vector<light_t> lights(size);
-    lights[0] = light_t(f32vec3_t(0, 4.0f, -4.0f), f32vec4_t(50.0f));
-    light_buffer->write(lights, 0);
+    // write lights, leaving the rest of the buffer invalid for the cluster pass to skip
+    std::vector<light_t::data_t> light_data(light_capacity);
+    update_light_versions(light_data);
+    light_buffer->write(light_data, 0);
+    cluster_buffer->write_element(0, cluster_overflow_offset);
     
     if (auto camera = main_camera.lock()){
         push_constants.eye_transform = camera->get_matrix();
     }
-   
-    uint32_t image_index;
-    vkAcquireNextImageKHR(
-        device->get_device(), swapchain->get_handle(), ~static_cast<uint64_t>(0), image_available_semas[current_frame], 
-        VK_NULL_HANDLE, &image_index
-    );
+
+    push_constants.render_size = render_size;
+    push_constants.jitter = get_jitter();
+
+    // a full size raymarch lands on every pixel, so there is nothing to reconstruct
+    reconstruct_constant_t reconstruct_constants;
+    reconstruct_constants.size = size;
+    reconstruct_constants.render_size = render_size;
+    reconstruct_constants.jitter = push_constants.jitter;
+    reconstruct_constants.focal_depth = push_constants.focal_depth;
+    reconstruct_constants.history_weight = has_history && render_size != size ? history_weight : 0.0f;
+    reconstruct_constants.reprojection = has_history ? 
+        mat::inverse(previous_eye_transform) * push_constants.eye_transform : 
+        f32mat4_t::identity();
+
+    profiler->set_cpu_time(current_frame, profiler_t::cpu_stage_upload, milliseconds_since(stage_start));
 
     handle_requests(current_frame);
+    profiler->set_cpu_time(current_frame, profiler_t::cpu_stage_requests, milliseconds_since(stage_start));
+
+    auto compute_command_buffer = compute_command_pool->one_time_buffer([&](auto command_buffer){
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_write);
 
-    compute_command_pool->one_time_buffer([&](auto command_buffer){
         substance_buffer->record_write(command_buffer);
         patch_buffer->record_write(command_buffer);
+        patch_age_buffer->record_write(command_buffer);
+        pointer_buffer->record_write(command_buffer);
         light_buffer->record_write(command_buffer);
+        cluster_buffer->record_write(command_buffer);
+        shadow_buffer->record_write(command_buffer);
+        shadow_request_buffer->record_write(command_buffer);
 
         normal_texture->record_write(command_buffer);
         colour_texture->record_write(command_buffer);
 
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_write);
+
         vkCmdPushConstants(
             command_buffer, compute_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
             0, sizeof(push_constant_t), &push_constants
         );
 
-        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline);
         vkCmdBindDescriptorSets(
             command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipeline_layout,
-            0, 1, &desc_sets[image_index], 0, nullptr
+            0, 1, &desc_sets[current_frame], 0, nullptr
+        );
+
+        // one work group per cluster lists the lights that reach it
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_cluster);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, cluster_pipeline);
+        vkCmdDispatch(command_buffer, cluster_grid_x, cluster_grid_y, cluster_grid_z);
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_cluster);
+
+        // cells requested by the last frame have their shadows marched, a work group each
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_shadow);
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, shadow_pipeline);
+        vkCmdDispatch(command_buffer, number_of_shadow_requests, 1, 1);
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_shadow);
+
+        // make the light lists, the shadows and the samples visible to the passes that read them
+        VkMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(
+            command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr
         );
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, variants[variant].pipeline);
+
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_dispatch);
+        u32vec2_t work_group_count = get_work_group_count();
         vkCmdDispatch(command_buffer, work_group_count[0], work_group_count[1], 1);
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_dispatch);
+
+        vkCmdPipelineBarrier(
+            command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr
+        );
+
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_reconstruct);
+
+        vkCmdPushConstants(
+            command_buffer, reconstruct_pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT,
+            0, sizeof(reconstruct_constant_t), &reconstruct_constants
+        );
+
+        vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, reconstruct_pipeline);
+        vkCmdBindDescriptorSets(
+            command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, reconstruct_pipeline_layout,
+            0, 1, &desc_sets[current_frame], 0, nullptr
+        );
+
+        uint32_t n = reconstruct_work_group_size;
+        vkCmdDispatch(command_buffer, (size[0] + n - 1) / n, (size[1] + n - 1) / n, 1);
+
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_reconstruct);
+
+        profiler->record_begin(command_buffer, current_frame, profiler_t::gpu_stage_read);
 
         call_buffer->record_read(command_buffer);
+        cluster_buffer->record_read(command_buffer, cluster_overflow_offset, 1);
 
-    })->submit(
-        image_available_semas[current_frame], compute_done_semas[current_frame], 
-        in_flight_fences[current_frame], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT
+        if (is_headless){
+            record_readback(command_buffer);
+        }
+
+        profiler->record_end(command_buffer, current_frame, profiler_t::gpu_stage_read);
+    });
+
+    // the raymarch does not touch the swapchain, so it is submitted before acquiring an
+    // image and can overlap the previous frame's fragment pass and present
+    vkResetFences(device->get_device(), 1, &compute_fences[current_frame]);
+    compute_command_buffer->submit(
+        {}, {}, is_headless ? VK_NULL_HANDLE : compute_done_semas[current_frame], compute_fences[current_frame]
     );
     
-    command_buffers[image_index]->submit(
-        compute_done_semas[current_frame], render_finished_semas[current_frame], 
-        in_flight_fences[current_frame], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT
-    );
+    if (!is_headless){
+        uint32_t image_index;
+        vkAcquireNextImageKHR(
+            device->get_device(), swapchain->get_handle(), ~static_cast<uint64_t>(0), image_available_semas[current_frame], 
+            VK_NULL_HANDLE, &image_index
+        );
+
+        command_buffers[get_command_buffer_index(current_frame, image_index)]->submit(
+            { compute_done_semas[current_frame], image_available_semas[current_frame] }, 
+            { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT },
+            render_finished_semas[current_frame], in_flight_fences[current_frame]
+        );
 
-    present(image_index);
+        present(image_index);
+    }
 
-    vkWaitForFences(device->get_device(), 1, &in_flight_fences[current_frame], VK_TRUE, ~((uint64_t) 0));
-    vkResetFences(device->get_device(), 1, &in_flight_fences[current_frame]);   
+    profiler->set_cpu_time(current_frame, profiler_t::cpu_stage_record, milliseconds_since(stage_start));
+
+    // only the compute work has to finish before the next frame, since it produces the
+    // calls read back by handle_requests and consumes the shared staging buffers
+    vkWaitForFences(device->get_device(), 1, &compute_fences[current_frame], VK_TRUE, ~((uint64_t) 0));
+
+    wait_time += milliseconds_since(stage_start);
+    profiler->set_cpu_time(current_frame, profiler_t::cpu_stage_wait, wait_time);
+
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_write);
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_cluster);
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_shadow);
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_dispatch);
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_reconstruct);
+    profiler->resolve(current_frame, current_frame, profiler_t::gpu_stage_read);
+
+    cluster_buffer->map(cluster_overflow_offset, 1, [&](void * memory_map){
+        profiler->set_dropped_lights(current_frame, *static_cast<uint32_t *>(memory_map));
+    });
+
+    if (is_headless){
+        readback_buffer->map(0, frame.size(), [&](void * memory_map){
+            std::memcpy(frame.data(), memory_map, frame.size() * sizeof(uint32_t));
+        });
+    }
+
+    profiler->set_cpu_time(current_frame, profiler_t::cpu_stage_render, milliseconds_since(render_start));
+
+    // without a graphics pass the sample is already complete
+    if (is_headless){
+        profiler->end_frame(current_frame);
+    }
+
+    previous_eye_transform = push_constants.eye_transform;
+    has_history = true;
+
+    // resolution stays fixed while work group shapes are compared
+    if (is_tuning){
+        update_autotune();
+    } else {
+        update_resolution();
+    }
     
     push_constants.current_frame++;
     current_frame = (current_frame + 1) % frames_in_flight; 
 }
 
-VkShaderModule renderer_t::create_shader_module(std::string code){
-    const char * c_string = code.c_str();
-    
+void renderer_t::record_readback(VkCommandBuffer command_buffer){
+    // make the compute shader's writes visible to the copy
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = render_textures[current_frame]->get_image();
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+
+    vkCmdPipelineBarrier(
+        command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier
+    );
+
+    u32vec2_t size = get_size();
+
+    VkBufferImageCopy region = {};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { size[0], size[1], 1 };
+
+    vkCmdCopyImageToBuffer(
+        command_buffer, render_textures[current_frame]->get_image(), VK_IMAGE_LAYOUT_GENERAL,
+        readback_buffer->get_buffer(), 1, &region
+    );
+}
+
+VkShaderModule renderer_t::create_shader_module(const shader::code_t & code){
     VkShaderModuleCreateInfo create_info = {};
     create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO; 
-    create_info.codeSize = code.size();
-    create_info.pCode = reinterpret_cast<const uint32_t *>(c_string);
+    create_info.codeSize = code.size;
+    create_info.pCode = code.words;
 
     VkShaderModule shader_module;
     if (vkCreateShaderModule(device->get_device(), &create_info, nullptr, &shader_module) != VK_SUCCESS){
@@ -632,8 +1029,8 @@ void renderer_t::set_main_camera(std::weak_ptr<camera_t> camera){
 }
 
 void renderer_t::handle_requests(uint32_t frame){
-    vkDeviceWaitIdle(device->get_device()); 
-
+    // the previous dispatch was waited on at the end of the last frame, so the call
+    // buffer is up to date without idling the device
     std::vector<call_t> calls(number_of_calls);
     std::vector<call_t> empty_calls(number_of_calls);
 
@@ -642,14 +1039,21 @@ void renderer_t::handle_requests(uint32_t frame){
         std::memcpy(memory_map, empty_calls.data(), calls.size() * sizeof(call_t));
     });
 
+    // calls that chose the same victim are only answered once, and the rest are made again
+    // next frame, when that slot is the most recently used of its bucket
+    std::set<uint32_t> filled;
+    uint32_t requests = 0;
+    uint32_t evictions = 0;
+
     for (auto & call : calls){
         if (call.is_valid()){
-            auto lookup_substance = std::make_shared<substance_t>(call.get_substance_ID());
-            auto substance_iterator = substances.find(lookup_substance);
+            auto shape = shapes.find(call.get_shape_ID());
+            requests++;
 
-            if (substance_iterator != substances.end()){
-                auto response = get_response(call, *substance_iterator);
+            if (shape != shapes.end() && filled.insert(call.get_index()).second){
+                auto response = get_response(call, shape->second);
                 patch_buffer->write_element(response.get_patch(), call.get_index());
+                patch_age_buffer->write_element(push_constants.current_frame, call.get_index());
 
                 u32vec3_t p = u32vec3_t(
                     call.get_index() % patch_image_size,
@@ -660,35 +1064,347 @@ void renderer_t::handle_requests(uint32_t frame){
                 normal_texture->write(p, response.get_normals());
                 colour_texture->write(p, response.get_colours());
 
-                indices.insert(call.get_index());
-                hashes.insert(call.get_hash());
+                evictions += resident_patches[call.get_index()];
+                resident_patches[call.get_index()] = true;
             } 
         }
     }   
+
+    profiler->set_patch_churn(frame, requests, evictions);
+}
+
+uint32_t renderer_t::get_work_group_area() const {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->get_physical_device(), &properties);
+
+    // largest power of two the device allows, up to the size the shader was written for
+    uint32_t area = max_work_group_area;
+    while (area > properties.limits.maxComputeWorkGroupInvocations){
+        area /= 2;
+    }
+    return area;
+}
+
+std::vector<u32vec2_t> renderer_t::get_work_group_sizes() const {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->get_physical_device(), &properties);
+    const uint32_t * max_size = properties.limits.maxComputeWorkGroupSize;
+
+    std::vector<u32vec2_t> sizes;
+    for (uint32_t x = min_work_group_side; x * min_work_group_side <= work_group_area; x *= 2){
+        uint32_t y = work_group_area / x;
+        if (x <= max_size[0] && y <= max_size[1] && size[0] % x == 0 && size[1] % y == 0){
+            sizes.push_back(u32vec2_t(x, y));
+        }
+    }
+
+    if (sizes.empty()){
+        throw std::runtime_error("Error: No work group size divides the render size.");
+    }
+
+    return sizes;
+}
+
+u32vec2_t renderer_t::get_work_group_count() const {
+    u32vec2_t work_group_size = variants[variant].work_group_size;
+    return u32vec2_t(render_size[0] / work_group_size[0], render_size[1] / work_group_size[1]);
+}
+
+std::string renderer_t::get_autotune_key() const {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(device->get_physical_device(), &properties);
+
+    // fnv-1a over the compute shader, so that edits to it invalidate old results
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < shader::compute.size / sizeof(uint32_t); i++){
+        hash = (hash ^ shader::compute.words[i]) * 1099511628211ull;
+    }
+
+    std::stringstream key;
+    key << std::hex << 
+        properties.vendorID << ":" << properties.deviceID << ":" << properties.driverVersion << ":" << 
+        hash << ":" << std::dec << size[0] << "x" << size[1];
+    return key.str();
+}
+
+std::map<std::string, u32vec2_t> renderer_t::load_autotune() const {
+    std::map<std::string, u32vec2_t> results;
+    std::stringstream file(resources::load_file(autotune_path));
+
+    std::string key;
+    uint32_t x, y;
+    while (file >> key >> x >> y){
+        results[key] = u32vec2_t(x, y);
+    }
+
+    return results;
+}
+
+void renderer_t::create_variants(){
+    auto sizes = get_work_group_sizes();
+    auto results = load_autotune();
+    auto result = results.find(get_autotune_key());
+
+    // reuse an earlier result if it is still one of the candidates
+    if (result != results.end() && std::find(sizes.begin(), sizes.end(), result->second) != sizes.end()){
+        sizes = { result->second };
+    }
+
+    for (auto & work_group_size : sizes){
+        variants.push_back({ work_group_size, create_compute_pipeline(shader::compute, work_group_size), 0.0, 0 });
+    }
+
+    variant = 0;
+    tuning_frame = 0;
+    is_tuning = variants.size() > 1;
+}
+
+void renderer_t::update_autotune(){
+    auto & sample = profiler->get_pending(current_frame);
+    double time = sample.gpu[profiler_t::gpu_stage_dispatch];
+    if (time < 0){
+        time = sample.cpu[profiler_t::cpu_stage_render];
+    }
+
+    // the first frame of each variant warms up caches and is discarded
+    if (tuning_frame > 0){
+        variants[variant].time += time;
+        variants[variant].samples++;
+    }
+
+    if (++tuning_frame < autotune_frames){
+        return;
+    }
+
+    tuning_frame = 0;
+    if (++variant < variants.size()){
+        return;
+    }
+
+    // every frame waits on its fence before returning, so no pipeline is still in use
+    auto best = std::min_element(variants.begin(), variants.end(), [](const variant_t & a, const variant_t & b){
+        return a.time / a.samples < b.time / b.samples;
+    });
+
+    for (auto it = variants.begin(); it != variants.end(); it++){
+        if (it != best){
+            vkDestroyPipeline(device->get_device(), it->pipeline, nullptr);
+        }
+    }
+
+    variants = { *best };
+    variant = 0;
+    is_tuning = false;
+
+    u32vec2_t work_group_size = variants[0].work_group_size;
+    std::cout << 
+        "Autotuned work group size: " << work_group_size[0] << "x" << work_group_size[1] << 
+        " (" << variants[0].time / variants[0].samples << " ms)" << std::endl;
+
+    auto results = load_autotune();
+    results[get_autotune_key()] = work_group_size;
+
+    std::stringstream file;
+    for (auto & result : results){
+        file << result.first << " " << result.second[0] << " " << result.second[1] << std::endl;
+    }
+
+    std::string data = file.str();
+    resources::save_file(autotune_path, data.data(), data.size());
+}
+
+static float halton(uint32_t i, uint32_t base){
+    float f = 1.0f;
+    float r = 0.0f;
+    for (; i > 0; i /= base){
+        f /= base;
+        r += f * (i % base);
+    }
+    return r;
+}
+
+// milliseconds the compute queue spent on a frame, from the first write to the readback,
+// or negative if any of its stages went unmeasured
+static double get_compute_time(const profiler_t::sample_t & sample){
+    double time = 0.0;
+    for (auto stage : { 
+        profiler_t::gpu_stage_write, profiler_t::gpu_stage_cluster, profiler_t::gpu_stage_shadow, profiler_t::gpu_stage_dispatch, 
+        profiler_t::gpu_stage_reconstruct, profiler_t::gpu_stage_read 
+    }){
+        if (sample.gpu[stage] < 0){
+            return -1.0;
+        }
+        time += sample.gpu[stage];
+    }
+    return time;
+}
+
+f32vec2_t renderer_t::get_jitter() const {
+    if (render_size == size){
+        return f32vec2_t(0.0f);
+    }
+
+    // low discrepancy offsets, so that successive frames sample between each other
+    uint32_t i = push_constants.current_frame % jitter_frames + 1;
+    return f32vec2_t(halton(i, 2), halton(i, 3));
+}
+
+void renderer_t::update_resolution(){
+    auto & sample = profiler->get_pending(current_frame);
+
+    double time = get_compute_time(sample);
+    if (time < 0){
+        time = sample.cpu[profiler_t::cpu_stage_render];
+    }
+
+    // the cost of the raymarch grows with its area, so each side is scaled by the
+    // square root of how far the last frame was from the budget
+    float target = 1.0f;
+    if (frame_budget > 0 && time > 0){
+        float area = static_cast<float>(render_size[0] * render_size[1]) / (size[0] * size[1]);
+        target = std::sqrt(area * static_cast<float>(frame_budget / time));
+    }
+
+    resolution_scale += (target - resolution_scale) * resolution_gain;
+    resolution_scale = std::min(std::max(resolution_scale, min_resolution_scale), 1.0f);
+
+    // work groups are renumbered on a resize, which scatters the patches each one loads into
+    // shared memory, so the size is held for a few frames between changes
+    if (push_constants.current_frame < resize_frame + resolution_interval){
+        return;
+    }
+
+    u32vec2_t work_group_size = variants[variant].work_group_size;
+    u32vec2_t new_size;
+    for (int i = 0; i < 2; i++){
+        uint32_t n = static_cast<uint32_t>(std::round(size[i] * resolution_scale / work_group_size[i]));
+        new_size[i] = std::max(n, 1u) * work_group_size[i];
+    }
+
+    if (new_size != render_size){
+        render_size = new_size;
+        resize_frame = push_constants.current_frame;
+    }
 }
 
 void renderer_t::create_buffers(){
-    uint32_t c = work_group_count[0] * work_group_count[1];
-    uint32_t s = work_group_size[0] * work_group_size[1];
+    // every work group shape has the same area, so the number of work groups is fixed too
+    uint32_t c = size[0] * size[1] / work_group_area;
+    uint32_t s = work_group_area;
 
     patch_buffer = std::make_unique<device_buffer_t<response_t::patch_t>>(1, device, number_of_patches);
     call_buffer = std::make_unique<device_buffer_t<call_t>>(2, device, number_of_calls);
-    light_buffer = std::make_unique<device_buffer_t<light_t>>(3, device, s);
-    substance_buffer = std::make_unique<device_buffer_t<substance_t::data_t>>(4, device, s);
+    light_buffer = std::make_unique<device_buffer_t<light_t::data_t>>(3, device, light_capacity);
     pointer_buffer = std::make_unique<device_buffer_t<uint32_t>>(5, device, c * s);
-    frustum_buffer = std::make_unique<device_buffer_t<f32vec2_t>>(6, device, c);
-    lighting_buffer = std::make_unique<device_buffer_t<f32vec4_t>>(7, device, c);
+    patch_age_buffer = std::make_unique<device_buffer_t<uint32_t>>(patch_age_binding, device, number_of_patches);
+
+    // pointers are followed before any are written, and unused slots are the oldest
+    pointer_buffer->write(std::vector<uint32_t>(c * s), 0);
+    patch_age_buffer->write(std::vector<uint32_t>(number_of_patches), 0);
+    resident_patches.assign(number_of_patches, false);
+
+    // each cluster holds its number of lights followed by their indices
+    cluster_buffer = std::make_unique<device_buffer_t<uint32_t>>(cluster_binding, device, cluster_overflow_offset + 1);
+
+    // both start zeroed, and no light is ever given version zero
+    shadow_buffer = std::make_unique<device_buffer_t<shadow_t>>(shadow_binding, device, shadow_pool_size);
+    shadow_request_buffer = std::make_unique<device_buffer_t<shadow_request_t>>(
+        shadow_request_binding, device, number_of_shadow_requests
+    );
+    shadow_buffer->write(std::vector<shadow_t>(shadow_pool_size), 0);
+    shadow_request_buffer->write(std::vector<shadow_request_t>(number_of_shadow_requests), 0);
+
+    create_substance_buffers();
+}
+
+void renderer_t::create_substance_buffers(){
+    // a binary hierarchy over n leaves has 2n - 1 nodes
+    substance_buffer = std::make_unique<device_buffer_t<substance_t::data_t>>(4, device, substance_capacity);
+    bvh_buffer = std::make_unique<device_buffer_t<bvh_t::node_t>>(bvh_binding, device, 2 * substance_capacity - 1);
+}
+
+void renderer_t::reserve_substances(uint32_t n){
+    if (n <= substance_capacity){
+        return;
+    }
+
+    // buffers are replaced rather than resized, so nothing in flight may still use them
+    vkDeviceWaitIdle(device->get_device());
+
+    substance_capacity = std::max(n, substance_capacity * 2);
+    create_substance_buffers();
+
+    std::vector<VkWriteDescriptorSet> write_desc_sets;
+    for (auto descriptor_set : desc_sets){
+        write_desc_sets.push_back(substance_buffer->get_write_descriptor_set(descriptor_set));
+        write_desc_sets.push_back(bvh_buffer->get_write_descriptor_set(descriptor_set));
+    }
+
+    update_descriptor_sets(write_desc_sets);
+}
+
+void renderer_t::reserve_lights(uint32_t n){
+    if (n <= light_capacity){
+        return;
+    }
+
+    vkDeviceWaitIdle(device->get_device());
+
+    light_capacity = std::max(n, light_capacity * 2);
+    light_buffer = std::make_unique<device_buffer_t<light_t::data_t>>(3, device, light_capacity);
+
+    std::vector<VkWriteDescriptorSet> write_desc_sets;
+    for (auto descriptor_set : desc_sets){
+        write_desc_sets.push_back(light_buffer->get_write_descriptor_set(descriptor_set));
+    }
+
+    update_descriptor_sets(write_desc_sets);
 }
 
+void renderer_t::update_light_versions(std::vector<light_t::data_t> & light_data){
+    for (uint32_t i = 0; i < lights.size(); i++){
+        light_t::data_t data = lights[i]->get_data();
+        light_t::data_t & previous = light_history[i];
+
+        // the id changes when the light is registered or moved in the list
+        bool is_changed = previous.id != data.id || previous.x != data.x || previous.colour != data.colour;
+
+        // anything moving within reach of the light may have changed its shadows, see cluster.glsl
+        float reach = std::sqrt(std::max({ data.colour[0], data.colour[1], data.colour[2] }) / light_cutoff);
+        for (auto & bounds : moved_bounds){
+            f32vec3_t centre(bounds[0], bounds[1], bounds[2]);
+            is_changed |= vec::length(centre - data.x) < reach + bounds[3];
+        }
+
+        if (is_changed){
+            previous = data;
+            previous.version = ++shadow_version == 0 ? ++shadow_version : shadow_version;
+        }
 
-response_t renderer_t::get_response(const call_t & call, std::weak_ptr<substance_t> substance){
+        light_data[i] = previous;
+    }
+
+    moved_bounds.clear();
+}
+
+void renderer_t::update_descriptor_sets(const std::vector<VkWriteDescriptorSet> & write_desc_sets){
+    vkUpdateDescriptorSets(device->get_device(), write_desc_sets.size(), write_desc_sets.data(), 0, nullptr);
+
+    // updating a descriptor set invalidates the command buffers it is bound in
+    if (!is_headless){
+        create_command_buffers();
+    }
+}
+
+
+response_t renderer_t::get_response(const call_t & call, const shape_t & shape){
     if (response_cache.size() > max_cache_size){
         response_cache.erase(*prev_calls.begin());
         prev_calls.pop_front();     
     } 
 
     if (response_cache.count(call) == 0){
-        auto result = response_cache.emplace(call, response_t(call, substance));
+        auto result = response_cache.emplace(call, response_t(call, shape.sdf, shape.matter));
         if (std::get<1>(result)){
             prev_calls.push_back(std::get<0>(result));
         }
@@ -697,14 +1413,104 @@ response_t renderer_t::get_response(const call_t & call, std::weak_ptr<substance
     return response_cache[call];
 }
 
+void renderer_t::add_shape(substance_t * substance){
+    srph_matter * matter = &substance->matter;
+    auto result = shapes.emplace(
+        substance->get_shape(), shape_t { matter->sdf, matter->is_uniform ? NULL : matter, 0 }
+    );
+
+    // requests for a shape can arrive until its last instance is unregistered
+    if (result.second){
+        srph_sdf_acquire(matter->sdf);
+    }
+
+    result.first->second.instances++;
+}
+
+void renderer_t::remove_shape(substance_t * substance){
+    auto it = shapes.find(substance->get_shape());
+    if (it != shapes.end() && --it->second.instances == 0){
+        srph_sdf_destroy(it->second.sdf);
+        shapes.erase(it);
+    }
+}
+
 void renderer_t::register_substance(std::shared_ptr<substance_t> substance){
-    substances.insert(substance);
+    register_substances({ substance });
+}
+
+void renderer_t::register_substances(const std::vector<std::shared_ptr<substance_t>> & substances){
+    reserve_substances(this->substances.size() + substances.size());
+
+    this->substances.reserve(this->substances.size() + substances.size());
+    for (auto & substance : substances){
+        substance->_renderer_index = this->substances.size();
+        this->substances.push_back(substance);
+        substance_history.emplace_back();
+        add_shape(substance.get());
+    }
 }
 
 void renderer_t::unregister_substance(std::shared_ptr<substance_t> substance){
-    auto it = substances.find(substance);
-    if (it != substances.end()){
-        substances.erase(it);
+    unregister_substances({ substance });
+}
+
+void renderer_t::unregister_substances(const std::vector<std::shared_ptr<substance_t>> & substances){
+    for (auto & substance : substances){
+        uint32_t i = substance->_renderer_index;
+        if (i >= this->substances.size() || this->substances[i] != substance){
+            continue;
+        }
+
+        remove_shape(substance.get());
+
+        if (substance_history[i].id != static_cast<uint32_t>(~0)){
+            moved_bounds.push_back(get_bounding_sphere(substance_history[i]));
+        }
+
+        // swap and pop, keeping the moved substance's index up to date
+        this->substances[i] = this->substances.back();
+        this->substances[i]->_renderer_index = i;
+        this->substances.pop_back();
+
+        substance_history[i] = substance_history.back();
+        substance_history.pop_back();
+    }
+}
+
+void renderer_t::register_light(std::shared_ptr<light_t> light){
+    register_lights({ light });
+}
+
+void renderer_t::register_lights(const std::vector<std::shared_ptr<light_t>> & lights){
+    reserve_lights(this->lights.size() + lights.size());
+
+    this->lights.reserve(this->lights.size() + lights.size());
+    for (auto & light : lights){
+        light->_renderer_index = this->lights.size();
+        this->lights.push_back(light);
+        light_history.emplace_back();
+    }
+}
+
+void renderer_t::unregister_light(std::shared_ptr<light_t> light){
+    unregister_lights({ light });
+}
+
+void renderer_t::unregister_lights(const std::vector<std::shared_ptr<light_t>> & lights){
+    for (auto & light : lights){
+        uint32_t i = light->_renderer_index;
+        if (i >= this->lights.size() || this->lights[i] != light){
+            continue;
+        }
+
+        // swap and pop, keeping the moved light's index up to date
+        this->lights[i] = this->lights.back();
+        this->lights[i]->_renderer_index = i;
+        this->lights.pop_back();
+
+        light_history[i] = light_history.back();
+        light_history.pop_back();
     }
 }
 
@@ -713,3 +1519,28 @@ int renderer_t::get_frame_count(){
     frames = 0;
     return f;
 }
+
+double renderer_t::get_gpu_time() const {
+    auto sample = profiler->get_latest();
+    return sample == nullptr ? 0.0 : get_compute_time(*sample);
+}
+
+const profiler_t & renderer_t::get_profiler() const {
+    return *profiler;
+}
+
+const std::vector<uint32_t> & renderer_t::get_frame() const {
+    return frame;
+}
+
+void renderer_t::set_frame_budget(double milliseconds){
+    frame_budget = milliseconds;
+}
+
+u32vec2_t renderer_t::get_render_size() const {
+    return render_size;
+}
+
+u32vec2_t renderer_t::get_size() const {
+    return push_constants.window_size;
+}
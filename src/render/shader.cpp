@@ -0,0 +1,16 @@
+#include "render/shader.h"
+
+// generated by glslangValidator into the build directory
+#include "shader/comp.spv.h"
+#include "shader/vert.spv.h"
+#include "shader/frag.spv.h"
+#include "shader/reconstruct.spv.h"
+#include "shader/cluster.spv.h"
+
+using namespace srph;
+
+const shader::code_t shader::compute     = { comp_spv,        sizeof(comp_spv) };
+const shader::code_t shader::vertex      = { vert_spv,        sizeof(vert_spv) };
+const shader::code_t shader::fragment    = { frag_spv,        sizeof(frag_spv) };
+const shader::code_t shader::reconstruct = { reconstruct_spv, sizeof(reconstruct_spv) };
+const shader::code_t shader::cluster     = { cluster_spv,     sizeof(cluster_spv) };
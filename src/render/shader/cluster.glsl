@@ -0,0 +1,165 @@
+#version 450
+
+struct light_t {
+    vec3 x;
+    uint id;
+
+    vec3 colour;
+    uint version;
+};
+
+// specialised by the renderer with the same constants as comp.glsl
+layout (local_size_x_id = 0, local_size_y_id = 1) in;
+layout (constant_id = 6) const uint cluster_grid_x = 16;
+layout (constant_id = 7) const uint cluster_grid_y = 9;
+layout (constant_id = 8) const uint cluster_grid_z = 24;
+layout (constant_id = 9) const uint max_cluster_lights = 64;
+layout (constant_id = 10) const float cluster_near = 1.0;
+layout (constant_id = 11) const float light_cutoff = 0.00390625;
+
+const float max_float = 3.402823466e38;
+
+layout( push_constant ) uniform push_constants {
+    uvec2 window_size;
+    float render_distance;
+    uint current_frame;
+
+    float phi_initial;
+    float focal_depth;
+    uint number_of_calls;
+    uint _1;
+
+    mat4 eye_transform;
+} pc;
+
+layout (binding = 3) buffer lights_buffer  { light_t data[]; } lights;
+layout (binding = 8) buffer cluster_buffer { uint    data[]; } clusters;
+
+// lights are ranked in half octaves of their intensity at the cluster, from the cutoff up
+const uint buckets = 32u;
+
+shared uint histogram[buckets];
+shared int threshold;
+shared uint above;
+shared uint count;
+shared uint partial;
+
+// eye space position at a depth, seen through a point from 0 to 1 across the image
+vec3 eye_position(vec2 xy, float z){
+    vec2 uv = xy * 2.0 - 1.0;
+    uv.y *= -float(pc.window_size.y) / pc.window_size.x;
+    return vec3(uv / pc.focal_depth, 1) * z;
+}
+
+// the first slice reaches cluster_near, and the rest grow exponentially to the render distance
+float slice_depth(uint k){
+    float alpha = float(k - 1) / (cluster_grid_z - 1);
+    return k == 0 ? 0 : cluster_near * pow(pc.render_distance / cluster_near, alpha);
+}
+
+// the bucket of a light's intensity where it is nearest the cluster, or -1 if it falls
+// below the cutoff before reaching it
+int get_bucket(light_t l, vec3 lower, vec3 upper, mat3 view, vec3 eye){
+    vec3 x = view * (l.x - eye);
+    vec3 d = max(max(lower - x, x - upper), 0);
+
+    // attenuation is inverse square, so this is where the light falls below the cutoff
+    float intensity = max(l.colour.r, max(l.colour.g, l.colour.b));
+    float r = sqrt(intensity / light_cutoff);
+
+    if (l.id == ~0u || dot(d, d) >= r * r){
+        return -1;
+    }
+
+    float level = 2 * log2(intensity / (max(dot(d, d), 1e-6) * light_cutoff));
+    return int(clamp(level, 0.0, float(buckets - 1)));
+}
+
+// one work group per cluster, listing the brightest of the lights whose sphere of 
+// influence touches it
+void main(){
+    uvec3 c = gl_WorkGroupID;
+    uint base = (c.x + (c.y + c.z * cluster_grid_y) * cluster_grid_x) * (max_cluster_lights + 1);
+
+    vec2 grid = vec2(cluster_grid_x, cluster_grid_y);
+    vec2 lo = vec2(c.xy) / grid;
+    vec2 hi = vec2(c.xy + 1) / grid;
+    vec2 depth = vec2(slice_depth(c.z), slice_depth(c.z + 1));
+
+    vec3 lower = vec3(max_float);
+    vec3 upper = vec3(-max_float);
+    for (int i = 0; i < 8; i++){
+        vec3 v = eye_position(
+            vec2((i & 1) == 0 ? lo.x : hi.x, (i & 2) == 0 ? lo.y : hi.y),
+            (i & 4) == 0 ? depth.x : depth.y
+        );
+        lower = min(lower, v);
+        upper = max(upper, v);
+    }
+
+    mat3 view = transpose(mat3(pc.eye_transform));
+    vec3 eye = pc.eye_transform[3].xyz;
+    uint n = gl_WorkGroupSize.x * gl_WorkGroupSize.y;
+
+    for (uint i = gl_LocalInvocationIndex; i < buckets; i += n){
+        histogram[i] = 0;
+    }
+    barrier();
+
+    for (uint i = gl_LocalInvocationIndex; i < uint(lights.data.length()); i += n){
+        int bucket = get_bucket(lights.data[i], lower, upper, view, eye);
+        if (bucket >= 0){
+            atomicAdd(histogram[bucket], 1u);
+        }
+    }
+    barrier();
+
+    // every bucket above the threshold fits, and the threshold bucket fills what is left
+    if (gl_LocalInvocationIndex == 0){
+        // with no threshold every light fits
+        uint total = 0;
+        threshold = -1;
+        for (int i = int(buckets) - 1; i >= 0; i--){
+            if (total + histogram[i] > max_cluster_lights){
+                threshold = i;
+                break;
+            }
+            total += histogram[i];
+        }
+
+        above = total;
+        count = 0;
+        partial = 0;
+
+        // lights that did not fit are counted for the profiler, past the end of the clusters
+        uint overflow = 0;
+        for (int i = 0; i <= threshold; i++){
+            overflow += histogram[i];
+        }
+        overflow -= min(overflow, max_cluster_lights - total);
+        if (overflow > 0){
+            atomicAdd(clusters.data[cluster_grid_x * cluster_grid_y * cluster_grid_z * (max_cluster_lights + 1)], overflow);
+        }
+    }
+    barrier();
+
+    // the order lights arrive in only decides which of the threshold bucket are kept, and 
+    // those are within half an octave of each other
+    for (uint i = gl_LocalInvocationIndex; i < uint(lights.data.length()); i += n){
+        int bucket = get_bucket(lights.data[i], lower, upper, view, eye);
+
+        if (bucket > threshold){
+            clusters.data[base + 1 + atomicAdd(count, 1u)] = i;
+        } else if (bucket == threshold){
+            uint k = above + atomicAdd(partial, 1u);
+            if (k < max_cluster_lights){
+                clusters.data[base + 1 + k] = i;
+            }
+        }
+    }
+    barrier();
+
+    if (gl_LocalInvocationIndex == 0){
+        clusters.data[base] = min(above + partial, max_cluster_lights);
+    }
+}
@@ -8,8 +8,8 @@ struct ray_t {
 struct substance_t {
     float near;
     float far;
-    float _1;
-    float _2;
+    uint shape;
+    uint colour;
 
     vec3 radius;
     uint id;
@@ -35,7 +35,7 @@ struct request_t {
 
     uint index;
     uint hash;
-    uint substanceID;
+    uint shapeID;
     uint status;
 };
 
@@ -44,7 +44,7 @@ struct light_t {
     uint id;
 
     vec3 colour;
-    uint index;
+    uint version;
 };
 
 struct patch_t {
@@ -54,12 +54,51 @@ struct patch_t {
     uint normal;
 };
 
-layout (local_size_x = 32, local_size_y = 32) in;
+// visibility of one version of a light at the eight corners of a cell, packed as unorm8
+struct shadow_t {
+    uint hash;
+    uint version;
+    uvec2 visibility;
+};
+
+struct shadow_request_t {
+    vec3 position;
+    float size;
+
+    uint light;
+    uint version;
+    uint substance;
+    uint hash;
+};
+
+// see bvh_t, inner nodes have no substance
+struct node_t {
+    vec3 lower;
+    uint escape;
+
+    vec3 upper;
+    uint substance;
+};
+
+// specialised by the renderer, see renderer_t::specialisation_t
+layout (local_size_x_id = 0, local_size_y_id = 1) in;
+layout (constant_id = 2) const int max_steps = 128;
+layout (constant_id = 3) const int max_hash_retries = 10;
+layout (constant_id = 4) const uint cone_tile_size = 8;
+layout (constant_id = 5) const uint cone_levels = 2;
+layout (constant_id = 6) const uint cluster_grid_x = 16;
+layout (constant_id = 7) const uint cluster_grid_y = 9;
+layout (constant_id = 8) const uint cluster_grid_z = 24;
+layout (constant_id = 9) const uint max_cluster_lights = 64;
+layout (constant_id = 10) const float cluster_near = 1.0;
+layout (constant_id = 12) const float shadow_threshold = 0.015625;
+layout (constant_id = 13) const uint shadow_cell_scale = 2;
+layout (constant_id = 14) const bool is_shadow_pass = false;
+layout (constant_id = 15) const uint patch_ways = 4;
 
 const int work_group_size = int(gl_WorkGroupSize.x * gl_WorkGroupSize.y);
 const float sqrt3 = 1.73205080757;
-const int max_steps = 128;
-const int max_hash_retries = 10;
+const float max_float = 3.402823466e38;
 
 const ivec3 p1 = ivec3(
     904601,
@@ -84,7 +123,8 @@ const uvec4 vertex_masks[2] = {
     uvec4(1 << 20, 1 << 21, 1 << 22, 1 << 23)
 };
 
-layout (binding = 10) uniform writeonly image2D render_texture;
+// raymarched at the render size, and reconstructed into the render texture by reconstruct.glsl
+layout (binding = 13, rgba16f) uniform writeonly image2D sample_texture;
 layout (binding = 11) uniform sampler3D normal_texture;
 layout (binding = 12) uniform sampler3D colour_texture;
 
@@ -104,29 +144,33 @@ layout( push_constant ) uniform push_constants {
     uint texture_depth;
     uint global_patch_pool_size;
     float epsilon;
+
+    uvec2 render_size;
+    vec2 jitter;
 } pc;
 
 layout (binding = 1) buffer patch_buffer     { patch_t     data[]; } patches;
 layout (binding = 2) buffer request_buffer   { request_t   data[]; } requests;
-layout (binding = 3) buffer lights_buffer    { light_t     data[]; } lights_global;
+layout (binding = 3) buffer lights_buffer    { light_t     data[]; } lights;
 layout (binding = 4) buffer substance_buffer { substance_t data[]; } substance;
 layout (binding = 5) buffer pointer_buffer   { uint        data[]; } pointers;
-layout (binding = 6) buffer frustum_buffer   { vec2        data[]; } frustum;
-layout (binding = 7) buffer lighting_buffer  { vec4        data[]; } lighting;
-
-shared substance_t substances[gl_WorkGroupSize.x];
-shared uint substances_size;
-
-shared light_t lights[gl_WorkGroupSize.x];
-shared uint lights_size;
+layout (binding = 6) buffer patch_age_buffer { uint        data[]; } ages;
+layout (binding = 7) buffer bvh_buffer       { node_t      data[]; } bvh;
+layout (binding = 8) buffer cluster_buffer   { uint        data[]; } clusters;
+layout (binding = 9) buffer shadow_buffer    { shadow_t    data[]; } shadows;
+layout (binding = 15) buffer shadow_request_buffer { shadow_request_t data[]; } shadow_requests;
 
 shared vec4 workspace[work_group_size];
+shared float cones[work_group_size];
+shared float corners[8];
+shared bool is_complete;
 shared bool test;
 
+// samples span the whole image at any render size, offset by a sub-sample jitter
 vec2 uv(vec2 xy){
-    vec2 uv = xy / (gl_NumWorkGroups.xy * gl_WorkGroupSize.xy);
+    vec2 uv = (xy + pc.jitter) / pc.render_size;
     uv = uv * 2.0 - 1.0;
-    uv.y *= -float(gl_NumWorkGroups.y) / gl_NumWorkGroups.x;
+    uv.y *= -float(pc.window_size.y) / pc.window_size.x;
     return uv;
 }
 
@@ -136,7 +180,7 @@ vec3 get_ray_direction(vec2 xy){
 
 int expected_order(vec3 x){
     float dist = length(pc.eye_transform[3].xyz - x);
-    float centre = length(uv(gl_GlobalInvocationID.xy));
+    float centre = is_shadow_pass ? 0 : length(uv(gl_GlobalInvocationID.xy));
     const vec2 ks = vec2(1, 2);
     return 10 + int(dot(vec2(dist, centre), ks));
 }
@@ -145,28 +189,65 @@ uint work_group_offset(){
     return (gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x) * work_group_size;
 }
 
-patch_t get_patch(vec3 x, int order, uint subID, inout intersection_t intersection, inout request_t request, out uint hash){
+uint patch_hash(ivec3 x_grid, uint shapeID, int order){
+    ivec3 x_hash = x_grid * p1 + p2;
+    ivec2 os_hash = ivec2(shapeID, order) * p3.xy + p3.yz;
+    return x_hash.x ^ x_hash.y ^ x_hash.z ^ os_hash.x ^ os_hash.y;
+}
+
+// the pool is split into buckets of patch_ways slots, and a patch may be in any slot of
+// the bucket its hash falls in. returns the slot it is in, stamping it as used this frame, 
+// or ~0 with the least recently used slot of the bucket as the victim to replace
+uint find_patch(uint hash, out uint victim){
+    uint bucket = hash % (pc.global_patch_pool_size / patch_ways) * patch_ways;
+    uint oldest = ~0u;
+    victim = bucket;
+
+    for (uint slot = bucket; slot < bucket + patch_ways; slot++){
+        uint age = ages.data[slot];
+        if (patches.data[slot].hash == hash){
+            if (age != pc.current_frame){
+                ages.data[slot] = pc.current_frame;
+            }
+            return slot;
+        }
+
+        if (age < oldest){
+            oldest = age;
+            victim = slot;
+        }
+    }
+
+    return ~0u;
+}
+
+patch_t get_patch(vec3 x, int order, uint shapeID, inout intersection_t intersection, inout request_t request, out uint hash){
     float size = pc.epsilon * order * 2;
     vec3 x_scaled = x / size;
     ivec3 x_grid = ivec3(floor(x_scaled));
 
-    ivec3 x_hash = x_grid * p1 + p2;
-    ivec2 os_hash = ivec2(subID, order) * p3.xy + p3.yz;
-    hash = x_hash.x ^ x_hash.y ^ x_hash.z ^ os_hash.x ^ os_hash.y;
+    hash = patch_hash(x_grid, shapeID, order);
 
-    // calculate some useful variables for doing lookups
+    // calculate some useful variables for doing lookups, where the shared copy of a patch
+    // holds the slot it was loaded from in place of its contents
     uint index = hash % work_group_size;
-    uint global_index = hash % pc.global_patch_pool_size;
 
     vec3 cell_position = x_grid * size;
     uvec4 udata = floatBitsToUint(workspace[index]);
     patch_t patch_ =  patch_t(udata.x, udata.y, workspace[index].z, udata.w);
+    uint global_index = udata.x;
 
     if (patch_.hash != hash) {
-        pointers.data[index + work_group_offset()] = global_index; 
+        uint victim;
+        uint slot = find_patch(hash, victim);
+        global_index = slot == ~0u ? victim : slot;
+
+        if (!is_shadow_pass){
+            pointers.data[index + work_group_offset()] = global_index; 
+        }
         patch_ = patches.data[global_index];
         if (patch_.hash != hash){
-            request = request_t(cell_position, size / 2, global_index, hash, subID, 1);
+            request = request_t(cell_position, size / 2, global_index, hash, shapeID, 1);
         }
     }
 
@@ -201,7 +282,7 @@ float phi(ray_t global_r, substance_t sub, inout intersection_t intersection, in
     
     if (inside_aabb){
         for (int tries = 0; tries < max_hash_retries && hash != patch_.hash; tries++){
-            patch_ = get_patch(r.x, order + tries, sub.id, intersection, request, hash);
+            patch_ = get_patch(r.x, order + tries, sub.shape, intersection, request, hash);
         }
     }
     
@@ -220,23 +301,162 @@ float phi(ray_t global_r, substance_t sub, inout intersection_t intersection, in
     return mix(phi_aabb, phi, inside_aabb);
 }
 
-intersection_t raycast(ray_t r, inout request_t request){
+// lower bound on the distance from x to a substance, which unlike phi makes no requests.
+// outside the bounds this is the distance to the box, and inside it the phi of a resident
+// patch less the distance to the centre it was sampled at, or zero if none is resident
+float phi_bound(vec3 x, substance_t sub){
+    vec3 local = (inverse(sub.transform) * vec4(x, 1)).xyz;
+    float box = length(max(abs(local) - sub.radius, 0));
+    if (box > 0){
+        return box;
+    }
+
+    int order = expected_order(local);
+    for (int tries = 0; tries < max_hash_retries; tries++){
+        float size = pc.epsilon * (order + tries) * 2;
+        ivec3 x_grid = ivec3(floor(local / size));
+        uint hash = patch_hash(x_grid, sub.shape, order + tries);
+
+        uint index = hash % work_group_size;
+        float phi = workspace[index].z;
+        if (floatBitsToUint(workspace[index].y) != hash){
+            uint victim;
+            uint slot = find_patch(hash, victim);
+            phi = slot == ~0u ? -max_float : patches.data[slot].phi;
+        }
+
+        if (phi > -max_float){
+            return max(0, phi - length(x_grid * size + size / 2 - local));
+        }
+    }
+
+    return 0;
+}
+
+// smallest lower bound over every substance but the one ignored, skipping nodes further 
+// away than the nearest bound so far
+float scene_bound(vec3 x, uint ignore){
+    float p = pc.render_distance;
+
+    for (uint node = 0; node != ~0;){
+        node_t n = bvh.data[node];
+        float box = length(max(max(n.lower - x, x - n.upper), 0));
+
+        bool is_reached = box < p;
+        if (is_reached && n.substance != ~0){
+            substance_t sub = substance.data[n.substance];
+            p = sub.id == ignore ? p : min(p, phi_bound(x, sub));
+        }
+
+        node = is_reached && n.substance == ~0 ? node + 1 : n.escape;
+    }
+
+    return p;
+}
+
+// marches a cone from the eye through the pixels lo to hi, from a distance known to be
+// clear, and returns how far the whole cone is clear of every substance
+float conecast(vec2 lo, vec2 hi, float t){
+    vec3 eye = pc.eye_transform[3].xyz;
+    vec3 d = get_ray_direction((lo + hi) / 2);
+
+    // tangent of the widest angle between the axis and the corner rays
+    vec4 c = vec4(
+        dot(d, get_ray_direction(lo)),
+        dot(d, get_ray_direction(vec2(hi.x, lo.y))),
+        dot(d, get_ray_direction(hi)),
+        dot(d, get_ray_direction(vec2(lo.x, hi.y)))
+    );
+    vec4 tangents = sqrt(max(1 - c * c, 0)) / c;
+    float k = max(max(tangents.x, tangents.y), max(tangents.z, tangents.w));
+
+    for (int steps = 0; steps < max_steps && t < pc.render_distance; steps++){
+        float p = scene_bound(eye + d * t, ~0u);
+
+        // the furthest step after which the sphere of the cone still fits within p
+        float step = (p - t * k) / (1 + k);
+        if (step < pc.epsilon){
+            break;
+        }
+        t += step;
+    }
+
+    return min(t, pc.render_distance);
+}
+
+// conservative start distance of each pixel, marched over tiles of cone_tile_size and
+// refined by halving the tiles for each level, each seeded by the tile that contains it
+float seed_distance(){
+    uvec2 local = gl_LocalInvocationID.xy;
+    uvec2 offset = gl_WorkGroupID.xy * gl_WorkGroupSize.xy;
+    float t = 0;
+
+    for (uint level = 0; level < cone_levels; level++){
+        uint tile = max(cone_tile_size >> level, 1u);
+        uvec2 origin = local / tile * tile;
+
+        if (level > 0){
+            uvec2 parent = local / (tile * 2) * (tile * 2);
+            t = cones[parent.x + parent.y * gl_WorkGroupSize.x];
+        }
+        barrier();
+
+        if (local == origin){
+            uvec2 hi = origin + min(uvec2(tile), gl_WorkGroupSize.xy - origin) - 1;
+            cones[local.x + local.y * gl_WorkGroupSize.x] = conecast(vec2(offset + origin), vec2(offset + hi), t);
+        }
+        barrier();
+    }
+
+    if (cone_levels == 0){
+        return 0;
+    }
+
+    uint tile = max(cone_tile_size >> (cone_levels - 1), 1u);
+    uvec2 origin = local / tile * tile;
+    return cones[origin.x + origin.y * gl_WorkGroupSize.x];
+}
+
+// smallest phi over every substance the ray reaches. phi is never less than the distance
+// along the ray to a substance's bounds, so nodes entered beyond the nearest phi so far are
+// skipped, as are those behind the ray. stops at the first hit, as intersection is left
+// describing the last substance evaluated
+float scene_phi(ray_t r, inout intersection_t i, inout request_t request){
+    vec3 inv_d = 1.0 / r.d;
+    float p = pc.render_distance;
+
+    for (uint node = 0; node != ~0 && !i.hit;){
+        node_t n = bvh.data[node];
+        vec3 a = (n.lower - r.x) * inv_d;
+        vec3 b = (n.upper - r.x) * inv_d;
+        vec3 entries = min(a, b);
+        vec3 exits = max(a, b);
+
+        float entry = max(max(entries.x, entries.y), entries.z);
+        float exit = min(min(exits.x, exits.y), exits.z);
+
+        bool is_reached = entry <= exit && exit >= 0 && entry < p;
+        if (is_reached && n.substance != ~0){
+            p = min(p, phi(r, substance.data[n.substance], i, request));
+            i.hit = p < pc.epsilon;
+        }
+
+        node = is_reached && n.substance == ~0 ? node + 1 : n.escape;
+    }
+
+    return p;
+}
+
+intersection_t raycast(ray_t r, float start, inout request_t request){
     uint steps;
     intersection_t i;
     
     i.hit = false;
-    i.distance = 0;
-
-    uint min_substanceID = 0;
+    i.distance = start;
+    r.x += r.d * start;
 
     for (steps = 0; !i.hit && steps < max_steps && i.distance < pc.render_distance; steps++){
-        float p = pc.render_distance;
-        min_substanceID += int(i.distance > substances[min_substanceID].far);
-
-        for (uint substanceID = min_substanceID; !i.hit && substanceID < substances_size; substanceID++){
-            p = min(p, phi(r, substances[substanceID], i, request));
-            i.hit = i.hit || p < pc.epsilon;
-        }
+        float p = scene_phi(r, i, request);
         r.x += r.d * p;
         i.distance += p;
     }
@@ -245,48 +465,78 @@ intersection_t raycast(ray_t r, inout request_t request){
     return i;
 }
 
-float shadow_cast(vec3 l, uint light_i, intersection_t geometry_i, inout request_t request){
-    uint steps;
-    ray_t r = ray_t(l, normalize(geometry_i.x - l));
+// visibility of a light from a point, from 0 in full shadow to 1. marched once from the
+// light, keeping the smallest ratio of the clearance around the ray to the distance left to
+// the point, which is how much of a cone from the point towards the light is unoccluded.
+// the substance the point lies on is ignored, as its patches are too coarse to shadow itself
+float shadow_cast(vec3 l, vec3 x, uint substance_id, inout request_t request){
+    const float softness = 16;
+
+    float dist = length(x - l);
+    ray_t r = ray_t(l, (x - l) / dist);
 
     intersection_t shadow_i;
     shadow_i.substance.id = ~0;
     shadow_i.hit = false;  
     shadow_i.distance = 0;
 
-    for (steps = 0; !shadow_i.hit && steps < max_steps && shadow_i.distance < pc.render_distance; steps++){
-        float p = pc.render_distance;
+    float visibility = 1;
+    for (int steps = 0; !shadow_i.hit && steps < max_steps && shadow_i.distance < dist; steps++){
+        float clearance = scene_bound(r.x, substance_id);
+        visibility = min(visibility, softness * clearance / (dist - shadow_i.distance));
 
-        for (uint i = 0; !shadow_i.hit && i < substances_size; i++){
-            p = min(p, phi(r, substances[i], shadow_i, request));
-            shadow_i.hit = shadow_i.hit || p < pc.epsilon;
-        }
+        float p = scene_phi(r, shadow_i, request);
         r.x += r.d * p;
         shadow_i.distance += p;
     }
 
-    float dist = length(geometry_i.x - l);
-
     bool is_clear = 
-        shadow_i.substance.id == geometry_i.substance.id || 
+        shadow_i.substance.id == substance_id || 
         shadow_i.substance.id == ~0 ||
         shadow_i.distance > dist;
 
-    return float(is_clear);
+    return is_clear ? clamp(visibility, 0, 1) : 0;
+}
+
+uint shadow_hash(ivec3 x_grid, uint light_i, uint substance_id, int order){
+    return patch_hash(x_grid, light_i, order) ^ (substance_id * uint(p1.x) + uint(p2.y));
+}
+
+// visibility of a light from a point on a substance, interpolated between the corners of
+// its cell when they are cached for this version of the light. otherwise it is marched
+// here, and the cell is requested for the shadow pass to fill in
+float get_shadow(uint light_i, light_t light, vec3 x, uint substance_id, inout request_t request){
+    int order = expected_order(x);
+    float size = pc.epsilon * order * 2 * shadow_cell_scale;
+    vec3 x_scaled = x / size;
+    ivec3 x_grid = ivec3(floor(x_scaled));
+
+    uint hash = shadow_hash(x_grid, light_i, substance_id, order);
+    shadow_t shadow = shadows.data[hash % uint(shadows.data.length())];
+
+    if (shadow.hash == hash && shadow.version == light.version){
+        vec3 a = x_scaled - x_grid;
+        vec4 v = mix(unpackUnorm4x8(shadow.visibility.x), unpackUnorm4x8(shadow.visibility.y), a.z);
+        vec2 w = mix(v.xz, v.yw, a.x);
+        return mix(w.x, w.y, a.y);
+    }
+
+    shadow_requests.data[hash % uint(shadow_requests.data.length())] = shadow_request_t(
+        x_grid * size, size, light_i, light.version, substance_id, hash
+    );
+
+    return shadow_cast(light.x, x, substance_id, request);
 }
 
 vec3 light(uint light_i, intersection_t i, vec3 n, inout request_t request){
     const float shininess = 16;
 
-    light_t light = lights[light_i];
+    light_t light = lights.data[light_i];
 
     // attenuation
     vec3 dist = light.x - i.x;
     float attenuation = 1.0 / dot(dist, dist);
 
-    //shadows
-    float shadow = shadow_cast(light.x, light_i, i, request);
-
     //diffuse
     vec3 l = normalize(light.x - i.x);
     float d = 0.75 * max(pc.epsilon, dot(l, n));
@@ -297,76 +547,29 @@ vec3 light(uint light_i, intersection_t i, vec3 n, inout request_t request){
     vec3 h = normalize(l + v);
     float s = 0.4 * pow(max(dot(h, n), 0.0), shininess);
 
-    return (d + s) * attenuation * shadow * light.colour;
-}
+    vec3 colour = (d + s) * attenuation * light.colour;
 
-uvec4 reduce_to_fit(uint i, bvec4 hits, out uvec4 totals){
-    vec4 x;
-    barrier();
-    workspace[i] = uvec4(hits);
-    barrier();
+    //shadows, only marched for lights that would noticeably change the pixel
+    bool is_shadowed = max(colour.r, max(colour.g, colour.b)) > shadow_threshold;
+    float shadow = is_shadowed ? get_shadow(light_i, light, i.x, i.substance.id, request) : 1.0;
 
-    if ((i &   1) != 0) workspace[i] += workspace[i &   ~1      ];    
-    barrier();
-    if ((i &   2) != 0) workspace[i] += workspace[i &   ~2 |   1];    
-    barrier();
-    if ((i &   4) != 0) workspace[i] += workspace[i &   ~4 |   3];    
-    barrier();
-    if ((i &   8) != 0) workspace[i] += workspace[i &   ~8 |   7];    
-    barrier();
-    if ((i &  16) != 0) workspace[i] += workspace[i &  ~16 |  15];    
-    barrier();
-    if ((i &  32) != 0) workspace[i] += workspace[i &  ~32 |  31];    
-    barrier();
-    if ((i &  64) != 0) workspace[i] += workspace[i &  ~64 |  63];    
-    barrier();
-    if ((i & 128) != 0) workspace[i] += workspace[i & ~128 | 127];    
-    barrier();
-    if ((i & 256) != 0) workspace[i] += workspace[i & ~256 | 255];    
-    barrier();
-    if ((i & 512) != 0) workspace[i] += workspace[           511];    
-    barrier();
-
-    totals = min(uvec4(workspace[1023]), gl_WorkGroupSize.xxxx);
-    barrier();
-
-    bvec4 mask = lessThanEqual(workspace[i], gl_WorkGroupSize.xxxx) && hits;
-    barrier();
-
-    uvec4 result = uvec4(workspace[i]);
-    barrier();
-
-    return mix(uvec4(~0), result - 1, mask);
+    return colour * shadow;
 }
 
-vec4 reduce_min(uint i, vec4 value){
-    barrier();
-    workspace[i] = value;
-    barrier();
+// the cluster a point seen through a pixel falls into, see cluster.glsl
+uint get_cluster(vec2 xy, vec3 x){
+    vec2 f = (xy + pc.jitter) / pc.render_size;
+    float z = dot(pc.eye_transform[2].xyz, x - pc.eye_transform[3].xyz);
 
-    if ((i &   1) == 0) workspace[i] = min(workspace[i], workspace[i +   1]);
-    barrier();
-    if ((i &   3) == 0) workspace[i] = min(workspace[i], workspace[i +   2]);
-    barrier();
-    if ((i &   7) == 0) workspace[i] = min(workspace[i], workspace[i +   4]);
-    barrier();
-    if ((i &  15) == 0) workspace[i] = min(workspace[i], workspace[i +   8]);
-    barrier();
-    if ((i &  31) == 0) workspace[i] = min(workspace[i], workspace[i +  16]);
-    barrier();
-    if ((i &  63) == 0) workspace[i] = min(workspace[i], workspace[i +  32]);
-    barrier();
-    if ((i & 127) == 0) workspace[i] = min(workspace[i], workspace[i +  64]);
-    barrier();
-    if ((i & 255) == 0) workspace[i] = min(workspace[i], workspace[i + 128]);
-    barrier();
-    if ((i & 511) == 0) workspace[i] = min(workspace[i], workspace[i + 256]);
-    barrier();
-    
-    return min(workspace[0], workspace[512]);
+    float alpha = log(z / cluster_near) / log(pc.render_distance / cluster_near);
+    uint k = z <= cluster_near ? 0u : 1u + uint(alpha * (cluster_grid_z - 1));
+
+    uvec3 grid = uvec3(cluster_grid_x, cluster_grid_y, cluster_grid_z);
+    uvec3 c = min(uvec3(uvec2(f * vec2(grid.xy)), k), grid - 1);
+    return c.x + (c.y + c.z * cluster_grid_y) * cluster_grid_x;
 }
 
-void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
+void render(){
     request_t request;
     request.status = 0;
 
@@ -374,40 +577,9 @@ void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
     vec3 d = get_ray_direction(gl_GlobalInvocationID.xy);
 
     ray_t r = ray_t(rx, d);
-    intersection_t intersection = raycast(r, request);
-
-    barrier();
-
-    float dist = length(lights[gl_LocalInvocationID.x].x - lights[gl_LocalInvocationID.y].x);
-    bool is_valid = 
-        lights[gl_LocalInvocationID.x].id != ~0 && lights[gl_LocalInvocationID.y].id != ~0 &&
-        max(gl_LocalInvocationID.x, gl_LocalInvocationID.y) < lights_size;
-        
-    vec4 result = reduce_min(i, mix(
-        vec4(pc.render_distance), 
-        vec4(intersection.distance, -intersection.distance, -dist, 0), 
-        bvec4(intersection.hit, intersection.hit, is_valid, false)
-    ));
-    barrier();
-
-    if (dist == -result.z && is_valid){
-        lighting.data[j] = vec4(
-            (lights[gl_LocalInvocationID.x].x + lights[gl_LocalInvocationID.y].x) / 2, 
-            dist / 2
-        );
-    }
-    
-    barrier();
-    
-    frustum.data[j] = vec2(result.x, -result.y);
+    float start = seed_distance();
+    intersection_t intersection = raycast(r, start, request);
 
-    barrier();
-
-    substances_size = shadow_size;
-    if (shadow_index != ~0){
-        substances[shadow_index] = s;
-    }
-    
     // find texture coordinate
     uint k = intersection.global_index;
     vec3 t = intersection.alpha * intersection.cell_radius * 2 + intersection.cell_radius;
@@ -427,143 +599,108 @@ void render(uint i, uint j, substance_t s, uint shadow_index, uint shadow_size){
     // ambient
     vec3 lighting = vec3(0.25, 0.25, 0.25);
 
-    for (uint light_i = 0; light_i < lights_size; light_i++){
-        lighting += light(light_i, intersection, n, request);
+    // only the lights listed in the cluster of the hit can reach it
+    uint base = get_cluster(gl_GlobalInvocationID.xy, intersection.x) * (max_cluster_lights + 1);
+    uint count = intersection.hit ? clusters.data[base] : 0;
+
+    for (uint light_i = 0; light_i < count; light_i++){
+        lighting += light(clusters.data[base + 1 + light_i], intersection, n, request);
     }
 
     const vec3 sky = vec3(0.5, 0.7, 0.9);
-    vec3 hit_colour = texture(colour_texture, t).xyz * lighting;
+    vec3 albedo = texture(colour_texture, t).xyz * unpackUnorm4x8(intersection.substance.colour).xyz;
+    vec3 hit_colour = albedo * lighting;
 
-    vec3 image_colour = mix(sky, hit_colour, intersection.hit);
+    vec3 image_colour = mix(sky, hit_colour, bvec3(intersection.hit));
 
     // debug line:
     // image_colour = mix(image_colour, vec3(0, 1, 0), test);
 
-    imageStore(render_texture, ivec2(gl_GlobalInvocationID.xy), vec4(image_colour, 1));
+    // the distance along the ray is kept for reprojection
+    float depth = mix(pc.render_distance, intersection.distance, intersection.hit);
+    imageStore(sample_texture, ivec2(gl_GlobalInvocationID.xy), vec4(image_colour, depth));
 
     if (request.status != 0){
         requests.data[request.hash % pc.number_of_calls] = request;
     }
 }
 
-bool is_light_visible(light_t l, float near, float far, mat4x3 normals){ 
-    vec3 light = l.x - pc.eye_transform[3].xyz;
-    float r = sqrt(length(l.colour) / pc.epsilon);
-
-    vec4 phis = transpose(normals) * light;
-    bool frustum_hit = all(lessThanEqual(phis, vec4(r)));
-
-    float depth = dot(pc.eye_transform[2].xyz, light);
-    bool depth_hit = depth >= near - r  && depth <= far + r;
-
-    return l.id != ~0 && frustum_hit && depth_hit;
-}
-
-bool is_substance_visible(substance_t sub, mat4x3 normals_global){
-    mat4 inv = inverse(sub.transform);
-    mat4x3 normals = mat3(inv) * normals_global;
-    vec3 eye = (inv * pc.eye_transform[3]).xyz;
-    vec4 ds = transpose(normals) * eye;
-
-    vec4 phis = vec4(
-        dot(abs(normals[0]), vec3(sub.radius)),
-        dot(abs(normals[1]), vec3(sub.radius)),
-        dot(abs(normals[2]), vec3(sub.radius)),
-        dot(abs(normals[3]), vec3(sub.radius))
-    );
-
-    vec3 f = mat3(sub.transform) * get_ray_direction(gl_WorkGroupID.xy * gl_WorkGroupSize.xy + gl_WorkGroupSize.xy / 2);
-    
-    // TODO: fix this line
-    bool is_behind  = false;//all(greaterThan(sub.radius + eye * sign(f), vec3(0)));
-    bool is_eye_inside = false;//all(lessThanEqual(eye, sub.radius));
-
-    bool is_visible = 
-        sub.id != ~0 && sub.near < pc.render_distance && 
-        (all(greaterThan(phis, ds)) || is_eye_inside) && !is_behind;
-
-    
-
-    return is_visible;
+void prerender(uint i){
+    // load the patches this work group used last frame from global memory into shared
+    // memory, where they will likely be used again
+    uint slot = pointers.data[i + work_group_offset()];
+    patch_t data = patches.data[slot];
+    vec3 udata = uintBitsToFloat(uvec3(slot, data.hash, data.normal));
+    workspace[i] = vec4(udata.x, udata.y, data.phi, udata.z);
+    ages.data[slot] = pc.current_frame;
 }
 
-bool is_shadow_visible(substance_t s, float near, float far, vec3 lc, float lr){
-    vec3 eye = pc.eye_transform[3].xyz;
-    vec3 ed = get_ray_direction(gl_WorkGroupSize.xy * gl_WorkGroupID.xy + gl_WorkGroupSize.xy / 2);
-    vec3 ec = ed * (near + far) / 2;
-    float er = length(ed * far - ec);
-    ec += eye;
-
-    vec3 sc = s.transform[3].xyz;
-    float sr = length(s.radius);
-
-    vec3 d = normalize(lc - ec);
-    float alpha = dot(d, sc - ec) / length(lc - ec);
-    alpha = clamp(alpha, 0, 1);
+// one work group per requested cell, and one invocation per corner
+void fill_shadow(){
+    uint i = gl_LocalInvocationIndex;
+    shadow_request_t shadow_request = shadow_requests.data[gl_WorkGroupID.x];
 
-    vec3 c = mix(ec, lc, alpha);
-    float r = mix(er, lr, alpha);
+    // requests are written with plain stores by every invocation whose cell falls in the
+    // same slot, so a request may mix the fields of two cells. its hash is recomputed from
+    // the rest, as get_shadow computed it, to reject those
+    int order = int(round(shadow_request.size / (pc.epsilon * 2 * shadow_cell_scale)));
+    ivec3 x_grid = ivec3(round(shadow_request.position / shadow_request.size));
+    uint hash = shadow_hash(x_grid, shadow_request.light, shadow_request.substance, order);
 
-    return s.id != ~0 && near < far && length(sc - c) < r + sr;
-}
-
-void prerender(uint i, uint j, substance_t s, out uint shadow_index, out uint shadow_size){
-    mat4x3 rays = mat4x3(
-        get_ray_direction( gl_WorkGroupID.xy                * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(1, 0)) * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(1, 1)) * gl_WorkGroupSize.xy),
-        get_ray_direction((gl_WorkGroupID.xy + uvec2(0, 1)) * gl_WorkGroupSize.xy)
-    );
+    // the light may have changed, or moved in the light list, since the cell was requested
+    bool is_valid = 
+        shadow_request.version != 0 && 
+        shadow_request.hash == hash &&
+        shadow_request.light < uint(lights.data.length()) &&
+        lights.data[shadow_request.light].version == shadow_request.version;
 
-    mat4x3 normals = mat4x3(
-        cross(rays[1], rays[0]), cross(rays[2], rays[1]),
-        cross(rays[3], rays[2]), cross(rays[0], rays[3])
-    );
+    if (!is_valid){
+        return;
+    }
 
-    // load shit
-    bool directly_visible = is_substance_visible(s, normals);
-    light_t l = lights_global.data[i];
-    vec2 f = frustum.data[j].xy;
-    vec4 li = lighting.data[j];
+    // nothing is shared with the raymarch, so patches are all read from global memory
+    workspace[i] = vec4(0);
+    if (i == 0){
+        is_complete = true;
+    }
     barrier();
-    bool light_visible = is_light_visible(l, f.x, f.y, normals);
-    bool shadow_visible = is_shadow_visible(s, f.x, f.y, li.xyz, li.w);
 
-   
-    // visibility check on substances and load into shared memory
-    barrier();
-    bvec4 hits = bvec4(directly_visible, light_visible, shadow_visible, false);
-    uvec4 totals;
-    uvec4 indices = reduce_to_fit(i, hits, totals);
+    request_t request;
+    request.status = 0;
 
-    substances_size = totals.x;
-    if (indices.x != ~0){
-        substances[indices.x] = s;
-    }
+    vec3 x = shadow_request.position + vec3(i & 1, (i >> 1) & 1, i >> 2) * shadow_request.size;
+    corners[i] = shadow_cast(lights.data[shadow_request.light].x, x, shadow_request.substance, request);
 
-    lights_size = totals.y;
-    if (indices.y != ~0){
-        lights[indices.y] = l;
+    // marching through patches that are not resident yet would cache shadows that are not there
+    if (request.status != 0){
+        is_complete = false;
+        requests.data[request.hash % pc.number_of_calls] = request;
     }
+    barrier();
 
-    shadow_index = indices.z;
-    shadow_size = totals.z;
-
-    // load patches from global memory into shared memory
-    patch_t data = patches.data[pointers.data[i]];
-    vec3 udata = uintBitsToFloat(uvec3(data.contents, data.hash, data.normal));
-    workspace[i] = vec4(udata.x, udata.y, data.phi, udata.z);
+    if (i == 0){
+        if (is_complete){
+            shadows.data[shadow_request.hash % uint(shadows.data.length())] = shadow_t(
+                shadow_request.hash, shadow_request.version, uvec2(
+                    packUnorm4x8(vec4(corners[0], corners[1], corners[2], corners[3])),
+                    packUnorm4x8(vec4(corners[4], corners[5], corners[6], corners[7]))
+                )
+            );
+        }
+        shadow_requests.data[gl_WorkGroupID.x].version = 0;
+    }
 }
 
 void main(){
+    if (is_shadow_pass){
+        fill_shadow();
+        return;
+    }
+
     test = false;
-    uint i = gl_LocalInvocationID.x + gl_LocalInvocationID.y * gl_WorkGroupSize.x;
-    uint j = gl_WorkGroupID.x + gl_WorkGroupID.y * gl_NumWorkGroups.x;
-    
-    substance_t s = substance.data[i];
-    uint shadow_index, shadow_size;
-    prerender(i, j, s, shadow_index, shadow_size);
+
+    prerender(gl_LocalInvocationIndex);
 
     barrier();
-    render(i, j, s, shadow_index, shadow_size);
+    render();
 }
@@ -0,0 +1,78 @@
+#version 450
+
+layout (local_size_x = 8, local_size_y = 8) in;
+
+layout (binding = 10, rgba8) uniform writeonly image2D render_texture;
+layout (binding = 13, rgba16f) uniform readonly image2D sample_texture;
+layout (binding = 14, rgba8) uniform readonly image2D history_texture;
+
+layout( push_constant ) uniform push_constants {
+    // from the current eye space to the previous one
+    mat4 reprojection;
+
+    uvec2 size;
+    uvec2 render_size;
+
+    vec2 jitter;
+    float focal_depth;
+    float history_weight;
+} pc;
+
+vec2 uv(vec2 xy){
+    vec2 uv = xy / pc.size;
+    uv = uv * 2.0 - 1.0;
+    uv.y *= -float(pc.size.y) / pc.size.x;
+    return uv;
+}
+
+vec2 pixel(vec2 uv){
+    uv.y /= -float(pc.size.y) / pc.size.x;
+    return (uv + 1.0) / 2.0 * pc.size;
+}
+
+vec4 load_sample(ivec2 p){
+    return imageLoad(sample_texture, clamp(p, ivec2(0), ivec2(pc.render_size) - 1));
+}
+
+void main(){
+    ivec2 x = ivec2(gl_GlobalInvocationID.xy);
+    if (any(greaterThanEqual(gl_GlobalInvocationID.xy, pc.size))){
+        return;
+    }
+
+    // nearest new sample, in the coordinates of the raymarched image
+    vec2 c = vec2(x) * pc.render_size / pc.size - pc.jitter;
+    ivec2 p = clamp(ivec2(round(c)), ivec2(0), ivec2(pc.render_size) - 1);
+    vec4 s = load_sample(p);
+
+    // history is clamped to the colours around the new sample, which rejects most of 
+    // what was disoccluded or has changed shading since the last frame
+    vec3 lo = s.rgb;
+    vec3 hi = s.rgb;
+    for (int j = -1; j <= 1; j++){
+        for (int i = -1; i <= 1; i++){
+            vec3 n = load_sample(p + ivec2(i, j)).rgb;
+            lo = min(lo, n);
+            hi = max(hi, n);
+        }
+    }
+
+    // the point seen through this pixel, at the depth of the new sample, in the last frame
+    vec3 d = normalize(vec3(uv(vec2(x)), pc.focal_depth));
+    vec4 e = pc.reprojection * vec4(d * s.a, 1);
+    vec2 previous = pixel(e.xy / e.z * pc.focal_depth);
+
+    bool is_visible = 
+        e.z > 0 && 
+        all(greaterThanEqual(previous, vec2(0))) && all(lessThan(previous, vec2(pc.size)));
+
+    ivec2 h = clamp(ivec2(round(previous)), ivec2(0), ivec2(pc.size) - 1);
+    vec3 history = clamp(imageLoad(history_texture, h).rgb, lo, hi);
+
+    // new samples are trusted more the closer they are to this pixel
+    float dist = length(c - vec2(p));
+    float alpha = mix(1.0 - pc.history_weight, 1.0, clamp(1.0 - 2.0 * dist, 0.0, 1.0));
+    alpha = is_visible ? alpha : 1.0;
+
+    imageStore(render_texture, x, vec4(mix(history, s.rgb, alpha), 1));
+}
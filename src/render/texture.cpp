@@ -8,7 +8,7 @@ using namespace srph;
 
 texture_t::texture_t(
     uint32_t binding, device_t * device,
-    u32vec3_t size, VkImageUsageFlags usage,
+    u32vec3_t size, VkFormat format, VkImageUsageFlags usage,
     VkFormatFeatureFlagBits format_feature, VkDescriptorType descriptor_type
 ){    
     this->binding = binding;
@@ -16,7 +16,7 @@ texture_t::texture_t(
     this->descriptor_type = descriptor_type;
     extents = { size[0], size[1], size[2] };
 
-    format = VK_FORMAT_R8G8B8A8_UNORM;
+    this->format = format;
     layout = VK_IMAGE_LAYOUT_UNDEFINED;
 
     // create image
@@ -33,6 +33,14 @@ texture_t::texture_t(
     image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
     image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+    // written by the compute queue and read by the graphics queue without ownership transfers
+    uint32_t queue_families[] = { device->get_graphics_family(), device->get_compute_family() };
+    if (device->has_async_compute()){
+        image_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        image_create_info.queueFamilyIndexCount = 2;
+        image_create_info.pQueueFamilyIndices = queue_families;
+    }
+
     check_format_supported(
         device->get_physical_device(), format,
         image_create_info.tiling, format_feature 
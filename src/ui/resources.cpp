@@ -1,30 +1,26 @@
 #include "ui/resources.h"
 
 #include <fstream>
-#include <vector>
-#include <sstream>
-#include <iostream>
 
 using namespace srph;
 
 std::string resources::load_file(std::string filename){
-    std::ifstream file(filename);
-    std::stringstream buffer;
-    buffer << file.rdbuf();
+    std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
-    return  buffer.str();
+    if (!file.is_open()){
+	    return "";
+    }
 
-    // std::ifstream file(filename, std::ios::ate | std::ios::binary);
+    // read straight into the result rather than through a stream buffer copy
+    std::string buffer(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(&buffer[0], buffer.size());
 
-    // if (!file.is_open()){
-	//     return "";
-    // }
-
-    // size_t filesize = file.tellg();    
-    // std::vector<char> buffer(filesize);
+    return file ? buffer : "";
+}
 
-    // file.seekg(0);
-    // file.read(buffer.data(), filesize);
-    // file.close();
-    // return std::string(buffer.data());
+bool resources::save_file(std::string filename, const void * data, size_t size){
+    std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+    file.write(static_cast<const char *>(data), size);
+    return static_cast<bool>(file);
 }